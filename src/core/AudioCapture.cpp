@@ -5,6 +5,8 @@
  */
 
 #include "AudioCapture.h"
+#include "AudioResampler.h"
+#include "AudioUtils.h"
 #include "Logger.h"
 #include <chrono>
 #include <cmath>
@@ -110,59 +112,13 @@ private:
     std::atomic<bool> running_{true};
 };
 
-// Audio resampler for format conversion
-class AudioResampler {
-public:
-    AudioResampler(int input_rate, int output_rate, int channels)
-        : input_rate_(input_rate), output_rate_(output_rate), channels_(channels) {
-        ratio_ = static_cast<double>(output_rate) / input_rate;
-    }
-    
-    std::vector<float> resample(const float* input, size_t input_frames) {
-        if (input_rate_ == output_rate_) {
-            return std::vector<float>(input, input + input_frames * channels_);
-        }
-        
-        size_t output_frames = static_cast<size_t>(input_frames * ratio_);
-        std::vector<float> output(output_frames * channels_);
-        
-        for (size_t i = 0; i < output_frames; ++i) {
-            double src_pos = i / ratio_;
-            size_t src_idx = static_cast<size_t>(src_pos);
-            double frac = src_pos - src_idx;
-            
-            if (src_idx + 1 < input_frames) {
-                // Linear interpolation
-                for (int ch = 0; ch < channels_; ++ch) {
-                    float sample1 = input[src_idx * channels_ + ch];
-                    float sample2 = input[(src_idx + 1) * channels_ + ch];
-                    output[i * channels_ + ch] = sample1 + frac * (sample2 - sample1);
-                }
-            } else if (src_idx < input_frames) {
-                // Last sample
-                for (int ch = 0; ch < channels_; ++ch) {
-                    output[i * channels_ + ch] = input[src_idx * channels_ + ch];
-                }
-            }
-        }
-        
-        return output;
-    }
-    
-private:
-    int input_rate_;
-    int output_rate_;
-    int channels_;
-    double ratio_;
-};
-
-// Convert to mono if needed
-std::vector<float> convertToMono(const float* input, size_t frames, int channels) {
+// Average interleaved channels into output (frames samples)
+void convertToMono(const float* input, size_t frames, int channels, float* output) {
     if (channels == 1) {
-        return std::vector<float>(input, input + frames);
+        std::copy(input, input + frames, output);
+        return;
     }
     
-    std::vector<float> output(frames);
     for (size_t i = 0; i < frames; ++i) {
         float sum = 0.0f;
         for (int ch = 0; ch < channels; ++ch) {
@@ -170,7 +126,6 @@ std::vector<float> convertToMono(const float* input, size_t frames, int channels
         }
         output[i] = sum / channels;
     }
-    return output;
 }
 
 // Private implementation class
@@ -610,8 +565,10 @@ private:
             return false;
         }
         
-        // Create resampler
-        resampler_ = std::make_unique<AudioResampler>(native_sample_rate_, config_.sample_rate, native_channels_);
+        // Create resampler; channels are mixed down before it, so it runs on mono
+        if (native_sample_rate_ != config_.sample_rate) {
+            resampler_ = std::make_unique<AudioResampler>(native_sample_rate_, config_.sample_rate);
+        }
         
         // Start audio client
         hr = audio_client_->Start();
@@ -693,26 +650,34 @@ private:
                 }
                 
                 if (frames_available > 0) {
-                    // Convert to float
-                    std::vector<float> float_data(frames_available * native_channels_);
-                    
-                    // Assume 32-bit float format (most common for WASAPI shared mode)
+                    // Mix down to mono; assume 32-bit float format (most common for WASAPI shared mode)
+                    if (mono_buffer_.size() < frames_available) {
+                        mono_buffer_.resize(frames_available);
+                    }
                     if (!(flags & AUDCLNT_BUFFERFLAGS_SILENT)) {
-                        float* float_ptr = reinterpret_cast<float*>(data);
-                        std::copy(float_ptr, float_ptr + frames_available * native_channels_, float_data.begin());
+                        convertToMono(reinterpret_cast<const float*>(data), frames_available,
+                                      native_channels_, mono_buffer_.data());
                     } else {
-                        std::fill(float_data.begin(), float_data.end(), 0.0f);
+                        std::fill(mono_buffer_.begin(), mono_buffer_.begin() + frames_available, 0.0f);
                     }
                     
-                    // Resample to target rate
-                    auto resampled = resampler_->resample(float_data.data(), frames_available);
-                    
-                    // Convert to mono if needed
-                    auto mono_data = convertToMono(resampled.data(), resampled.size() / native_channels_, native_channels_);
+                    // Resample to target rate; the resampler carries its position and
+                    // filter history over from the previous packet
+                    const float* samples = mono_buffer_.data();
+                    size_t sample_count = frames_available;
+                    if (resampler_) {
+                        const size_t capacity = resampler_->maxOutput(frames_available);
+                        if (resampled_buffer_.size() < capacity) {
+                            resampled_buffer_.resize(capacity);
+                        }
+                        sample_count = resampler_->push(mono_buffer_.data(), frames_available,
+                                                        resampled_buffer_.data());
+                        samples = resampled_buffer_.data();
+                    }
                     
                     // Write to ring buffer
-                    if (!ring_buffer_.write(mono_data.data(), mono_data.size())) {
-                        stats_.dropped_samples += mono_data.size();
+                    if (sample_count > 0 && !ring_buffer_.write(samples, sample_count)) {
+                        stats_.dropped_samples += sample_count;
                         stats_.buffer_overruns++;
                         LOG_WARN("AudioCapture", "Audio buffer overflow");
                     }
@@ -746,11 +711,7 @@ private:
             }
             
             // Calculate audio level (RMS)
-            float sum_squares = 0.0f;
-            for (size_t i = 0; i < read_samples; ++i) {
-                sum_squares += process_buffer[i] * process_buffer[i];
-            }
-            float rms = std::sqrt(sum_squares / read_samples);
+            float rms = AudioUtils::calculateRMS(process_buffer.data(), read_samples);
             current_level_ = std::min(1.0f, rms);
             
             // Notify level callback
@@ -764,7 +725,7 @@ private:
             
             // Silence detection
             if (config_.enable_silence_detection) {
-                if (sum_squares / read_samples < silence_threshold_squared) {
+                if (rms * rms < silence_threshold_squared) {
                     silence_duration += (read_samples / float(config_.sample_rate));
                     
                     if (silence_duration >= config_.silence_duration_ms / 1000.0f) {
@@ -844,7 +805,9 @@ private:
     int native_sample_rate_ = 48000;
     int native_channels_ = 2;
     
-    std::unique_ptr<AudioResampler> resampler_;
+    std::unique_ptr<AudioResampler> resampler_;  // null when the device runs at the target rate
+    std::vector<float> mono_buffer_;       // capture thread scratch, grown to the largest packet
+    std::vector<float> resampled_buffer_;  // likewise, for the resampler output
     
     std::thread capture_thread_;
     std::thread processing_thread_;
@@ -5,18 +5,16 @@
  */
 
 #include "AudioConverter.h"
+#include "AudioResampler.h"
 #include "Logger.h"
 #include <algorithm>
 #include <cmath>
+#include <limits>
 #include <random>
 #include <chrono>
 #include <fstream>
 #include <cstring>
 
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
 namespace WhisperApp {
 
 /**
@@ -27,25 +25,6 @@ public:
     std::mt19937 rng;  // Random number generator for dithering
     
     Impl() : rng(std::chrono::steady_clock::now().time_since_epoch().count()) {}
-    
-    // Linear interpolation for resampling
-    float lerp(float a, float b, float t) {
-        return a + t * (b - a);
-    }
-    
-    // Simple sinc interpolation kernel
-    float sinc(float x) {
-        if (std::abs(x) < 0.001f) return 1.0f;
-        float pi_x = M_PI * x;
-        return std::sin(pi_x) / pi_x;
-    }
-    
-    // Lanczos window function
-    float lanczos(float x, int a) {
-        if (std::abs(x) >= a) return 0.0f;
-        if (std::abs(x) < 0.001f) return 1.0f;
-        return sinc(x) * sinc(x / a);
-    }
 };
 
 // Constructor
@@ -56,6 +35,26 @@ AudioConverter::AudioConverter() : pImpl(std::make_unique<Impl>()) {
 // Destructor
 AudioConverter::~AudioConverter() = default;
 
+namespace {
+
+// Frames per block of the conversion pipeline; a block of stereo input, its
+// mixdown and its resampled output stay well inside L2
+constexpr size_t kBlockFrames = 4096;
+
+// Map frames of inChannels to outChannels: the same, 2 -> 1 or 1 -> 2
+void mixFrames(const float* input, size_t frames, int inChannels, int outChannels,
+               float* output) {
+    if (inChannels == outChannels) {
+        std::copy(input, input + frames * inChannels, output);
+    } else if (inChannels == 2) {
+        AudioConverter::stereoToMono(input, frames, output);
+    } else {
+        AudioConverter::monoToStereo(input, frames, output);
+    }
+}
+
+} // namespace
+
 // Main conversion function
 AudioBuffer AudioConverter::convert(const AudioBuffer& input,
                                   const ConversionParams& params,
@@ -71,68 +70,156 @@ AudioBuffer AudioConverter::convert(const AudioBuffer& input,
     output.format = params.targetFormat;
     output.timestamp_ms = input.timestamp_ms;
     
-    // Start with the input data
-    std::vector<float> working = input.data;
-    AudioFormat currentFormat = input.format;
+    const int inChannels = input.format.channels;
+    const int outChannels = params.targetFormat.channels;
+    if (inChannels <= 0 || (inChannels != outChannels &&
+        !(inChannels == 2 && outChannels == 1) && !(inChannels == 1 && outChannels == 2))) {
+        throw AudioException(ErrorCode::AudioChannelCountInvalid,
+                           "Unsupported channel conversion");
+    }
     
-    // Step 1: Remove DC offset if requested
-    if (params.removeDCOffset) {
-        LOG_DEBUG("AudioConverter", "Removing DC offset");
-        working = removeDCOffset(working);
+    // The pipeline runs block by block: channel mixdown into a scratch block,
+    // then resampling straight into the output buffer. DC removal and
+    // normalization need the mean and peak of the whole signal, so they run
+    // with dithering and the statistics in a second pass over the output;
+    // without them, that work is done on each block while it is in cache.
+    
+    // A trailing partial frame is padded with silence
+    const size_t fullFrames = input.data.size() / inChannels;
+    const size_t frames = (input.data.size() + inChannels - 1) / inChannels;
+    std::vector<float> padded;
+    if (frames != fullFrames) {
+        padded.assign(inChannels, 0.0f);
+        std::copy(input.data.begin() + fullFrames * inChannels, input.data.end(), padded.begin());
     }
     
-    // Step 2: Convert channels if needed
-    if (currentFormat.channels != params.targetFormat.channels) {
+    if (inChannels != outChannels) {
         LOG_DEBUG("AudioConverter", "Converting channels: " + 
-                  std::to_string(currentFormat.channels) + " -> " + 
-                  std::to_string(params.targetFormat.channels));
-        
-        if (currentFormat.channels == 2 && params.targetFormat.channels == 1) {
-            working = stereoToMono(working);
-        } else if (currentFormat.channels == 1 && params.targetFormat.channels == 2) {
-            working = monoToStereo(working);
-        } else {
-            throw AudioException(ErrorCode::AudioChannelCountInvalid,
-                               "Unsupported channel conversion");
-        }
-        currentFormat.channels = params.targetFormat.channels;
+                  std::to_string(inChannels) + " -> " + std::to_string(outChannels));
     }
     
-    // Step 3: Resample if needed
-    if (currentFormat.sampleRate != params.targetFormat.sampleRate) {
+    std::unique_ptr<AudioResampler> resampler;
+    size_t outputFrames = frames;
+    if (input.format.sampleRate != params.targetFormat.sampleRate) {
         LOG_DEBUG("AudioConverter", "Resampling: " + 
-                  std::to_string(currentFormat.sampleRate) + " Hz -> " + 
+                  std::to_string(input.format.sampleRate) + " Hz -> " + 
                   std::to_string(params.targetFormat.sampleRate) + " Hz");
         
-        working = resample(working, currentFormat.sampleRate, 
-                          params.targetFormat.sampleRate, params.quality);
-        currentFormat.sampleRate = params.targetFormat.sampleRate;
-    }
-    
-    // Step 4: Normalize if requested
-    if (params.normalizeAudio) {
-        LOG_DEBUG("AudioConverter", "Normalizing audio");
-        working = normalize(working);
+        // Each channel of the interleaved frames is filtered on its own
+        resampler = std::make_unique<AudioResampler>(input.format.sampleRate,
+                                                     params.targetFormat.sampleRate,
+                                                     outChannels, params.quality);
+        outputFrames = resampler->outputLength(frames);
     }
     
-    // Step 5: Apply dithering if converting to lower bit depth
-    if (params.applyDithering && 
-        params.targetFormat.bitsPerSample < 32) {
+    const bool dither = params.applyDithering && params.targetFormat.bitsPerSample < 32;
+    if (dither) {
         LOG_DEBUG("AudioConverter", "Applying dithering for " + 
                   std::to_string(params.targetFormat.bitsPerSample) + "-bit output");
-        working = applyDithering(working, params.targetFormat.bitsPerSample);
+    }
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    const float quantizationStep = dither ? 1.0f / (1 << (params.targetFormat.bitsPerSample - 1)) : 0.0f;
+    
+    ConversionStats result;
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    float dcOffset = 0.0f;
+    float scale = 1.0f;
+    
+    // Remove the offset, scale, dither and measure samples in place
+    auto finish = [&](float* samples, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            float sample = (samples[i] - dcOffset) * scale;
+            if (dither) {
+                // Triangular dither, as applyDithering()
+                sample += (dist(pImpl->rng) + dist(pImpl->rng)) * 0.5f * quantizationStep * 0.5f;
+            }
+            samples[i] = sample;
+            
+            const float absSample = std::abs(sample);
+            result.peakLevel = std::max(result.peakLevel, absSample);
+            if (absSample > 1.0f) {
+                result.clippedSamples++;
+            }
+            sum += sample;
+            sumSquares += sample * sample;
+        }
+    };
+    const bool twoPass = params.removeDCOffset || params.normalizeAudio;
+    
+    // Pass 1: mixdown and resampling, noting the input sum and output extremes
+    output.data.resize(outputFrames * outChannels);
+    std::vector<float> block(resampler ? kBlockFrames * outChannels : 0);
+    double inputSum = 0.0;
+    // Extremes of the produced samples; they stay at their starting values
+    // until a sample arrives, so an offset alone never counts as a peak
+    float high = -std::numeric_limits<float>::infinity();
+    float low = std::numeric_limits<float>::infinity();
+    float* out = output.data.data();
+    auto produced = [&](float* samples, size_t count) {
+        if (twoPass) {
+            for (size_t i = 0; i < count; ++i) {
+                high = std::max(high, samples[i]);
+                low = std::min(low, samples[i]);
+            }
+        } else {
+            finish(samples, count);
+        }
+    };
+    for (size_t frame = 0; frame < frames; ) {
+        const size_t count = std::min(kBlockFrames, frame < fullFrames ? fullFrames - frame : 1);
+        const float* source = frame < fullFrames ? input.data.data() + frame * inChannels : padded.data();
+        float* mixed = resampler ? block.data() : out;
+        mixFrames(source, count, inChannels, outChannels, mixed);
+        if (params.removeDCOffset) {
+            for (size_t i = 0; i < count * outChannels; ++i) {
+                inputSum += mixed[i];
+            }
+        }
+        
+        const size_t written = resampler ? resampler->push(mixed, count, out) : count;
+        produced(out, written * outChannels);
+        out += written * outChannels;
+        frame += count;
+    }
+    if (resampler) {
+        const size_t written = resampler->flush(out);
+        produced(out, written * outChannels);
+    }
+    
+    // Pass 2: with the mean and peak known
+    if (twoPass) {
+        if (params.removeDCOffset) {
+            LOG_DEBUG("AudioConverter", "Removing DC offset");
+            // The filters have unity gain at DC, so the offset carries through
+            // resampling unchanged and can be taken out afterwards
+            dcOffset = static_cast<float>(inputSum / (static_cast<double>(frames) * outChannels));
+        }
+        
+        const float peak = high >= low ? std::max(high - dcOffset, dcOffset - low) : 0.0f;
+        const float targetPeak = 0.95f;  // as normalize()
+        if (params.normalizeAudio && peak > 0.0f && peak != targetPeak) {
+            LOG_DEBUG("AudioConverter", "Normalizing audio");
+            scale = targetPeak / peak;
+        }
+        
+        finish(output.data.data(), output.data.size());
     }
     
     // Calculate statistics if requested
     if (stats) {
-        *stats = calculateStats(working);
+        const size_t count = output.data.size();
+        if (count > 0) {
+            result.dcOffset = static_cast<float>(sum / count);
+            result.averageLevel = static_cast<float>(std::sqrt(sumSquares / count));
+        }
+        *stats = result;
         auto end_time = std::chrono::steady_clock::now();
-        stats->processingTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        // Fractional, since short buffers convert in well under a millisecond
+        stats->processingTimeMs = std::chrono::duration<double, std::milli>(
             end_time - start_time).count();
     }
     
-    output.data = std::move(working);
-    
     LOG_INFO("AudioConverter", "Conversion completed: " + 
              std::to_string(input.data.size()) + " -> " + 
              std::to_string(output.data.size()) + " samples");
@@ -245,129 +332,138 @@ std::vector<float> AudioConverter::resample(const std::vector<float>& input,
     LOG_DEBUG("AudioConverter", "Resampling from " + std::to_string(inputRate) + 
               " to " + std::to_string(outputRate));
     
-    double ratio = static_cast<double>(outputRate) / inputRate;
-    size_t outputSize = static_cast<size_t>(input.size() * ratio);
-    std::vector<float> output;
-    output.reserve(outputSize);
-    
-    // Simple linear interpolation for now
-    // TODO: Implement better resampling algorithms based on quality setting
-    for (size_t i = 0; i < outputSize; ++i) {
-        double srcIdx = i / ratio;
-        size_t idx0 = static_cast<size_t>(srcIdx);
-        size_t idx1 = std::min(idx0 + 1, input.size() - 1);
-        double frac = srcIdx - idx0;
-        
-        float sample = input[idx0] * (1.0 - frac) + input[idx1] * frac;
-        output.push_back(sample);
-    }
+    const AudioResampler resampler(inputRate, outputRate, 1, quality);
+    std::vector<float> output(resampler.outputLength(input.size()));
+    resampler.process(input.data(), input.size(), output.data());
     
     return output;
 }
 
 // Convert stereo to mono
 std::vector<float> AudioConverter::stereoToMono(const std::vector<float>& stereo) {
-    std::vector<float> mono;
-    mono.reserve(stereo.size() / 2);
+    std::vector<float> mono((stereo.size() + 1) / 2);
+    const size_t frames = stereo.size() / 2;
+    stereoToMono(stereo.data(), frames, mono.data());
     
-    for (size_t i = 0; i < stereo.size(); i += 2) {
-        float left = stereo[i];
-        float right = (i + 1 < stereo.size()) ? stereo[i + 1] : 0.0f;
-        mono.push_back((left + right) * 0.5f);
+    // A trailing lone sample is averaged with silence
+    if (frames < mono.size()) {
+        mono.back() = stereo.back() * 0.5f;
     }
     
     return mono;
 }
 
+void AudioConverter::stereoToMono(const float* stereo, size_t frames, float* mono) {
+    // Forward: mono[i] never overwrites a frame that is still to be read
+    for (size_t i = 0; i < frames; ++i) {
+        mono[i] = (stereo[2 * i] + stereo[2 * i + 1]) * 0.5f;
+    }
+}
+
+void AudioConverter::stereoToMono(float* samples, size_t frames) {
+    stereoToMono(samples, frames, samples);
+}
+
 // Convert mono to stereo
 std::vector<float> AudioConverter::monoToStereo(const std::vector<float>& mono) {
-    std::vector<float> stereo;
-    stereo.reserve(mono.size() * 2);
-    
-    for (float sample : mono) {
-        stereo.push_back(sample);  // Left
-        stereo.push_back(sample);  // Right
-    }
-    
+    std::vector<float> stereo(mono.size() * 2);
+    monoToStereo(mono.data(), mono.size(), stereo.data());
     return stereo;
 }
 
+void AudioConverter::monoToStereo(const float* mono, size_t count, float* stereo) {
+    // Backward: frame i lands at or after sample i, which is already read
+    for (size_t i = count; i-- > 0; ) {
+        stereo[2 * i] = stereo[2 * i + 1] = mono[i];
+    }
+}
+
+void AudioConverter::monoToStereo(float* samples, size_t count) {
+    monoToStereo(samples, count, samples);
+}
+
 // Normalize audio
 std::vector<float> AudioConverter::normalize(const std::vector<float>& samples,
                                             float targetPeak) {
-    if (samples.empty()) {
-        return samples;
-    }
-    
+    std::vector<float> normalized(samples.size());
+    normalize(samples.data(), samples.size(), normalized.data(), targetPeak);
+    return normalized;
+}
+
+void AudioConverter::normalize(const float* samples, size_t count, float* output,
+                               float targetPeak) {
     // Find peak absolute value
     float peak = 0.0f;
-    for (float sample : samples) {
-        peak = std::max(peak, std::abs(sample));
-    }
-    
-    if (peak == 0.0f || peak == targetPeak) {
-        return samples;
+    for (size_t i = 0; i < count; ++i) {
+        peak = std::max(peak, std::abs(samples[i]));
     }
     
-    // Calculate scaling factor
-    float scale = targetPeak / peak;
-    
-    // Apply scaling
-    std::vector<float> normalized;
-    normalized.reserve(samples.size());
-    
-    for (float sample : samples) {
-        normalized.push_back(sample * scale);
+    // Scale to the target peak; silence and samples already at it pass through
+    const float scale = (peak == 0.0f || peak == targetPeak) ? 1.0f : targetPeak / peak;
+    for (size_t i = 0; i < count; ++i) {
+        output[i] = samples[i] * scale;
     }
-    
-    return normalized;
+}
+
+void AudioConverter::normalize(float* samples, size_t count, float targetPeak) {
+    normalize(samples, count, samples, targetPeak);
 }
 
 // Remove DC offset
 std::vector<float> AudioConverter::removeDCOffset(const std::vector<float>& samples) {
-    if (samples.empty()) {
-        return samples;
+    std::vector<float> result(samples.size());
+    removeDCOffset(samples.data(), samples.size(), result.data());
+    return result;
+}
+
+void AudioConverter::removeDCOffset(const float* samples, size_t count, float* output) {
+    if (count == 0) {
+        return;
     }
     
     // Calculate average (DC offset)
     double sum = 0.0;
-    for (float sample : samples) {
-        sum += sample;
+    for (size_t i = 0; i < count; ++i) {
+        sum += samples[i];
     }
-    float dcOffset = static_cast<float>(sum / samples.size());
-    
-    // Remove DC offset
-    std::vector<float> result;
-    result.reserve(samples.size());
+    const float dcOffset = static_cast<float>(sum / count);
     
-    for (float sample : samples) {
-        result.push_back(sample - dcOffset);
+    for (size_t i = 0; i < count; ++i) {
+        output[i] = samples[i] - dcOffset;
     }
-    
-    return result;
+}
+
+void AudioConverter::removeDCOffset(float* samples, size_t count) {
+    removeDCOffset(samples, count, samples);
 }
 
 // Apply dithering
 std::vector<float> AudioConverter::applyDithering(const std::vector<float>& samples,
                                                  int targetBits) {
-    std::vector<float> dithered;
-    dithered.reserve(samples.size());
-    
+    std::vector<float> dithered(samples.size());
+    applyDithering(samples.data(), samples.size(), dithered.data(), targetBits);
+    return dithered;
+}
+
+void AudioConverter::applyDithering(const float* samples, size_t count, float* output,
+                                    int targetBits) {
+    // One generator per thread, so the static helpers need no converter instance
+    thread_local std::mt19937 rng(static_cast<std::mt19937::result_type>(
+        std::chrono::steady_clock::now().time_since_epoch().count()));
     std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
     float quantizationStep = 1.0f / (1 << (targetBits - 1));
     
-    AudioConverter converter;
-    
-    for (float sample : samples) {
+    for (size_t i = 0; i < count; ++i) {
         // Add triangular dither
-        float dither = (dist(converter.pImpl->rng) + dist(converter.pImpl->rng)) * 0.5f;
+        float dither = (dist(rng) + dist(rng)) * 0.5f;
         dither *= quantizationStep * 0.5f;
         
-        float ditheredSample = sample + dither;
-        dithered.push_back(ditheredSample);
+        output[i] = samples[i] + dither;
     }
-    
-    return dithered;
+}
+
+void AudioConverter::applyDithering(float* samples, size_t count, int targetBits) {
+    applyDithering(samples, count, samples, targetBits);
 }
 
 // Calculate statistics
@@ -82,6 +82,10 @@ enum class ConversionQuality {
 
 /**
  * @brief Audio converter class
+ *
+ * The sample helpers come in three forms: taking a vector and returning a new
+ * one, writing to a caller buffer (which may be the input), and working in
+ * place. The last two never allocate, so per-block code can chain them.
  */
 class AudioConverter {
 public:
@@ -105,7 +109,7 @@ public:
         float averageLevel = 0.0f;       // Average audio level
         float dcOffset = 0.0f;           // DC offset detected
         uint64_t clippedSamples = 0;     // Number of clipped samples
-        uint64_t processingTimeMs = 0;   // Processing time
+        double processingTimeMs = 0.0;   // Processing time, fractional
     };
 
 public:
@@ -144,11 +148,12 @@ public:
     
     /**
      * @brief Resample audio to target sample rate
-     * @param input Input samples
+     * @param input Input samples (mono)
      * @param inputRate Input sample rate
      * @param outputRate Output sample rate
-     * @param quality Resampling quality
+     * @param quality Length of the anti-aliasing filter (see AudioResampler)
      * @return Resampled audio
+     * @throws AudioException if a rate is not positive
      */
     static std::vector<float> resample(const std::vector<float>& input,
                                       int inputRate,
@@ -162,6 +167,21 @@ public:
      */
     static std::vector<float> stereoToMono(const std::vector<float>& stereo);
     
+    /**
+     * @brief Convert stereo to mono into a caller buffer
+     * @param stereo Stereo samples (interleaved)
+     * @param frames Number of stereo frames
+     * @param mono Receives frames samples; may be stereo itself
+     */
+    static void stereoToMono(const float* stereo, size_t frames, float* mono);
+    
+    /**
+     * @brief Convert stereo to mono in place
+     * @param samples Stereo samples (interleaved); the first frames samples become mono
+     * @param frames Number of stereo frames
+     */
+    static void stereoToMono(float* samples, size_t frames);
+    
     /**
      * @brief Convert mono to stereo
      * @param mono Mono samples
@@ -169,6 +189,21 @@ public:
      */
     static std::vector<float> monoToStereo(const std::vector<float>& mono);
     
+    /**
+     * @brief Convert mono to stereo into a caller buffer
+     * @param mono Mono samples
+     * @param count Number of samples
+     * @param stereo Receives 2 * count samples; may be mono itself
+     */
+    static void monoToStereo(const float* mono, size_t count, float* stereo);
+    
+    /**
+     * @brief Convert mono to stereo in place
+     * @param samples Mono samples, with room for 2 * count
+     * @param count Number of mono samples
+     */
+    static void monoToStereo(float* samples, size_t count);
+    
     /**
      * @brief Normalize audio to specified range
      * @param samples Audio samples
@@ -178,6 +213,24 @@ public:
     static std::vector<float> normalize(const std::vector<float>& samples,
                                        float targetPeak = 0.95f);
     
+    /**
+     * @brief Normalize audio into a caller buffer
+     * @param samples Audio samples
+     * @param count Number of samples
+     * @param output Receives count samples; may be samples itself
+     * @param targetPeak Target peak level (default: 0.95)
+     */
+    static void normalize(const float* samples, size_t count, float* output,
+                          float targetPeak = 0.95f);
+    
+    /**
+     * @brief Normalize audio in place
+     * @param samples Audio samples, overwritten with the normalized samples
+     * @param count Number of samples
+     * @param targetPeak Target peak level (default: 0.95)
+     */
+    static void normalize(float* samples, size_t count, float targetPeak = 0.95f);
+    
     /**
      * @brief Remove DC offset from audio
      * @param samples Audio samples
@@ -185,6 +238,21 @@ public:
      */
     static std::vector<float> removeDCOffset(const std::vector<float>& samples);
     
+    /**
+     * @brief Remove DC offset into a caller buffer
+     * @param samples Audio samples
+     * @param count Number of samples
+     * @param output Receives count samples; may be samples itself
+     */
+    static void removeDCOffset(const float* samples, size_t count, float* output);
+    
+    /**
+     * @brief Remove DC offset in place
+     * @param samples Audio samples, overwritten with the offset removed
+     * @param count Number of samples
+     */
+    static void removeDCOffset(float* samples, size_t count);
+    
     /**
      * @brief Apply dithering to audio
      * @param samples Audio samples
@@ -194,6 +262,28 @@ public:
     static std::vector<float> applyDithering(const std::vector<float>& samples,
                                             int targetBits);
     
+    /**
+     * @brief Apply dithering into a caller buffer
+     *
+     * The noise comes from a thread-local generator, so concurrent calls
+     * need no locking.
+     *
+     * @param samples Audio samples
+     * @param count Number of samples
+     * @param output Receives count samples; may be samples itself
+     * @param targetBits Target bit depth
+     */
+    static void applyDithering(const float* samples, size_t count, float* output,
+                               int targetBits);
+    
+    /**
+     * @brief Apply dithering in place, from a thread-local generator
+     * @param samples Audio samples, overwritten with the dithered samples
+     * @param count Number of samples
+     * @param targetBits Target bit depth
+     */
+    static void applyDithering(float* samples, size_t count, int targetBits);
+    
     /**
      * @brief Calculate audio statistics
      * @param samples Audio samples
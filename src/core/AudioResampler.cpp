@@ -0,0 +1,427 @@
+/*
+ * AudioResampler.cpp
+ *
+ * Implementation of the polyphase resampler.
+ */
+
+#include "AudioResampler.h"
+#include "ErrorCodes.h"
+#include "SimdSupport.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace WhisperApp {
+
+namespace {
+
+// Rows beyond this are rounded to the nearest of this many phases
+constexpr int64_t kMaxPhases = 1024;
+
+struct FilterSpec {
+    int zeroCrossings;  // sinc lobes on each side of the center
+    double beta;        // Kaiser window shape; higher attenuates the stopband more
+    double rolloff;     // cutoff relative to the lower Nyquist frequency
+};
+
+FilterSpec filterSpec(ConversionQuality quality) {
+    switch (quality) {
+        case ConversionQuality::Low:    return {4, 5.0, 0.80};
+        case ConversionQuality::Medium: return {6, 6.0, 0.85};
+        case ConversionQuality::High:   return {16, 9.0, 0.93};
+        case ConversionQuality::Best:   return {32, 11.0, 0.96};
+    }
+    return {6, 6.0, 0.85};
+}
+
+// Zeroth-order modified Bessel function of the first kind
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+inline float dot(const float* a, const float* b, int n) {
+#if defined(WHISPERAPP_SIMD_SSE)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    for (; i < n; i += 4) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    acc0 = _mm_add_ps(acc0, acc1);
+    acc0 = _mm_add_ps(acc0, _mm_movehl_ps(acc0, acc0));
+    acc0 = _mm_add_ss(acc0, _mm_shuffle_ps(acc0, acc0, 1));
+    return _mm_cvtss_f32(acc0);
+#elif defined(WHISPERAPP_SIMD_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    for (; i < n; i += 4) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    acc0 = vaddq_f32(acc0, acc1);
+    float32x2_t sum = vadd_f32(vget_low_f32(acc0), vget_high_f32(acc0));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#else
+    // n is a multiple of 4: four independent sums vectorize without reassociation
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    for (int i = 0; i < n; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    return (s0 + s1) + (s2 + s3);
+#endif
+}
+
+#if defined(WHISPERAPP_SIMD_AVX2)
+const bool kHasAvx2 = cpuHasAvx2();
+
+// Adds eight accumulators across lanes and stores them at out[0], out[step], ...
+WHISPERAPP_TARGET_AVX2
+inline void store8Avx2(__m256 a0, __m256 a1, __m256 a2, __m256 a3,
+                       __m256 a4, __m256 a5, __m256 a6, __m256 a7,
+                       float* out, size_t step) {
+    // After two hadds each 128-bit half holds partial sums of four outputs in order
+    const __m256 lo = _mm256_hadd_ps(_mm256_hadd_ps(a0, a1), _mm256_hadd_ps(a2, a3));
+    const __m256 hi = _mm256_hadd_ps(_mm256_hadd_ps(a4, a5), _mm256_hadd_ps(a6, a7));
+    alignas(32) float sums[8];
+    _mm256_store_ps(sums, _mm256_add_ps(_mm256_permute2f128_ps(lo, hi, 0x20),
+                                        _mm256_permute2f128_ps(lo, hi, 0x31)));
+    for (int j = 0; j < 8; ++j) {
+        out[j * step] = sums[j];
+    }
+}
+
+// Applies one row to count windows that start stride samples apart, eight at a
+// time so eight independent FMA chains are in flight. With Chunks > 0 the row
+// (Chunks * 8 taps) stays in registers; Chunks == 0 reads taps from memory.
+template <int Chunks>
+WHISPERAPP_TARGET_AVX2
+void applyRowAvx2(const float* row, int taps, const float* input, size_t stride,
+                  size_t count, float* out, size_t outStride) {
+    const int chunks = Chunks > 0 ? Chunks : taps / 8;
+    __m256 w[Chunks > 0 ? Chunks : 1];
+    if constexpr (Chunks > 0) {
+        for (int k = 0; k < Chunks; ++k) {
+            w[k] = _mm256_loadu_ps(row + 8 * k);
+        }
+    }
+
+    size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        const float* x = input + n * stride;
+        __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+        __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+        __m256 a4 = _mm256_setzero_ps(), a5 = _mm256_setzero_ps();
+        __m256 a6 = _mm256_setzero_ps(), a7 = _mm256_setzero_ps();
+        for (int k = 0; k < chunks; ++k) {
+            const __m256 t = (Chunks > 0) ? w[k] : _mm256_loadu_ps(row + 8 * k);
+            const float* xk = x + 8 * k;
+            a0 = _mm256_fmadd_ps(t, _mm256_loadu_ps(xk), a0);
+            a1 = _mm256_fmadd_ps(t, _mm256_loadu_ps(xk + stride), a1);
+            a2 = _mm256_fmadd_ps(t, _mm256_loadu_ps(xk + 2 * stride), a2);
+            a3 = _mm256_fmadd_ps(t, _mm256_loadu_ps(xk + 3 * stride), a3);
+            a4 = _mm256_fmadd_ps(t, _mm256_loadu_ps(xk + 4 * stride), a4);
+            a5 = _mm256_fmadd_ps(t, _mm256_loadu_ps(xk + 5 * stride), a5);
+            a6 = _mm256_fmadd_ps(t, _mm256_loadu_ps(xk + 6 * stride), a6);
+            a7 = _mm256_fmadd_ps(t, _mm256_loadu_ps(xk + 7 * stride), a7);
+        }
+        store8Avx2(a0, a1, a2, a3, a4, a5, a6, a7, out + n * outStride, outStride);
+    }
+    for (; n < count; ++n) {
+        const float* x = input + n * stride;
+        __m256 acc = _mm256_setzero_ps();
+        for (int k = 0; k < chunks; ++k) {
+            const __m256 t = (Chunks > 0) ? w[k] : _mm256_loadu_ps(row + 8 * k);
+            acc = _mm256_fmadd_ps(t, _mm256_loadu_ps(x + 8 * k), acc);
+        }
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        out[n * outStride] = _mm_cvtss_f32(sum);
+    }
+}
+#endif
+
+int64_t ceilDiv(int64_t a, int64_t b) {
+    return a >= 0 ? (a + b - 1) / b : -((-a) / b);
+}
+
+// Applies one row to count windows that start stride samples apart
+void applyRow(const float* row, int taps, const float* input, size_t stride,
+              size_t count, float* out, size_t outStride) {
+#if defined(WHISPERAPP_SIMD_AVX2)
+    if (kHasAvx2) {
+        switch (taps / 8) {
+            case 1: return applyRowAvx2<1>(row, taps, input, stride, count, out, outStride);
+            case 2: return applyRowAvx2<2>(row, taps, input, stride, count, out, outStride);
+            case 3: return applyRowAvx2<3>(row, taps, input, stride, count, out, outStride);
+            case 4: return applyRowAvx2<4>(row, taps, input, stride, count, out, outStride);
+            case 5: return applyRowAvx2<5>(row, taps, input, stride, count, out, outStride);
+            case 6: return applyRowAvx2<6>(row, taps, input, stride, count, out, outStride);
+            case 7: return applyRowAvx2<7>(row, taps, input, stride, count, out, outStride);
+            default: return applyRowAvx2<0>(row, taps, input, stride, count, out, outStride);
+        }
+    }
+#endif
+    for (size_t n = 0; n < count; ++n) {
+        out[n * outStride] = dot(row, input + n * stride, taps);
+    }
+}
+
+} // namespace
+
+AudioResampler::AudioResampler(int inputRate, int outputRate, int channels,
+                               ConversionQuality quality)
+    : inputRate_(inputRate), outputRate_(outputRate), channels_(channels) {
+    if (inputRate <= 0 || outputRate <= 0) {
+        throw AudioException(ErrorCode::AudioSampleRateInvalid,
+                           "Invalid resampling rates: " + std::to_string(inputRate) +
+                           " -> " + std::to_string(outputRate));
+    }
+    if (channels <= 0) {
+        throw AudioException(ErrorCode::AudioChannelCountInvalid,
+                           "Invalid channel count: " + std::to_string(channels));
+    }
+
+    const int64_t g = std::gcd(static_cast<int64_t>(inputRate), static_cast<int64_t>(outputRate));
+    up_ = outputRate / g;
+    down_ = inputRate / g;
+    phases_ = static_cast<int>(std::min(up_, kMaxPhases));
+
+    // Cutoff in cycles per input sample, relative to the input Nyquist frequency
+    const FilterSpec spec = filterSpec(quality);
+    const double cutoff = spec.rolloff * std::min(1.0, static_cast<double>(up_) / down_);
+    const double halfWidth = spec.zeroCrossings / cutoff;  // in input samples
+
+    center_ = static_cast<int>(std::ceil(halfWidth));
+    taps_ = (2 * center_ + 7) / 8 * 8;
+
+    // Rounding can reach fraction 1, the next input sample. That row keeps the
+    // same window: its first tap falls at or past the half width, where the window is
+    // zero, so nothing has to shift when the phase wraps.
+    const int rows = (phases_ == up_) ? phases_ : phases_ + 1;
+    bank_.assign(static_cast<size_t>(rows) * taps_, 0.0f);
+
+    const double i0Beta = besselI0(spec.beta);
+    for (int p = 0; p < rows; ++p) {
+        const double frac = static_cast<double>(p) / phases_;
+        float* row = &bank_[static_cast<size_t>(p) * taps_];
+
+        // Tap k weighs input sample (position - center_ + 1 + k)
+        double sum = 0.0;
+        std::vector<double> coeffs(taps_, 0.0);
+        for (int k = 0; k < 2 * center_; ++k) {
+            const double u = frac + center_ - 1 - k;
+            const double x = u / halfWidth;
+            if (std::abs(x) >= 1.0) {
+                continue;
+            }
+            const double arg = M_PI * cutoff * u;
+            const double sinc = (std::abs(arg) < 1e-12) ? 1.0 : std::sin(arg) / arg;
+            const double window = besselI0(spec.beta * std::sqrt(1.0 - x * x)) / i0Beta;
+            coeffs[k] = sinc * window;
+            sum += coeffs[k];
+        }
+
+        // Unity gain at DC for every phase
+        for (int k = 0; k < taps_; ++k) {
+            row[k] = static_cast<float>(coeffs[k] / sum);
+        }
+    }
+
+    history_.resize(channels_);
+    reset();
+}
+
+size_t AudioResampler::outputLength(size_t count) const {
+    return static_cast<size_t>(static_cast<uint64_t>(count) * up_ / down_);
+}
+
+int64_t AudioResampler::windowStart(int64_t n) const {
+    // Output n sits at input position n*M/L; its window starts center_ - 1 earlier
+    return n * down_ / up_ - center_ + 1;
+}
+
+int AudioResampler::phaseOf(int64_t n) const {
+    const int64_t r = n * down_ % up_;
+    return static_cast<int>(phases_ == up_ ? r : (r * phases_ + up_ / 2) / up_);
+}
+
+float AudioResampler::filter(const float* input, size_t count, int64_t n) const {
+    const float* row = &bank_[static_cast<size_t>(phaseOf(n)) * taps_];
+    const int64_t start = windowStart(n);
+
+    // Samples outside the buffer are silence
+    float sum = 0.0f;
+    const int64_t k0 = std::max<int64_t>(0, -start);
+    const int64_t k1 = std::min<int64_t>(taps_, static_cast<int64_t>(count) - start);
+    for (int64_t k = k0; k < k1; ++k) {
+        sum += row[k] * input[start + k];
+    }
+    return sum;
+}
+
+void AudioResampler::run(const float* input, int64_t inputStart, int64_t first, int64_t last,
+                         float* output, size_t stride) const {
+    // input[0] is input sample inputStart; the windows of outputs [first, last)
+    // lie inside it, and output n goes to output[(n - first) * stride]
+    if (phases_ == up_) {
+        // Outputs n = c*L + j share the phase and offset of j and sit M input
+        // samples apart from one cycle c to the next. Walking one phase at a time
+        // keeps its row hot; blocks of cycles keep the input in cache.
+        const int64_t blockCycles = std::max<int64_t>(64, 16384 / down_);
+        const int64_t cycleEnd = ceilDiv(last, up_);
+        for (int64_t c0 = first / up_; c0 < cycleEnd; c0 += blockCycles) {
+            const int64_t c1 = std::min(cycleEnd, c0 + blockCycles);
+            for (int64_t j = 0; j < up_; ++j) {
+                const int64_t cStart = std::max(c0, ceilDiv(first - j, up_));
+                const int64_t cStop = std::min(c1, ceilDiv(last - j, up_));
+                if (cStart >= cStop) {
+                    continue;
+                }
+                const int64_t n = cStart * up_ + j;
+                applyRow(&bank_[static_cast<size_t>(j * down_ % up_) * taps_], taps_,
+                         input + (windowStart(n) - inputStart), static_cast<size_t>(down_),
+                         static_cast<size_t>(cStop - cStart),
+                         output + (n - first) * stride, static_cast<size_t>(up_) * stride);
+            }
+        }
+    } else {
+        for (int64_t n = first; n < last; ++n) {
+            output[(n - first) * stride] = dot(&bank_[static_cast<size_t>(phaseOf(n)) * taps_],
+                                               input + (windowStart(n) - inputStart), taps_);
+        }
+    }
+}
+
+void AudioResampler::processChannel(const float* input, size_t count, float* output,
+                                    size_t stride) const {
+    const int64_t outputCount = static_cast<int64_t>(outputLength(count));
+
+    // Outputs [first, last) have the whole window inside the buffer
+    const int64_t lastStart = static_cast<int64_t>(count) - taps_;
+    const int64_t last = (lastStart < 0) ? 0
+        : std::min(outputCount, ceilDiv((lastStart + center_) * up_, down_));
+    const int64_t first = std::min(last, ceilDiv(static_cast<int64_t>(center_ - 1) * up_, down_));
+
+    for (int64_t n = 0; n < first; ++n) {
+        output[n * stride] = filter(input, count, n);
+    }
+    run(input, 0, first, last, output + first * stride, stride);
+    for (int64_t n = last; n < outputCount; ++n) {
+        output[n * stride] = filter(input, count, n);
+    }
+}
+
+size_t AudioResampler::process(const float* input, size_t count, float* output) const {
+    if (channels_ == 1) {
+        processChannel(input, count, output, 1);
+        return outputLength(count);
+    }
+
+    std::vector<float> channel(count);
+    for (int ch = 0; ch < channels_; ++ch) {
+        for (size_t i = 0; i < count; ++i) {
+            channel[i] = input[i * channels_ + ch];
+        }
+        processChannel(channel.data(), count, output + ch, static_cast<size_t>(channels_));
+    }
+    return outputLength(count);
+}
+
+size_t AudioResampler::maxOutput(size_t count) const {
+    return static_cast<size_t>((streamIn_ + static_cast<int64_t>(count)) * up_ / down_ - streamOut_);
+}
+
+size_t AudioResampler::push(const float* input, size_t count, float* output) {
+    for (int ch = 0; ch < channels_; ++ch) {
+        std::vector<float>& history = history_[ch];
+        const size_t offset = history.size();
+        history.resize(offset + count);
+        for (size_t i = 0; i < count; ++i) {
+            history[offset + i] = input[i * channels_ + ch];
+        }
+    }
+    streamIn_ += static_cast<int64_t>(count);
+
+    // Outputs whose window ends inside the history, and no more than process()
+    // would produce for the input so far
+    const int64_t historyEnd = historyStart_ + static_cast<int64_t>(history_[0].size());
+    const int64_t last = std::min(ceilDiv((historyEnd - taps_ + center_) * up_, down_),
+                                  streamIn_ * up_ / down_);
+    return drain(last, output);
+}
+
+size_t AudioResampler::flush(float* output) {
+    // A window of silence lets every remaining output see the end of the input
+    for (auto& history : history_) {
+        history.resize(history.size() + taps_, 0.0f);
+    }
+    const size_t written = drain(streamIn_ * up_ / down_, output);
+    reset();
+    return written;
+}
+
+void AudioResampler::reset() {
+    // Output 0 reaches center_ - 1 samples before the stream: start with silence
+    for (auto& history : history_) {
+        history.assign(static_cast<size_t>(center_ - 1), 0.0f);
+    }
+    historyStart_ = -(center_ - 1);
+    streamIn_ = 0;
+    streamOut_ = 0;
+}
+
+size_t AudioResampler::drain(int64_t last, float* output) {
+    if (last <= streamOut_) {
+        return 0;
+    }
+    for (int ch = 0; ch < channels_; ++ch) {
+        run(history_[ch].data(), historyStart_, streamOut_, last, output + ch,
+            static_cast<size_t>(channels_));
+    }
+    const size_t written = static_cast<size_t>(last - streamOut_);
+    streamOut_ = last;
+
+    // Keep only what the next window reaches; erasing from the front keeps the capacity
+    const int64_t drop = std::min<int64_t>(windowStart(streamOut_) - historyStart_,
+                                           static_cast<int64_t>(history_[0].size()));
+    if (drop > 0) {
+        for (auto& history : history_) {
+            history.erase(history.begin(), history.begin() + drop);
+        }
+        historyStart_ += drop;
+    }
+
+    // Every L outputs the positions repeat M inputs later; count from there
+    const int64_t cycles = streamOut_ / up_;
+    streamOut_ -= cycles * up_;
+    streamIn_ -= cycles * down_;
+    historyStart_ -= cycles * down_;
+    return written;
+}
+
+} // namespace WhisperApp
@@ -0,0 +1,129 @@
+/*
+ * AudioResampler.h
+ *
+ * Polyphase windowed-sinc sample rate conversion for WhisperApp.
+ */
+
+#ifndef AUDIORESAMPLER_H
+#define AUDIORESAMPLER_H
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "AudioConverter.h"
+
+namespace WhisperApp {
+
+/**
+ * @brief Rational-ratio resampler with a precomputed polyphase filter bank
+ *
+ * The rates are reduced to L/M. Output sample n lies at input position n*M/L,
+ * which falls on one of L phases between two input samples; each phase has its
+ * own row of Kaiser-windowed sinc taps, so producing a sample is one dot product
+ * over consecutive input samples. The cutoff sits below the lower of the two
+ * Nyquist frequencies, so downsampling does not alias.
+ *
+ * Quality sets the filter length in zero crossings of the sinc per side and the
+ * stopband attenuation: Low 4, Medium 6, High 16, Best 32.
+ *
+ * A buffer can be converted in one call with process(), or a stream in pieces
+ * with push() and flush(). Streaming keeps the filter history and the position
+ * between calls, so the concatenated output equals process() on the
+ * concatenated input, sample for sample. Audio is interleaved frames of
+ * channels() samples; each channel is filtered on its own.
+ */
+class AudioResampler {
+public:
+    /**
+     * @brief Design the filter bank
+     * @param inputRate Input sample rate in Hz
+     * @param outputRate Output sample rate in Hz
+     * @param channels Samples per interleaved frame
+     * @param quality Filter length and attenuation
+     * @throws AudioException if a rate or the channel count is not positive
+     */
+    AudioResampler(int inputRate, int outputRate, int channels = 1,
+                   ConversionQuality quality = ConversionQuality::Medium);
+
+    /**
+     * @brief Number of output frames process() produces for count input frames
+     */
+    size_t outputLength(size_t count) const;
+
+    /**
+     * @brief Resample a whole buffer; samples before and after it count as silence
+     * @param input Interleaved input frames
+     * @param count Number of input frames
+     * @param output Receives outputLength(count) frames
+     * @return Number of frames written
+     */
+    size_t process(const float* input, size_t count, float* output) const;
+
+    /**
+     * @brief Upper bound on the frames the next push() of count frames writes
+     *
+     * maxOutput(0) bounds what flush() writes.
+     */
+    size_t maxOutput(size_t count) const;
+
+    /**
+     * @brief Feed the next piece of a stream
+     *
+     * Output lags the input by half the filter length: frames whose filter
+     * reaches past the input seen so far are written by a later call.
+     *
+     * @param input Interleaved input frames
+     * @param count Number of input frames
+     * @param output Receives at most maxOutput(count) frames
+     * @return Number of frames written
+     */
+    size_t push(const float* input, size_t count, float* output);
+
+    /**
+     * @brief End the stream: write the remaining frames as if silence followed
+     * @param output Receives at most maxOutput(0) frames
+     * @return Number of frames written
+     */
+    size_t flush(float* output);
+
+    /**
+     * @brief Drop the stream state; the next push() starts a new stream
+     */
+    void reset();
+
+    int inputRate() const { return inputRate_; }
+    int outputRate() const { return outputRate_; }
+    int channels() const { return channels_; }
+    int phases() const { return phases_; }
+    int tapsPerPhase() const { return taps_; }
+
+private:
+    int64_t windowStart(int64_t n) const;
+    int phaseOf(int64_t n) const;
+    float filter(const float* input, size_t count, int64_t n) const;
+    void processChannel(const float* input, size_t count, float* output, size_t stride) const;
+    void run(const float* input, int64_t inputStart, int64_t first, int64_t last,
+             float* output, size_t stride) const;
+    size_t drain(int64_t last, float* output);
+
+    int inputRate_;
+    int outputRate_;
+    int channels_;
+    int64_t up_;      // L: output rate / gcd
+    int64_t down_;    // M: input rate / gcd
+    int phases_;      // rows in the bank; L unless L is very large
+    int taps_;        // per row, a multiple of 8
+    int center_;      // input samples before the position that a row reaches back
+    std::vector<float> bank_;  // phases_ x taps_, plus a row at fraction 1 when rounding
+
+    // Stream state. Positions count from the start of the stream, less whole
+    // cycles of M input / L output frames once they are done with.
+    std::vector<std::vector<float>> history_;  // per channel, from historyStart_
+    int64_t historyStart_ = 0;
+    int64_t streamIn_ = 0;    // input frames pushed
+    int64_t streamOut_ = 0;   // output frames written
+};
+
+} // namespace WhisperApp
+
+#endif // AUDIORESAMPLER_H
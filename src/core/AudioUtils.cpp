@@ -5,34 +5,390 @@
  */
 
 #include "AudioUtils.h"
+#include "SimdSupport.h"
 #include <cmath>
 #include <algorithm>
 #include <numeric>
 #include <fstream>
 #include <cstring>
+#include <bitset>
 
 namespace AudioUtils {
 
+namespace {
+
+// Squares are summed in float over blocks of this many samples, spread across
+// the vector lanes, and each block total is added to a double. A lane then
+// sums a few hundred values, so the result stays accurate on hour-long buffers.
+constexpr size_t kSumBlock = 4096;
+
+// What a scan computes; each kernel is instantiated per combination
+enum ScanFields : unsigned {
+    kSquares = 1,
+    kPeak = 2,
+    kCrossings = 4,
+    kClipped = 8,
+};
+
+struct Scan {
+    double squares = 0.0;
+    float peak = 0.0f;
+    size_t crossings = 0;   // sign changes between neighbouring samples
+    size_t clipped = 0;     // samples with |x| > 1
+};
+
+inline size_t popcount(unsigned bits) {
+    return std::bitset<32>(bits).count();
+}
+
+// Scans x[i, n) one sample at a time; x[i - 1] must be readable. NaNs are
+// skipped by the peak and count as negative for crossings, as in the kernels.
+template <unsigned What>
+void scanTail(const float* x, size_t i, size_t n, float& squares, Scan& s) {
+    for (; i < n; ++i) {
+        const float v = x[i];
+        if constexpr ((What & kSquares) != 0) {
+            squares += v * v;
+        }
+        if constexpr ((What & kPeak) != 0) {
+            s.peak = std::max(s.peak, std::abs(v));
+        }
+        if constexpr ((What & kCrossings) != 0) {
+            s.crossings += (v >= 0.0f) != (x[i - 1] >= 0.0f);
+        }
+        if constexpr ((What & kClipped) != 0) {
+            s.clipped += std::abs(v) > 1.0f;
+        }
+    }
+}
+
+#if defined(WHISPERAPP_SIMD_AVX2)
+const bool kHasAvx2 = WhisperApp::cpuHasAvx2();
+
+WHISPERAPP_TARGET_AVX2
+inline float sumAvx2(__m256 v) {
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+    return _mm_cvtss_f32(sum);
+}
+
+WHISPERAPP_TARGET_AVX2
+inline float maxAvx2(__m256 v) {
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+    return _mm_cvtss_f32(m);
+}
+
+// Scans x[0, n), n <= kSumBlock, sixteen samples per step. Crossings compare
+// sign masks shifted by one sample, so x[-1] is read only once.
+template <unsigned What>
+WHISPERAPP_TARGET_AVX2
+void scanBlockAvx2(const float* x, size_t n, Scan& s) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    __m256 sq0 = zero, sq1 = zero;
+    __m256 pk0 = zero, pk1 = zero;
+    unsigned last = x[-1] >= 0.0f;
+    size_t crossings = 0;
+    size_t clipped = 0;
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256 a = _mm256_loadu_ps(x + i);
+        const __m256 b = _mm256_loadu_ps(x + i + 8);
+        if constexpr ((What & kSquares) != 0) {
+            sq0 = _mm256_fmadd_ps(a, a, sq0);
+            sq1 = _mm256_fmadd_ps(b, b, sq1);
+        }
+        const __m256 absA = _mm256_and_ps(a, absMask);
+        const __m256 absB = _mm256_and_ps(b, absMask);
+        if constexpr ((What & kPeak) != 0) {
+            // max returns its second operand for NaN, so NaNs leave the peak alone
+            pk0 = _mm256_max_ps(absA, pk0);
+            pk1 = _mm256_max_ps(absB, pk1);
+        }
+        if constexpr ((What & kCrossings) != 0) {
+            const unsigned ge =
+                unsigned(_mm256_movemask_ps(_mm256_cmp_ps(a, zero, _CMP_GE_OQ))) |
+                unsigned(_mm256_movemask_ps(_mm256_cmp_ps(b, zero, _CMP_GE_OQ))) << 8;
+            crossings += popcount((ge ^ ((ge << 1) | last)) & 0xffff);
+            last = ge >> 15;
+        }
+        if constexpr ((What & kClipped) != 0) {
+            clipped += popcount(
+                unsigned(_mm256_movemask_ps(_mm256_cmp_ps(absA, one, _CMP_GT_OQ))) |
+                unsigned(_mm256_movemask_ps(_mm256_cmp_ps(absB, one, _CMP_GT_OQ))) << 8);
+        }
+    }
+
+    float squares = sumAvx2(_mm256_add_ps(sq0, sq1));
+    s.peak = std::max(s.peak, maxAvx2(_mm256_max_ps(pk0, pk1)));
+    s.crossings += crossings;
+    s.clipped += clipped;
+    scanTail<What>(x, i, n, squares, s);
+    s.squares += squares;
+}
+
+// Clamps x[0, n) to [-limit, limit] and returns how many samples it changed
+WHISPERAPP_TARGET_AVX2
+size_t clipAvx2(float* x, size_t n, float limit) {
+    const __m256 hi = _mm256_set1_ps(limit);
+    const __m256 lo = _mm256_set1_ps(-limit);
+    size_t clipped = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 v = _mm256_loadu_ps(x + i);
+        const __m256 out = _mm256_or_ps(_mm256_cmp_ps(v, hi, _CMP_GT_OQ),
+                                        _mm256_cmp_ps(v, lo, _CMP_LT_OQ));
+        clipped += popcount(unsigned(_mm256_movemask_ps(out)));
+        // NaN is the second operand of both, so it passes through unchanged
+        _mm256_storeu_ps(x + i, _mm256_max_ps(lo, _mm256_min_ps(hi, v)));
+    }
+    for (; i < n; ++i) {
+        if (x[i] > limit) {
+            x[i] = limit;
+            ++clipped;
+        } else if (x[i] < -limit) {
+            x[i] = -limit;
+            ++clipped;
+        }
+    }
+    return clipped;
+}
+#endif
+
+#if defined(WHISPERAPP_SIMD_SSE)
+inline float sumSse(__m128 v) {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+inline float maxSse(__m128 v) {
+    v = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_max_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+}
+
+// SSE2 counterpart of scanBlockAvx2, eight samples per step
+template <unsigned What>
+void scanBlock(const float* x, size_t n, Scan& s) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128 sq0 = zero, sq1 = zero;
+    __m128 pk0 = zero, pk1 = zero;
+    unsigned last = x[-1] >= 0.0f;
+    size_t crossings = 0;
+    size_t clipped = 0;
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m128 a = _mm_loadu_ps(x + i);
+        const __m128 b = _mm_loadu_ps(x + i + 4);
+        if constexpr ((What & kSquares) != 0) {
+            sq0 = _mm_add_ps(sq0, _mm_mul_ps(a, a));
+            sq1 = _mm_add_ps(sq1, _mm_mul_ps(b, b));
+        }
+        const __m128 absA = _mm_and_ps(a, absMask);
+        const __m128 absB = _mm_and_ps(b, absMask);
+        if constexpr ((What & kPeak) != 0) {
+            pk0 = _mm_max_ps(absA, pk0);
+            pk1 = _mm_max_ps(absB, pk1);
+        }
+        if constexpr ((What & kCrossings) != 0) {
+            const unsigned ge = unsigned(_mm_movemask_ps(_mm_cmpge_ps(a, zero))) |
+                                unsigned(_mm_movemask_ps(_mm_cmpge_ps(b, zero))) << 4;
+            crossings += popcount((ge ^ ((ge << 1) | last)) & 0xff);
+            last = ge >> 7;
+        }
+        if constexpr ((What & kClipped) != 0) {
+            clipped += popcount(unsigned(_mm_movemask_ps(_mm_cmpgt_ps(absA, one))) |
+                                unsigned(_mm_movemask_ps(_mm_cmpgt_ps(absB, one))) << 4);
+        }
+    }
+
+    float squares = sumSse(_mm_add_ps(sq0, sq1));
+    s.peak = std::max(s.peak, maxSse(_mm_max_ps(pk0, pk1)));
+    s.crossings += crossings;
+    s.clipped += clipped;
+    scanTail<What>(x, i, n, squares, s);
+    s.squares += squares;
+}
+
+size_t clipBlock(float* x, size_t n, float limit) {
+    const __m128 hi = _mm_set1_ps(limit);
+    const __m128 lo = _mm_set1_ps(-limit);
+    size_t clipped = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 v = _mm_loadu_ps(x + i);
+        const __m128 out = _mm_or_ps(_mm_cmpgt_ps(v, hi), _mm_cmplt_ps(v, lo));
+        clipped += popcount(unsigned(_mm_movemask_ps(out)));
+        _mm_storeu_ps(x + i, _mm_max_ps(lo, _mm_min_ps(hi, v)));
+    }
+    for (; i < n; ++i) {
+        if (x[i] > limit) {
+            x[i] = limit;
+            ++clipped;
+        } else if (x[i] < -limit) {
+            x[i] = -limit;
+            ++clipped;
+        }
+    }
+    return clipped;
+}
+#elif defined(WHISPERAPP_SIMD_NEON)
+// NEON has no movemask; compare results are all-ones lanes, and subtracting
+// them counts one per lane. Crossings compare against the load shifted by one.
+template <unsigned What>
+void scanBlock(const float* x, size_t n, Scan& s) {
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    float32x4_t sq0 = zero, sq1 = zero;
+    float32x4_t pk0 = zero, pk1 = zero;
+    uint32x4_t crossings = vdupq_n_u32(0);
+    uint32x4_t clipped = vdupq_n_u32(0);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const float32x4_t a = vld1q_f32(x + i);
+        const float32x4_t b = vld1q_f32(x + i + 4);
+        if constexpr ((What & kSquares) != 0) {
+            sq0 = vmlaq_f32(sq0, a, a);
+            sq1 = vmlaq_f32(sq1, b, b);
+        }
+        const float32x4_t absA = vabsq_f32(a);
+        const float32x4_t absB = vabsq_f32(b);
+        if constexpr ((What & kPeak) != 0) {
+            // vmaxnm ignores NaN like the scalar path; vmax would propagate it
+#if defined(__aarch64__) || defined(_M_ARM64)
+            pk0 = vmaxnmq_f32(pk0, absA);
+            pk1 = vmaxnmq_f32(pk1, absB);
+#else
+            pk0 = vbslq_f32(vcgtq_f32(absA, pk0), absA, pk0);
+            pk1 = vbslq_f32(vcgtq_f32(absB, pk1), absB, pk1);
+#endif
+        }
+        if constexpr ((What & kCrossings) != 0) {
+            const uint32x4_t geA = vcgeq_f32(a, zero);
+            const uint32x4_t geB = vcgeq_f32(b, zero);
+            const uint32x4_t prevA = vcgeq_f32(vld1q_f32(x + i - 1), zero);
+            const uint32x4_t prevB = vcgeq_f32(vld1q_f32(x + i + 3), zero);
+            crossings = vsubq_u32(crossings, veorq_u32(geA, prevA));
+            crossings = vsubq_u32(crossings, veorq_u32(geB, prevB));
+        }
+        if constexpr ((What & kClipped) != 0) {
+            clipped = vsubq_u32(clipped, vcgtq_f32(absA, one));
+            clipped = vsubq_u32(clipped, vcgtq_f32(absB, one));
+        }
+    }
+
+    const float32x4_t sq = vaddq_f32(sq0, sq1);
+    float32x2_t sum = vadd_f32(vget_low_f32(sq), vget_high_f32(sq));
+    float squares = vget_lane_f32(vpadd_f32(sum, sum), 0);
+    const float32x4_t pk = vmaxq_f32(pk0, pk1);
+    float32x2_t peak = vmax_f32(vget_low_f32(pk), vget_high_f32(pk));
+    s.peak = std::max(s.peak, vget_lane_f32(vpmax_f32(peak, peak), 0));
+    uint32x2_t count = vadd_u32(vget_low_u32(crossings), vget_high_u32(crossings));
+    s.crossings += vget_lane_u32(vpadd_u32(count, count), 0);
+    count = vadd_u32(vget_low_u32(clipped), vget_high_u32(clipped));
+    s.clipped += vget_lane_u32(vpadd_u32(count, count), 0);
+    scanTail<What>(x, i, n, squares, s);
+    s.squares += squares;
+}
+
+size_t clipBlock(float* x, size_t n, float limit) {
+    const float32x4_t hi = vdupq_n_f32(limit);
+    const float32x4_t lo = vdupq_n_f32(-limit);
+    uint32x4_t clipped = vdupq_n_u32(0);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const float32x4_t v = vld1q_f32(x + i);
+        const uint32x4_t above = vcgtq_f32(v, hi);
+        const uint32x4_t below = vcltq_f32(v, lo);
+        clipped = vsubq_u32(clipped, vorrq_u32(above, below));
+        vst1q_f32(x + i, vbslq_f32(above, hi, vbslq_f32(below, lo, v)));
+    }
+    uint32x2_t count = vadd_u32(vget_low_u32(clipped), vget_high_u32(clipped));
+    size_t total = vget_lane_u32(vpadd_u32(count, count), 0);
+    for (; i < n; ++i) {
+        if (x[i] > limit) {
+            x[i] = limit;
+            ++total;
+        } else if (x[i] < -limit) {
+            x[i] = -limit;
+            ++total;
+        }
+    }
+    return total;
+}
+#else
+template <unsigned What>
+void scanBlock(const float* x, size_t n, Scan& s) {
+    // With a single float sum, keep the partial sums as short as a vector lane's
+    for (size_t i = 0; i < n; i += 256) {
+        float squares = 0.0f;
+        scanTail<What>(x, i, std::min(n, i + 256), squares, s);
+        s.squares += squares;
+    }
+}
+
+size_t clipBlock(float* x, size_t n, float limit) {
+    size_t clipped = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (x[i] > limit) {
+            x[i] = limit;
+            ++clipped;
+        } else if (x[i] < -limit) {
+            x[i] = -limit;
+            ++clipped;
+        }
+    }
+    return clipped;
+}
+#endif
+
+// One pass over the samples computing the fields in What
+template <unsigned What>
+Scan scan(const float* samples, size_t count) {
+    Scan s;
+    if (count == 0) {
+        return s;
+    }
+
+    // The first sample has no predecessor; the blocks start after it
+    float first = 0.0f;
+    scanTail<What & ~unsigned(kCrossings)>(samples, 0, 1, first, s);
+    s.squares = first;
+
+    for (size_t i = 1; i < count; i += kSumBlock) {
+        const size_t n = std::min(kSumBlock, count - i);
+#if defined(WHISPERAPP_SIMD_AVX2)
+        if (kHasAvx2) {
+            scanBlockAvx2<What>(samples + i, n, s);
+            continue;
+        }
+#endif
+        scanBlock<What>(samples + i, n, s);
+    }
+    return s;
+}
+
+} // namespace
+
 float calculateRMS(const float* samples, size_t count) {
     if (count == 0) return 0.0f;
     
-    float sum = 0.0f;
-    for (size_t i = 0; i < count; ++i) {
-        sum += samples[i] * samples[i];
-    }
-    
-    return std::sqrt(sum / count);
+    const Scan s = scan<kSquares>(samples, count);
+    return static_cast<float>(std::sqrt(s.squares / count));
 }
 
 float calculatePeak(const float* samples, size_t count) {
-    if (count == 0) return 0.0f;
-    
-    float peak = 0.0f;
-    for (size_t i = 0; i < count; ++i) {
-        peak = std::max(peak, std::abs(samples[i]));
-    }
-    
-    return peak;
+    return scan<kPeak>(samples, count).peak;
 }
 
 AudioStats calculateStats(const float* samples, size_t count) {
@@ -40,10 +396,12 @@ AudioStats calculateStats(const float* samples, size_t count) {
     
     if (count == 0) return stats;
     
-    stats.rms = calculateRMS(samples, count);
-    stats.peak = calculatePeak(samples, count);
+    const Scan s = scan<kSquares | kPeak | kCrossings | kClipped>(samples, count);
+    stats.rms = static_cast<float>(std::sqrt(s.squares / count));
+    stats.peak = s.peak;
     stats.crest_factor = (stats.rms > 0) ? (stats.peak / stats.rms) : 0.0f;
-    stats.zero_crossings = calculateZeroCrossingRate(samples, count);
+    stats.zero_crossings = (count < 2) ? 0.0f : float(s.crossings) / (count - 1);
+    stats.clipped = s.clipped;
     
     return stats;
 }
@@ -138,12 +496,14 @@ std::vector<float> resample(const float* input, size_t input_count,
 
 std::vector<float> stereoToMono(const float* stereo, size_t sample_count) {
     std::vector<float> mono(sample_count);
-    
+    stereoToMono(stereo, sample_count, mono.data());
+    return mono;
+}
+
+void stereoToMono(const float* stereo, size_t sample_count, float* mono) {
     for (size_t i = 0; i < sample_count; ++i) {
         mono[i] = (stereo[i * 2] + stereo[i * 2 + 1]) * 0.5f;
     }
-    
-    return mono;
 }
 
 void normalize(float* samples, size_t count, float target_peak) {
@@ -266,14 +626,7 @@ void preEmphasis(float* samples, size_t count, float coefficient) {
 float calculateZeroCrossingRate(const float* samples, size_t count) {
     if (count < 2) return 0.0f;
     
-    size_t crossings = 0;
-    for (size_t i = 1; i < count; ++i) {
-        if ((samples[i] >= 0) != (samples[i - 1] >= 0)) {
-            crossings++;
-        }
-    }
-    
-    return float(crossings) / (count - 1);
+    return float(scan<kCrossings>(samples, count).crossings) / (count - 1);
 }
 
 std::vector<bool> detectVoiceActivity(const float* samples, size_t count,
@@ -285,8 +638,9 @@ std::vector<bool> detectVoiceActivity(const float* samples, size_t count,
     for (size_t frame = 0; frame < num_frames; ++frame) {
         const float* frame_start = samples + (frame * frame_size);
         
-        float energy = calculateRMS(frame_start, frame_size);
-        float zcr = calculateZeroCrossingRate(frame_start, frame_size);
+        const Scan s = scan<kSquares | kCrossings>(frame_start, frame_size);
+        float energy = static_cast<float>(std::sqrt(s.squares / frame_size));
+        float zcr = (frame_size < 2) ? 0.0f : float(s.crossings) / (frame_size - 1);
         
         // Simple VAD: high energy and moderate ZCR indicates voice
         vad_results[frame] = (energy > energy_threshold) && 
@@ -313,6 +667,16 @@ void removeDCOffset(float* samples, size_t count, float cutoff_freq, float sampl
 }
 
 size_t clipAudio(float* samples, size_t count, float max_value) {
+    // The kernels assume lo <= hi; a negative or NaN limit keeps the scalar rules
+    if (max_value >= 0.0f) {
+#if defined(WHISPERAPP_SIMD_AVX2)
+        if (kHasAvx2) {
+            return clipAvx2(samples, count, max_value);
+        }
+#endif
+        return clipBlock(samples, count, max_value);
+    }
+    
     size_t clipped_count = 0;
     
     for (size_t i = 0; i < count; ++i) {
@@ -22,6 +22,7 @@ struct AudioStats {
     float peak;         // Peak amplitude
     float crest_factor; // Peak to RMS ratio
     float zero_crossings; // Zero crossing rate
+    size_t clipped;     // Samples beyond full scale (|x| > 1)
 };
 
 /**
@@ -41,7 +42,7 @@ float calculateRMS(const float* samples, size_t count);
 float calculatePeak(const float* samples, size_t count);
 
 /**
- * @brief Calculate audio statistics
+ * @brief Calculate audio statistics in a single pass over the samples
  * @param samples Audio samples
  * @param count Number of samples
  * @return Audio statistics
@@ -102,6 +103,14 @@ std::vector<float> resample(const float* input, size_t input_count,
  */
 std::vector<float> stereoToMono(const float* stereo, size_t sample_count);
 
+/**
+ * @brief Convert stereo to mono into a caller buffer
+ * @param stereo Stereo samples (interleaved L,R,L,R...)
+ * @param sample_count Number of stereo samples (total samples / 2)
+ * @param mono Receives sample_count samples; may be stereo itself
+ */
+void stereoToMono(const float* stereo, size_t sample_count, float* mono);
+
 /**
  * @brief Normalize audio to specified peak level
  * @param samples Audio samples (modified in place)
@@ -51,6 +51,7 @@ enum class ErrorCode {
     TranscriptionInProgress = 302,
     TranscriptionCancelled = 303,
     TranscriptionLanguageUnsupported = 304,
+    TranscriptionQueueFull = 305,
     
     // File system errors (400-499)
     FileNotFound = 400,
@@ -121,6 +122,7 @@ inline std::string getErrorMessage(ErrorCode code) {
         {ErrorCode::TranscriptionInProgress, "A transcription is already in progress. Please wait for it to complete."},
         {ErrorCode::TranscriptionCancelled, "The transcription was cancelled. You can start a new recording whenever you're ready."},
         {ErrorCode::TranscriptionLanguageUnsupported, "The selected language is not supported. Please choose a different language."},
+        {ErrorCode::TranscriptionQueueFull, "Too many transcriptions are waiting. Please wait for some to finish and try again."},
         
         // File system errors
         {ErrorCode::FileNotFound, "The requested file could not be found. Please check the file path and try again."},
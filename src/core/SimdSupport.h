@@ -0,0 +1,62 @@
+/*
+ * SimdSupport.h
+ *
+ * Instruction set selection shared by the vectorized audio kernels.
+ */
+
+#ifndef SIMDSUPPORT_H
+#define SIMDSUPPORT_H
+
+// SSE2 is the x86-64 baseline and NEON the AArch64 one, so those are chosen
+// at compile time. AVX2 code is compiled alongside with a target attribute
+// and only taken when cpuHasAvx2() says the CPU and OS support it.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define WHISPERAPP_SIMD_SSE
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define WHISPERAPP_SIMD_AVX2
+#define WHISPERAPP_TARGET_AVX2
+#elif defined(__GNUC__) || defined(__clang__)
+#define WHISPERAPP_SIMD_AVX2
+#define WHISPERAPP_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define WHISPERAPP_SIMD_NEON
+#endif
+
+namespace WhisperApp {
+
+#if defined(WHISPERAPP_SIMD_AVX2)
+/**
+ * @brief Whether AVX2 and FMA can be used on this machine
+ *
+ * Checks the CPU flags and that the OS saves the YMM registers.
+ */
+inline bool cpuHasAvx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    if (!fma || !osxsave || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    // May run from a static initializer, before the runtime has probed the CPU
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+}
+#endif
+
+} // namespace WhisperApp
+
+#endif // SIMDSUPPORT_H
@@ -8,6 +8,8 @@
  * Features:
  * - Model loading and management
  * - Audio transcription (synchronous and asynchronous)
+ * - Priority job queue for asynchronous transcriptions
+ * - Streaming transcription over a sliding window
  * - Language detection and selection
  * - Performance optimization settings
  */
@@ -20,6 +22,8 @@
 #include <memory>
 #include <functional>
 #include <thread>
+#include <chrono>
+#include <cstdint>
 
 // Forward declarations
 struct whisper_context;
@@ -41,8 +45,13 @@ public:
         int max_threads = 0;                // 0 = auto-detect
         bool print_timestamps = false;      // Include timestamps in output
         bool print_special_tokens = false;  // Include special tokens
-        int beam_size = 5;                  // Beam search size
+        int beam_size = 5;                  // Beam search size (1 = greedy)
+        int best_of = 5;                    // Samples kept when greedy with temperature > 0
         float temperature = 0.0f;           // Sampling temperature
+        float temperature_increment = 0.2f; // Added per fallback re-decode (0 = no fallback)
+        float entropy_threshold = 2.4f;     // Re-decode when token entropy is lower (repetition)
+        float logprob_threshold = -1.0f;    // Re-decode when average log-probability is lower
+        float no_speech_threshold = 0.6f;   // Skip audio with a higher no-speech probability
         bool detect_language = false;       // Auto-detect language
     };
 
@@ -64,6 +73,64 @@ public:
         std::vector<Segment> segments;      // Individual segments with timing
     };
 
+    /**
+     * @brief Memory of the loaded model, in bytes
+     *
+     * The weights are shared by all states; each state of the pool (one per
+     * concurrent transcription) needs the K/V caches, the mel and the compute
+     * buffers for itself. The compute figure is the peak that ggml-alloc lays out
+     * for the encoder plus that of a decoder step.
+     */
+    struct MemoryReport {
+        size_t weights_bytes = 0;           // Tensor data of the model
+        size_t kv_self_bytes = 0;           // Decoder self-attention K/V, per state
+        size_t kv_cross_bytes = 0;          // Cross-attention K/V, per state
+        size_t mel_bytes = 0;               // Log-mel input, per state
+        size_t compute_bytes = 0;           // Encoder and decoder compute buffers, per state
+        size_t state_bytes = 0;             // Sum of the per-state figures
+        int n_states = 0;                   // States allocated now, idle or in use
+        size_t total_bytes = 0;             // weights_bytes + n_states * state_bytes
+
+        /**
+         * @brief Number of states that fit in a budget next to the weights (0 if the weights don't)
+         */
+        int statesWithin(size_t budget_bytes) const;
+    };
+
+    /**
+     * @brief Shared, immutable view of audio samples (16kHz, mono, float32)
+     *
+     * Holds a reference to whatever owns the samples, so a vector, a capture
+     * buffer or a memory-mapped file can be queued without copying it.
+     */
+    class AudioBuffer {
+    public:
+        AudioBuffer() = default;
+
+        /**
+         * @brief Share the contents of a vector
+         */
+        AudioBuffer(std::shared_ptr<const std::vector<float>> samples)
+            : data_(samples ? samples->data() : nullptr)
+            , size_(samples ? samples->size() : 0)
+            , owner_(std::move(samples)) {}
+
+        /**
+         * @brief Refer to samples kept alive by owner
+         */
+        AudioBuffer(const float* data, size_t size, std::shared_ptr<const void> owner)
+            : data_(data), size_(size), owner_(std::move(owner)) {}
+
+        const float* data() const { return data_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+    private:
+        const float* data_ = nullptr;
+        size_t size_ = 0;
+        std::shared_ptr<const void> owner_;
+    };
+
     /**
      * @brief Progress callback function type
      */
@@ -74,6 +141,138 @@ public:
      */
     using ResultCallback = std::function<void(const TranscriptionResult& result)>;
 
+    /**
+     * @brief Scheduling priority of a queued job; higher runs first, FIFO within a level
+     */
+    enum class JobPriority {
+        Low = 0,
+        Normal = 1,
+        High = 2
+    };
+
+    /**
+     * @brief Lifecycle of a queued job
+     */
+    enum class JobStatus {
+        Queued,
+        Running,
+        Completed,
+        Cancelled,
+        Failed
+    };
+
+    /**
+     * @brief Handle to a submitted transcription job
+     *
+     * Copies refer to the same job. Handles stay valid after the engine is
+     * destroyed; jobs still pending at that point end up Cancelled.
+     */
+    class JobHandle {
+    public:
+        JobHandle() = default;
+
+        /**
+         * @brief Check if the handle refers to a job
+         */
+        bool isValid() const;
+
+        /**
+         * @brief Get the job id (0 for an empty handle)
+         */
+        uint64_t getId() const;
+
+        /**
+         * @brief Get the current job status
+         */
+        JobStatus getStatus() const;
+
+        /**
+         * @brief Cancel the job
+         * @return true if the job had not finished yet
+         *
+         * A queued job finishes immediately and its result callback runs on the
+         * calling thread; a running job stops at the next cancellation point.
+         */
+        bool cancel();
+
+        /**
+         * @brief Block until the job has finished
+         * @return The job result (error text if it failed or was cancelled)
+         */
+        TranscriptionResult wait() const;
+
+        /**
+         * @brief Block until the job has finished or the timeout expires
+         * @return true if the job has finished
+         */
+        bool waitFor(std::chrono::milliseconds timeout) const;
+
+    private:
+        friend class WhisperEngine;
+        struct Job;
+        std::shared_ptr<Job> job;
+    };
+
+    /**
+     * @brief Streaming session parameters
+     */
+    struct StreamingParams {
+        TranscriptionParams transcription;  // Language, translation, ...
+        int step_ms = 500;                  // Decode whenever this much new audio arrived
+        int length_ms = 5000;               // Window length; a full window is committed
+        int keep_ms = 200;                  // Audio overlap carried into the next window
+        int max_prompt_tokens = 64;         // Committed tokens carried over as decoder prompt
+    };
+
+    /**
+     * @brief Streaming segment callback
+     *
+     * A tentative segment covers the current window and is superseded by the next
+     * update; a stable segment is final and never revised.
+     */
+    using SegmentCallback = std::function<void(const TranscriptionResult::Segment& segment, bool stable)>;
+
+    /**
+     * @brief Live transcription over a sliding window
+     *
+     * Audio is pushed in small chunks. A session thread re-decodes the current
+     * window every step and reports it as tentative; once the window is full it is
+     * committed as stable and the next window starts with a short overlap, using
+     * the committed text as prompt. A session must not outlive its engine.
+     */
+    class StreamingSession {
+    public:
+        ~StreamingSession();
+
+        StreamingSession(const StreamingSession&) = delete;
+        StreamingSession& operator=(const StreamingSession&) = delete;
+
+        /**
+         * @brief Append audio to the stream
+         * @param samples Audio samples (16kHz, mono, float32)
+         * @param n_samples Number of samples
+         */
+        void pushAudio(const float* samples, size_t n_samples);
+        void pushAudio(const std::vector<float>& samples);
+
+        /**
+         * @brief Commit the remaining audio and end the session
+         * @return All stable segments, or an error result if decoding failed
+         */
+        TranscriptionResult finish();
+
+        /**
+         * @brief Check if the session still accepts audio
+         */
+        bool isActive() const;
+
+    private:
+        friend class WhisperEngine;
+        struct State;
+        explicit StreamingSession(std::unique_ptr<State> session_state);
+        std::unique_ptr<State> state;
+    };
+
 public:
     WhisperEngine();
     ~WhisperEngine();
@@ -86,11 +285,40 @@ public:
      * @brief Load a whisper model from file
      * @param model_path Path to the model file (.bin or .gguf)
      * @return true if successful, false otherwise
+     *
+     * The current model keeps serving while the new one loads and stays loaded if
+     * loading fails. Transcriptions already running finish on the previous model,
+     * which is freed after the last of them. A model preloaded with preloadModel()
+     * is taken from the warm pool. Returns false as well if a later load or unload
+     * request superseded this one.
      */
     bool loadModel(const std::string& model_path);
 
+    /**
+     * @brief Load a whisper model in the background and swap it in when it is ready
+     * @param model_path Path to the model file (.bin or .gguf)
+     * @param on_loaded Optional callback with the outcome, called on a background thread
+     *
+     * Does not block; transcriptions use the current model until the swap. Of
+     * several requests in flight, only the latest one swaps its model in.
+     */
+    void loadModelAsync(const std::string& model_path,
+                        std::function<void(bool)> on_loaded = nullptr);
+
+    /**
+     * @brief Start loading a model in the background for a later loadModel() call
+     * @param model_path Path to the model file (.bin or .gguf)
+     * @return false if the path is empty
+     *
+     * The preloaded model is kept in a warm pool next to the current model until
+     * loadModel() or loadModelAsync() with the same path takes it.
+     */
+    bool preloadModel(const std::string& model_path);
+
     /**
      * @brief Unload the current model
+     *
+     * Transcriptions already running finish first; the model is freed after them.
      */
     void unloadModel();
 
@@ -106,6 +334,38 @@ public:
      */
     std::string getModelInfo() const;
 
+    /**
+     * @brief Get the memory of the loaded model and its state pool
+     * @return All zero if no model is loaded
+     *
+     * Use statesWithin() to size the pool for a memory budget, e.g. when packing
+     * engines onto a host: setStatePoolSize(report.statesWithin(budget)).
+     */
+    MemoryReport getMemoryReport() const;
+
+    /**
+     * @brief Load a larger model that decodes low-confidence segments again
+     * @param model_path Path to the larger model, e.g. ModelManager::getModelPath("medium")
+     * @param confidence_threshold Segments of the loaded model below this confidence are decoded again
+     * @return true if successful, false otherwise
+     *
+     * Transcriptions run on the loaded (fast) model first; only the audio of its
+     * segments below the threshold is decoded by the cascade model, whose segments
+     * replace them. Streaming sessions are not cascaded.
+     */
+    bool loadCascadeModel(const std::string& model_path, float confidence_threshold = 0.6f);
+
+    /**
+     * @brief Unload the cascade model; transcriptions use the loaded model only
+     */
+    void unloadCascadeModel();
+
+    /**
+     * @brief Check if a cascade model is loaded
+     * @return true if low-confidence segments are decoded again
+     */
+    bool isCascadeEnabled() const;
+
     /**
      * @brief Transcribe audio data synchronously
      * @param audio_data Audio samples (16kHz, mono, float32)
@@ -117,12 +377,27 @@ public:
         const TranscriptionParams& params = TranscriptionParams()
     );
 
+    /**
+     * @brief Transcribe audio samples synchronously without copying them
+     * @param samples Audio samples (16kHz, mono, float32); only read during the call
+     * @param n_samples Number of samples
+     * @param params Transcription parameters
+     * @return Transcription result
+     */
+    TranscriptionResult transcribeAudio(
+        const float* samples,
+        size_t n_samples,
+        const TranscriptionParams& params = TranscriptionParams()
+    );
+
     /**
      * @brief Transcribe audio data asynchronously
      * @param audio_data Audio samples (16kHz, mono, float32)
      * @param params Transcription parameters
      * @param on_result Callback for result
      * @param on_progress Optional progress callback
+     *
+     * Equivalent to submitTranscription() at normal priority.
      */
     void transcribeAudioAsync(
         const std::vector<float>& audio_data,
@@ -132,7 +407,68 @@ public:
     );
 
     /**
-     * @brief Cancel any ongoing asynchronous transcription
+     * @brief Transcribe a shared audio buffer asynchronously without copying it
+     */
+    void transcribeAudioAsync(
+        AudioBuffer audio,
+        const TranscriptionParams& params,
+        ResultCallback on_result,
+        ProgressCallback on_progress = nullptr
+    );
+
+    /**
+     * @brief Queue audio for transcription on the engine's worker threads
+     * @param audio_data Audio samples (16kHz, mono, float32); moved into the job
+     * @param params Transcription parameters
+     * @param on_result Optional callback, invoked on a worker thread when the job ends
+     * @param on_progress Optional callback, invoked on a worker thread as decoding advances
+     * @param priority Scheduling priority
+     * @return Handle to the job; if the queue is full the job has already Failed
+     */
+    JobHandle submitTranscription(
+        std::vector<float> audio_data,
+        const TranscriptionParams& params,
+        ResultCallback on_result = nullptr,
+        ProgressCallback on_progress = nullptr,
+        JobPriority priority = JobPriority::Normal
+    );
+
+    /**
+     * @brief Queue a shared audio buffer for transcription without copying it
+     * @param audio Samples; the job keeps the buffer alive until it finishes
+     */
+    JobHandle submitTranscription(
+        AudioBuffer audio,
+        const TranscriptionParams& params,
+        ResultCallback on_result = nullptr,
+        ProgressCallback on_progress = nullptr,
+        JobPriority priority = JobPriority::Normal
+    );
+
+    /**
+     * @brief Set the maximum number of jobs waiting in the queue
+     * @param max_jobs Queue capacity; submissions beyond it fail
+     */
+    void setMaxQueuedJobs(size_t max_jobs);
+
+    /**
+     * @brief Get the number of jobs waiting to run
+     */
+    size_t getQueuedJobCount() const;
+
+    /**
+     * @brief Start a streaming transcription session
+     * @param params Window and transcription parameters
+     * @param on_segment Callback for segments, invoked on the session thread
+     * @return The session, or nullptr if no model is loaded
+     */
+    std::unique_ptr<StreamingSession> startStreaming(
+        const StreamingParams& params,
+        SegmentCallback on_segment
+    );
+
+    /**
+     * @brief Cancel all queued and running transcriptions and streaming sessions
      */
     void cancelTranscription();
 
@@ -167,6 +503,32 @@ public:
      */
     int getThreadCount() const;
 
+    /**
+     * @brief Set how many transcriptions may decode in parallel on the loaded model
+     * @param pool_size Number of whisper states sharing one copy of the weights (0 = auto)
+     *
+     * Each running transcription borrows a state from the pool; further calls wait
+     * until one is returned. The thread count is split evenly across the pool.
+     * The automatic size is one state per four threads, and at least two.
+     */
+    void setStatePoolSize(int pool_size);
+
+    /**
+     * @brief Get the effective state pool size
+     * @return Maximum number of concurrent transcriptions
+     */
+    int getStatePoolSize() const;
+
+    /**
+     * @brief Set the memory bound of the encoder output cache
+     * @param max_bytes Bytes kept for cached encoder outputs (0 = disabled)
+     *
+     * Encoder outputs are kept per audio content and model, least recently used
+     * first out, so transcribing the same audio again with other parameters
+     * (language, temperature, beam size) only runs the decoder.
+     */
+    void setEncoderCacheSize(size_t max_bytes);
+
     /**
      * @brief Enable or disable GPU acceleration (if available)
      * @param enable true to enable GPU, false to disable
@@ -36,6 +36,16 @@ protected:
         }
         return true;
     }
+    
+    // Amplitude of one frequency, by correlating with a complex exponential
+    double toneLevel(const std::vector<float>& x, double freq, int rate) {
+        double re = 0.0, im = 0.0;
+        for (size_t i = 0; i < x.size(); ++i) {
+            re += x[i] * std::cos(2.0 * M_PI * freq * i / rate);
+            im += x[i] * std::sin(2.0 * M_PI * freq * i / rate);
+        }
+        return 2.0 * std::sqrt(re * re + im * im) / x.size();
+    }
 };
 
 // Format conversion tests
@@ -182,6 +192,44 @@ TEST_F(AudioConverterTest, NoResamplingNeeded) {
     EXPECT_TRUE(areBuffersSimilar(input, output));
 }
 
+TEST_F(AudioConverterTest, DownsamplingRejectsAliases) {
+    // 10 kHz is above the 8 kHz Nyquist limit of the output; a linear
+    // interpolator folds it back to 6 kHz almost unattenuated
+    int inputRate = 48000;
+    int outputRate = 16000;
+    std::vector<float> tone = AudioGenerator::generateSineWave(1000.0f, 1.0f, inputRate);
+    std::vector<float> high = AudioGenerator::generateSineWave(10000.0f, 1.0f, inputRate);
+    std::vector<float> input(tone.size());
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = tone[i] + high[i];
+    }
+    
+    for (auto quality : {ConversionQuality::Low, ConversionQuality::Medium,
+                         ConversionQuality::High, ConversionQuality::Best}) {
+        auto output = AudioConverter::resample(input, inputRate, outputRate, quality);
+        ASSERT_EQ(output.size(), input.size() / 3);
+        EXPECT_NEAR(toneLevel(output, 1000.0, outputRate), 0.5, 0.005);
+        EXPECT_LT(toneLevel(output, 6000.0, outputRate), 0.001);
+    }
+}
+
+TEST_F(AudioConverterTest, ResamplingKeepsDCLevel) {
+    // Every phase of the filter bank has unity gain at DC
+    std::vector<float> input(44100, 0.25f);
+    auto output = AudioConverter::resample(input, 44100, 16000, ConversionQuality::High);
+    ASSERT_EQ(output.size(), 16000u);
+    
+    // Away from the edges, where the filter reaches past the buffer
+    for (size_t i = 100; i < output.size() - 100; ++i) {
+        EXPECT_NEAR(output[i], 0.25f, 1e-5f) << "at sample " << i;
+    }
+}
+
+TEST_F(AudioConverterTest, InvalidResamplingRate) {
+    std::vector<float> input(100, 0.0f);
+    EXPECT_THROW(AudioConverter::resample(input, 0, 16000), AudioException);
+}
+
 // Audio processing tests
 
 TEST_F(AudioConverterTest, NormalizationTest) {
@@ -288,7 +336,63 @@ TEST_F(AudioConverterTest, CompleteConversionPipeline) {
     // Check statistics
     EXPECT_GT(stats.peakLevel, 0.0f);
     EXPECT_GT(stats.averageLevel, 0.0f);
-    EXPECT_GT(stats.processingTimeMs, 0);
+    EXPECT_GT(stats.processingTimeMs, 0.0);
+}
+
+TEST_F(AudioConverterTest, FusedPipelineMatchesSeparateSteps) {
+    // 48 kHz stereo with a DC offset and content above the 8 kHz output limit
+    AudioBuffer input;
+    input.format = AudioFormat(48000, 2, 16, false);
+    auto left = AudioGenerator::generateSineWave(440.0f, 0.5f, 48000, 0.4f);
+    auto right = AudioGenerator::generateSineWave(12000.0f, 0.5f, 48000, 0.4f);
+    for (size_t i = 0; i < left.size(); ++i) {
+        input.data.push_back(left[i] + 0.1f);
+        input.data.push_back(right[i] + 0.1f);
+    }
+    
+    AudioConverter::ConversionParams params;
+    params.targetFormat = AudioFormat(16000, 1, 32, true);
+    params.removeDCOffset = false;
+    params.normalizeAudio = false;
+    
+    // Without DC removal and normalization the steps compose exactly
+    auto expected = AudioConverter::resample(AudioConverter::stereoToMono(input.data), 48000, 16000);
+    auto output = converter->convert(input, params);
+    ASSERT_EQ(output.data.size(), expected.size());
+    EXPECT_TRUE(areBuffersSimilar(output.data, expected, 1e-5f));
+    
+    // Normalization sees the peak after resampling and DC removal
+    params.removeDCOffset = true;
+    params.normalizeAudio = true;
+    AudioConverter::ConversionStats stats;
+    output = converter->convert(input, params, &stats);
+    auto measured = AudioConverter::calculateStats(output.data);
+    EXPECT_NEAR(stats.peakLevel, 0.95f, 1e-5f);
+    EXPECT_NEAR(measured.peakLevel, stats.peakLevel, 1e-6f);
+    EXPECT_NEAR(measured.averageLevel, stats.averageLevel, 1e-5f);
+    EXPECT_NEAR(stats.dcOffset, 0.0f, 1e-3f);
+}
+
+TEST_F(AudioConverterTest, NormalizationIgnoresRemovedOffset) {
+    // A biased signal in [0.4, 0.6] that never crosses zero
+    AudioBuffer input;
+    input.format = AudioFormat(16000, 1, 32, true);
+    for (float sample : AudioGenerator::generateSineWave(440.0f, 1.0f, 16000, 0.1f)) {
+        input.data.push_back(sample + 0.5f);
+    }
+    
+    AudioConverter::ConversionParams params;
+    params.targetFormat = AudioFormat(16000, 1, 32, true);
+    params.removeDCOffset = true;
+    params.normalizeAudio = true;
+    
+    // Only the 0.1 swing around the offset is scaled up to the target peak
+    auto output = converter->convert(input, params);
+    float peak = 0.0f;
+    for (float sample : output.data) {
+        peak = std::max(peak, std::abs(sample));
+    }
+    EXPECT_NEAR(peak, 0.95f, 1e-3f);
 }
 
 // Audio splitting and merging tests
@@ -454,6 +558,39 @@ TEST_F(AudioConverterTest, ConversionPerformance) {
     EXPECT_FALSE(output.empty());
 }
 
+TEST_F(AudioConverterTest, ResamplingPerformance) {
+    // 30 seconds of capture-rate audio to the Whisper rate, per quality tier.
+    // Throughput is printed; length and filter response are checked.
+    for (int inputRate : {44100, 48000}) {
+        std::vector<float> noise = AudioGenerator::generateWhiteNoise(30.0f, inputRate);
+        
+        // A 1 kHz passband tone and a 10 kHz tone that would alias to 6 kHz
+        std::vector<float> tones = AudioGenerator::generateSineWave(1000.0f, 1.0f, inputRate);
+        std::vector<float> high = AudioGenerator::generateSineWave(10000.0f, 1.0f, inputRate);
+        for (size_t i = 0; i < tones.size(); ++i) {
+            tones[i] += high[i];
+        }
+        
+        for (auto quality : {ConversionQuality::Low, ConversionQuality::Medium,
+                             ConversionQuality::High, ConversionQuality::Best}) {
+            auto start = std::chrono::steady_clock::now();
+            auto output = AudioConverter::resample(noise, inputRate, 16000, quality);
+            double seconds = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+            
+            std::cout << inputRate << " -> 16000, quality " << static_cast<int>(quality)
+                      << ": " << static_cast<uint64_t>(noise.size() / seconds)
+                      << " samples/sec" << std::endl;
+            EXPECT_EQ(output.size(), noise.size() * 16000 / inputRate);
+            
+            auto filtered = AudioConverter::resample(tones, inputRate, 16000, quality);
+            ASSERT_EQ(filtered.size(), 16000u);
+            EXPECT_NEAR(toneLevel(filtered, 1000.0, 16000), 0.5, 0.005);
+            EXPECT_LT(toneLevel(filtered, 6000.0, 16000), 0.001);
+        }
+    }
+}
+
 // Main function for running tests
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,136 @@
+/*
+ * AudioResamplerTest.cpp
+ *
+ * Unit tests for AudioResampler class.
+ */
+
+#include <gtest/gtest.h>
+#include "../TestUtils.h"
+#include "core/AudioResampler.h"
+#include "core/ErrorCodes.h"
+#include <cmath>
+
+using namespace WhisperApp;
+using namespace TestUtils;
+
+class AudioResamplerTest : public ::testing::Test {
+protected:
+    // Feed input through push() in packets of the given sizes, then flush
+    std::vector<float> stream(AudioResampler& resampler, const std::vector<float>& input,
+                              const std::vector<size_t>& packets) {
+        const int channels = resampler.channels();
+        const size_t frames = input.size() / channels;
+        std::vector<float> output;
+        std::vector<float> buffer;
+
+        size_t pos = 0;
+        for (size_t i = 0; pos < frames; ++i) {
+            size_t count = std::min(packets[i % packets.size()], frames - pos);
+            buffer.resize(resampler.maxOutput(count) * channels);
+            size_t written = resampler.push(input.data() + pos * channels, count, buffer.data());
+            EXPECT_LE(written * channels, buffer.size());
+            output.insert(output.end(), buffer.begin(), buffer.begin() + written * channels);
+            pos += count;
+        }
+
+        buffer.resize(resampler.maxOutput(0) * channels);
+        size_t written = resampler.flush(buffer.data());
+        output.insert(output.end(), buffer.begin(), buffer.begin() + written * channels);
+        return output;
+    }
+};
+
+TEST_F(AudioResamplerTest, OutputLength) {
+    AudioResampler resampler(44100, 16000);
+    EXPECT_EQ(resampler.outputLength(44100), 16000u);
+    EXPECT_EQ(resampler.outputLength(441), 160u);
+    EXPECT_EQ(resampler.outputLength(440), 159u);
+    EXPECT_EQ(resampler.outputLength(0), 0u);
+}
+
+TEST_F(AudioResamplerTest, StreamMatchesWholeBuffer) {
+    // Odd packet sizes that do not line up with the 441/160 cycle
+    std::vector<float> input = AudioGenerator::generateSineWave(440.0f, 1.0f, 44100);
+    AudioResampler resampler(44100, 16000);
+
+    std::vector<float> whole(resampler.outputLength(input.size()));
+    resampler.process(input.data(), input.size(), whole.data());
+
+    auto streamed = stream(resampler, input, {480, 1, 441, 1000, 7});
+    ASSERT_EQ(streamed.size(), whole.size());
+    for (size_t i = 0; i < whole.size(); ++i) {
+        EXPECT_NEAR(streamed[i], whole[i], 1e-5f) << "at sample " << i;
+    }
+}
+
+TEST_F(AudioResamplerTest, FlushStartsNewStream) {
+    std::vector<float> input = AudioGenerator::generateWhiteNoise(0.1f, 48000);
+    AudioResampler resampler(48000, 16000);
+
+    auto first = stream(resampler, input, {480});
+    auto second = stream(resampler, input, {480});
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(first.size(), input.size() / 3);
+}
+
+TEST_F(AudioResamplerTest, ChannelsAreFilteredSeparately) {
+    // Left carries a tone, right is silent; nothing may leak across
+    std::vector<float> tone = AudioGenerator::generateSineWave(1000.0f, 0.5f, 48000);
+    std::vector<float> stereo(tone.size() * 2, 0.0f);
+    for (size_t i = 0; i < tone.size(); ++i) {
+        stereo[i * 2] = tone[i];
+    }
+
+    AudioResampler resampler(48000, 16000, 2);
+    auto streamed = stream(resampler, stereo, {441});
+    ASSERT_EQ(streamed.size(), resampler.outputLength(tone.size()) * 2);
+
+    float leftPeak = 0.0f;
+    for (size_t i = 0; i < streamed.size(); i += 2) {
+        leftPeak = std::max(leftPeak, std::abs(streamed[i]));
+        EXPECT_EQ(streamed[i + 1], 0.0f);
+    }
+    EXPECT_NEAR(leftPeak, 0.5f, 0.01f);
+}
+
+TEST_F(AudioResamplerTest, RoundedPhasesKeepTiming) {
+    // 44100 -> 15999 has 5333 phases, more than the bank holds, so each output
+    // takes the nearest row. Truncating instead would delay every output by
+    // half a row on average, which shows up as a phase lag of the tone.
+    const int inputRate = 44100;
+    const int outputRate = 15999;
+    const double freq = 6000.0;
+    std::vector<float> input(inputRate);
+    for (size_t i = 0; i < input.size(); ++i) {
+        input[i] = static_cast<float>(0.5 * std::sin(2.0 * M_PI * freq * i / inputRate));
+    }
+    AudioResampler resampler(inputRate, outputRate, 1, ConversionQuality::High);
+    ASSERT_LT(resampler.phases(), 5333);
+
+    std::vector<float> output(resampler.outputLength(input.size()));
+    resampler.process(input.data(), input.size(), output.data());
+
+    // Least-squares fit of a*sin + b*cos, away from the edges where the
+    // filter reaches past the buffer
+    double ss = 0.0, cc = 0.0, sc = 0.0, ys = 0.0, yc = 0.0;
+    for (size_t n = 100; n + 100 < output.size(); ++n) {
+        const double w = 2.0 * M_PI * freq * n / outputRate;
+        ss += std::sin(w) * std::sin(w);
+        cc += std::cos(w) * std::cos(w);
+        sc += std::sin(w) * std::cos(w);
+        ys += output[n] * std::sin(w);
+        yc += output[n] * std::cos(w);
+    }
+    const double det = ss * cc - sc * sc;
+    const double a = (ys * cc - yc * sc) / det;
+    const double b = (yc * ss - ys * sc) / det;
+    const double lag = std::atan2(b, a);
+    const double halfRow = 2.0 * M_PI * freq / inputRate * 0.5 / resampler.phases();
+    EXPECT_LT(std::abs(lag), halfRow * 0.25);
+}
+
+TEST_F(AudioResamplerTest, InvalidParameters) {
+    EXPECT_THROW(AudioResampler(0, 16000), AudioException);
+    EXPECT_THROW(AudioResampler(48000, -1), AudioException);
+    EXPECT_THROW(AudioResampler(48000, 16000, 0), AudioException);
+}
@@ -70,6 +70,71 @@ TEST_F(WhisperEngineTest, ModelUnloading) {
     EXPECT_FALSE(engine->isModelLoaded());
 }
 
+TEST_F(WhisperEngineAsyncTest, ModelHotSwapKeepsInFlightTranscriptions) {
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    
+    // A transcription running during the swap finishes on the previous model
+    auto audio = AudioGenerator::generateSineWave(440.0f, 5.0f, 16000);
+    engine->transcribeAudioAsync(audio, WhisperEngine::TranscriptionParams(),
+        [this](const WhisperEngine::TranscriptionResult& result) {
+            resultTracker.onCallback(result);
+        });
+    
+    CallbackTracker<bool> swapTracker;
+    engine->loadModelAsync("models/ggml-medium.bin", [&swapTracker](bool loaded) {
+        swapTracker.onCallback(loaded);
+    });
+    ASSERT_TRUE(swapTracker.waitForCallback(10000));
+    EXPECT_TRUE(swapTracker.getResult());
+    EXPECT_NE(engine->getModelInfo().find("Model: medium"), std::string::npos);
+    
+    ASSERT_TRUE(resultTracker.waitForCallback(10000));
+    EXPECT_EQ(resultTracker.getResult().text.find("Error"), std::string::npos);
+    
+    // A preloaded model waits in the warm pool until it is loaded
+    ASSERT_TRUE(engine->preloadModel("models/ggml-base.bin"));
+    EXPECT_NE(engine->getModelInfo().find("Preloaded: models/ggml-base.bin"), std::string::npos);
+    ASSERT_TRUE(engine->loadModel("models/ggml-base.bin"));
+    EXPECT_NE(engine->getModelInfo().find("Model: base"), std::string::npos);
+    EXPECT_EQ(engine->getModelInfo().find("Preloaded:"), std::string::npos);
+    
+    // Of two requests in flight the later one wins, whichever finishes loading first
+    CallbackTracker<bool> first, second;
+    engine->loadModelAsync("models/ggml-tiny.bin", [&first](bool loaded) { first.onCallback(loaded); });
+    engine->loadModelAsync("models/ggml-medium.bin", [&second](bool loaded) { second.onCallback(loaded); });
+    ASSERT_TRUE(first.waitForCallback(10000));
+    ASSERT_TRUE(second.waitForCallback(10000));
+    EXPECT_TRUE(second.getResult());
+    EXPECT_NE(engine->getModelInfo().find("Model: medium"), std::string::npos);
+}
+
+TEST_F(WhisperEngineTest, MemoryReportCountsWeightsAndStates) {
+    EXPECT_EQ(engine->getMemoryReport().total_bytes, 0u);
+    
+    engine->setStatePoolSize(1);
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    
+    auto report = engine->getMemoryReport();
+    EXPECT_GT(report.weights_bytes, 0u);
+    EXPECT_GT(report.kv_self_bytes, 0u);
+    EXPECT_GT(report.kv_cross_bytes, report.kv_self_bytes);  // 1500 audio positions vs 448 text positions
+    EXPECT_GT(report.compute_bytes, 0u);
+    EXPECT_EQ(report.state_bytes, report.kv_self_bytes + report.kv_cross_bytes +
+                                  report.mel_bytes + report.compute_bytes);
+    EXPECT_EQ(report.n_states, 1);
+    EXPECT_EQ(report.total_bytes, report.weights_bytes + report.state_bytes);
+    
+    // Admission control: states that fit next to the weights
+    EXPECT_EQ(report.statesWithin(report.weights_bytes - 1), 0);
+    EXPECT_EQ(report.statesWithin(report.weights_bytes), 0);
+    EXPECT_EQ(report.statesWithin(report.weights_bytes + 3 * report.state_bytes + report.state_bytes / 2), 3);
+    EXPECT_NE(engine->getModelInfo().find("weights + 1 x"), std::string::npos);
+    
+    engine->unloadModel();
+    EXPECT_EQ(engine->getMemoryReport().n_states, 0);
+    EXPECT_EQ(engine->getMemoryReport().weights_bytes, 0u);
+}
+
 TEST_F(WhisperEngineTest, ThreadCountConfiguration) {
     // Test setting thread count
     engine->setThreadCount(8);
@@ -130,8 +195,8 @@ TEST_F(WhisperEngineTest, TranscriptionParameters) {
     // Load model
     ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
     
-    // Generate test audio
-    auto audio = AudioGenerator::generateWhiteNoise(2.0f, 16000);
+    // Generate test audio (noise would be skipped as no speech)
+    auto audio = AudioGenerator::generateSineWave(440.0f, 2.0f, 16000);
     
     // Test with custom parameters
     WhisperEngine::TranscriptionParams params;
@@ -148,6 +213,196 @@ TEST_F(WhisperEngineTest, TranscriptionParameters) {
     EXPECT_NE(result.text.find("es"), std::string::npos);
 }
 
+TEST_F(WhisperEngineTest, TranscribeAudioViews) {
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    
+    auto audio = AudioGenerator::generateSineWave(440.0f, 2.0f, 16000);
+    
+    // A pointer/length view of the second half, without building a new vector
+    auto result = engine->transcribeAudio(audio.data() + 16000, 16000);
+    EXPECT_EQ(result.text.find("Error"), std::string::npos);
+    ASSERT_FALSE(result.segments.empty());
+    EXPECT_EQ(result.segments.back().end_ms, 1000);
+    
+    result = engine->transcribeAudio(nullptr, 0);
+    EXPECT_NE(result.text.find("Error"), std::string::npos);
+    
+    // A queued buffer stays alive until its job is done, then is released
+    auto samples = std::make_shared<const std::vector<float>>(audio);
+    std::weak_ptr<const std::vector<float>> weak = samples;
+    auto job = engine->submitTranscription(WhisperEngine::AudioBuffer(std::move(samples)),
+                                           WhisperEngine::TranscriptionParams());
+    auto job_result = job.wait();
+    EXPECT_EQ(job.getStatus(), WhisperEngine::JobStatus::Completed);
+    EXPECT_EQ(job_result.text.find("Error"), std::string::npos);
+    EXPECT_TRUE(weak.expired());
+}
+
+TEST_F(WhisperEngineTest, ConcurrentTranscriptionsSharePool) {
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    
+    engine->setStatePoolSize(2);
+    EXPECT_EQ(engine->getStatePoolSize(), 2);
+    
+    auto audio = AudioGenerator::generateSineWave(440.0f, 1.0f, 16000);
+    
+    // More callers than states: the extra ones wait for a state instead of failing
+    std::vector<WhisperEngine::TranscriptionResult> results(4);
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < results.size(); ++i) {
+        threads.emplace_back([this, &audio, &results, i]() {
+            results[i] = engine->transcribeAudio(audio);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    
+    for (const auto& result : results) {
+        EXPECT_EQ(result.text.find("Error"), std::string::npos);
+        EXPECT_FALSE(result.segments.empty());
+    }
+    EXPECT_FALSE(engine->isTranscribing());
+    EXPECT_NE(engine->getModelInfo().find("State pool: 0/2"), std::string::npos);
+}
+
+TEST_F(WhisperEngineTest, AutoPoolSizeAllowsConcurrency) {
+    // The default thread count covers every core; the pool still has two states
+    EXPECT_GE(engine->getStatePoolSize(), 2);
+    
+    engine->setThreadCount(16);
+    EXPECT_EQ(engine->getStatePoolSize(), 4);
+    engine->setThreadCount(2);
+    EXPECT_EQ(engine->getStatePoolSize(), 2);
+    
+    // An explicit size takes precedence
+    engine->setStatePoolSize(1);
+    EXPECT_EQ(engine->getStatePoolSize(), 1);
+}
+
+TEST_F(WhisperEngineTest, LongAudioIsSplitAtSilence) {
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    engine->setStatePoolSize(2);
+    
+    // 70 seconds of tone with a pause from 24 to 25 s; longer than one window
+    auto audio = AudioGenerator::generateSineWave(440.0f, 70.0f, 16000);
+    std::fill(audio.begin() + 24 * 16000, audio.begin() + 25 * 16000, 0.0f);
+    
+    auto result = engine->transcribeAudio(audio);
+    EXPECT_EQ(result.text.find("Error"), std::string::npos);
+    ASSERT_GE(result.segments.size(), 3u);
+    
+    // The first cut lands inside the pause; spans are stitched back in order
+    EXPECT_GE(result.segments[1].start_ms, 24000);
+    EXPECT_LE(result.segments[1].start_ms, 25000);
+    for (size_t i = 1; i < result.segments.size(); ++i) {
+        EXPECT_EQ(result.segments[i].start_ms, result.segments[i - 1].end_ms);
+    }
+    EXPECT_EQ(result.segments.front().start_ms, 0);
+    EXPECT_EQ(result.segments.back().end_ms, 70000);
+}
+
+TEST_F(WhisperEngineTest, SilenceAndNoiseAreNotDecoded) {
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    
+    std::vector<float> silence(2 * 16000, 0.0f);
+    auto noise = AudioGenerator::generateWhiteNoise(2.0f, 16000);
+    
+    for (const auto* audio : { &silence, &noise }) {
+        auto result = engine->transcribeAudio(*audio);
+        EXPECT_EQ(result.text.find("Error"), std::string::npos);
+        EXPECT_TRUE(result.segments.empty());
+    }
+    
+    // A threshold of 1 decodes everything
+    WhisperEngine::TranscriptionParams params;
+    params.no_speech_threshold = 1.0f;
+    EXPECT_FALSE(engine->transcribeAudio(noise, params).segments.empty());
+}
+
+TEST_F(WhisperEngineTest, ConfidenceFollowsAudioClarity) {
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    
+    auto tone = AudioGenerator::generateSineWave(440.0f, 2.0f, 16000);
+    auto noise = AudioGenerator::generateWhiteNoise(2.0f, 16000);
+    
+    WhisperEngine::TranscriptionParams params;
+    params.no_speech_threshold = 1.0f;  // decode the noise too
+    
+    auto clear = engine->transcribeAudio(tone, params);
+    auto noisy = engine->transcribeAudio(noise, params);
+    ASSERT_FALSE(clear.segments.empty());
+    ASSERT_FALSE(noisy.segments.empty());
+    
+    for (const auto& segment : clear.segments) {
+        EXPECT_GT(segment.confidence, 0.0f);
+        EXPECT_LE(segment.confidence, 1.0f);
+    }
+    EXPECT_GT(clear.confidence, 0.9f);
+    EXPECT_LT(noisy.confidence, 0.5f);
+    
+    // The same audio gets the same confidence
+    EXPECT_FLOAT_EQ(engine->transcribeAudio(tone, params).confidence, clear.confidence);
+}
+
+TEST_F(WhisperEngineTest, EncoderCacheReusesRepeatedAudio) {
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    
+    auto audio = AudioGenerator::generateSineWave(440.0f, 2.0f, 16000);
+    auto other = AudioGenerator::generateSineWave(880.0f, 2.0f, 16000);
+    
+    WhisperEngine::TranscriptionParams params;
+    auto first = engine->transcribeAudio(audio, params);
+    
+    // Same audio with another language only runs the decoder
+    params.language = "de";
+    auto second = engine->transcribeAudio(audio, params);
+    engine->transcribeAudio(other, params);
+    
+    EXPECT_EQ(first.text.find("Error"), std::string::npos);
+    EXPECT_EQ(second.text.find("Error"), std::string::npos);
+    ASSERT_FALSE(second.segments.empty());
+    EXPECT_EQ(second.segments.back().end_ms, first.segments.back().end_ms);
+    EXPECT_NE(engine->getModelInfo().find("Encoder cache: 1 hits, 2 misses"), std::string::npos);
+    
+    // A disabled cache neither looks up nor stores; reloading the model empties it
+    engine->setEncoderCacheSize(0);
+    engine->transcribeAudio(audio, params);
+    EXPECT_NE(engine->getModelInfo().find("1 hits, 2 misses, 2 evictions, 0 entries"), std::string::npos);
+    
+    engine->setEncoderCacheSize(64 * 1024 * 1024);
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    engine->transcribeAudio(audio, params);
+    EXPECT_NE(engine->getModelInfo().find("Encoder cache: 0 hits, 1 misses"), std::string::npos);
+}
+
+TEST_F(WhisperEngineTest, CascadeDecodesLowConfidenceSegmentsAgain) {
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    EXPECT_FALSE(engine->isCascadeEnabled());
+    EXPECT_FALSE(engine->loadCascadeModel("models/missing.bin"));
+    
+    // Confidence is at most 1, so every segment is decoded again
+    ASSERT_TRUE(engine->loadCascadeModel("models/ggml-medium.bin", 1.5f));
+    EXPECT_TRUE(engine->isCascadeEnabled());
+    
+    auto audio = AudioGenerator::generateSineWave(440.0f, 2.0f, 16000);
+    auto first = engine->transcribeAudio(audio);
+    EXPECT_EQ(first.text.find("Error"), std::string::npos);
+    ASSERT_FALSE(first.segments.empty());
+    EXPECT_NE(engine->getModelInfo().find("Cascade: medium below 1.50 confidence, 1 of 1 segments"),
+              std::string::npos);
+    
+    // Nothing is below a threshold of 0, so the result is the fast model's
+    ASSERT_TRUE(engine->loadCascadeModel("models/ggml-medium.bin", 0.0f));
+    auto second = engine->transcribeAudio(audio);
+    EXPECT_EQ(second.segments.size(), first.segments.size());
+    EXPECT_NE(engine->getModelInfo().find("0 of 1 segments"), std::string::npos);
+    
+    engine->unloadCascadeModel();
+    EXPECT_FALSE(engine->isCascadeEnabled());
+    EXPECT_EQ(engine->getModelInfo().find("Cascade:"), std::string::npos);
+}
+
 // Async transcription tests
 
 TEST_F(WhisperEngineAsyncTest, AsyncTranscriptionSuccess) {
@@ -211,7 +466,7 @@ TEST_F(WhisperEngineAsyncTest, AsyncTranscriptionCancellation) {
     // In real implementation, would check for cancellation error
 }
 
-TEST_F(WhisperEngineAsyncTest, ConcurrentTranscriptionRejection) {
+TEST_F(WhisperEngineAsyncTest, ConcurrentTranscriptionsAreQueued) {
     // Load model
     ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
     
@@ -219,13 +474,16 @@ TEST_F(WhisperEngineAsyncTest, ConcurrentTranscriptionRejection) {
     auto audio = AudioGenerator::generateWhiteNoise(2.0f, 16000);
     
     // Start first transcription
+    CallbackTracker<WhisperEngine::TranscriptionResult> firstTracker;
     engine->transcribeAudioAsync(
         audio,
         WhisperEngine::TranscriptionParams(),
-        [](const WhisperEngine::TranscriptionResult&) {}  // Ignore result
+        [&firstTracker](const WhisperEngine::TranscriptionResult& result) {
+            firstTracker.onCallback(result);
+        }
     );
     
-    // Try to start second transcription immediately
+    // Start second transcription immediately
     CallbackTracker<WhisperEngine::TranscriptionResult> secondTracker;
     engine->transcribeAudioAsync(
         audio,
@@ -235,11 +493,119 @@ TEST_F(WhisperEngineAsyncTest, ConcurrentTranscriptionRejection) {
         }
     );
     
-    // Second transcription should be rejected immediately
-    ASSERT_TRUE(secondTracker.waitForCallback(1000));  // Short timeout
+    // Both transcriptions should complete
+    ASSERT_TRUE(firstTracker.waitForCallback(30000));
+    ASSERT_TRUE(secondTracker.waitForCallback(30000));
     
-    auto result = secondTracker.getResult();
-    EXPECT_NE(result.text.find("Already transcribing"), std::string::npos);
+    EXPECT_EQ(firstTracker.getResult().text.find("Error"), std::string::npos);
+    EXPECT_EQ(secondTracker.getResult().text.find("Error"), std::string::npos);
+}
+
+TEST_F(WhisperEngineAsyncTest, JobQueuePriorityAndCancel) {
+    // Load model
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    engine->setStatePoolSize(1);
+    
+    auto audio = AudioGenerator::generateSineWave(440.0f, 1.0f, 16000);
+    
+    // Record the order in which jobs finish (-1 for the high priority job)
+    std::mutex order_mutex;
+    std::vector<int> order;
+    auto record = [&](int index) {
+        std::lock_guard<std::mutex> lock(order_mutex);
+        order.push_back(index);
+    };
+    
+    // Occupy the single worker, then queue low and high priority jobs behind it
+    auto running = engine->submitTranscription(
+        AudioGenerator::generateSineWave(440.0f, 10.0f, 16000),
+        WhisperEngine::TranscriptionParams());
+    
+    std::vector<WhisperEngine::JobHandle> low;
+    for (int i = 0; i < 3; ++i) {
+        low.push_back(engine->submitTranscription(
+            audio, WhisperEngine::TranscriptionParams(),
+            [&record, i](const WhisperEngine::TranscriptionResult&) { record(i); },
+            nullptr, WhisperEngine::JobPriority::Low));
+    }
+    
+    std::atomic<int> progress_updates{0};
+    auto high = engine->submitTranscription(
+        audio, WhisperEngine::TranscriptionParams(),
+        [&record](const WhisperEngine::TranscriptionResult&) { record(-1); },
+        [&progress_updates](float) { progress_updates++; },
+        WhisperEngine::JobPriority::High);
+    
+    // Cancel a queued job
+    EXPECT_TRUE(low[1].cancel());
+    
+    running.wait();
+    high.wait();
+    for (auto& job : low) {
+        job.wait();
+    }
+    
+    EXPECT_EQ(running.getStatus(), WhisperEngine::JobStatus::Completed);
+    EXPECT_EQ(high.getStatus(), WhisperEngine::JobStatus::Completed);
+    EXPECT_EQ(low[0].getStatus(), WhisperEngine::JobStatus::Completed);
+    EXPECT_EQ(low[1].getStatus(), WhisperEngine::JobStatus::Cancelled);
+    EXPECT_EQ(low[2].getStatus(), WhisperEngine::JobStatus::Completed);
+    EXPECT_GT(progress_updates.load(), 0);
+    
+    // The cancelled job reports first, then the high priority job runs before the low ones
+    EXPECT_EQ(order, (std::vector<int>{1, -1, 0, 2}));
+    EXPECT_EQ(engine->getQueuedJobCount(), 0u);
+}
+
+// Streaming tests
+
+TEST_F(WhisperEngineTest, StreamingSessionEmitsSegments) {
+    WhisperEngine::StreamingParams params;
+    params.step_ms = 500;
+    params.length_ms = 2000;
+    params.keep_ms = 200;
+    
+    // No model, no session
+    EXPECT_EQ(engine->startStreaming(params, nullptr), nullptr);
+    
+    ASSERT_TRUE(engine->loadModel("models/ggml-tiny.bin"));
+    
+    std::mutex segments_mutex;
+    std::vector<std::pair<WhisperEngine::TranscriptionResult::Segment, bool>> segments;
+    auto session = engine->startStreaming(params,
+        [&](const WhisperEngine::TranscriptionResult::Segment& segment, bool stable) {
+            std::lock_guard<std::mutex> lock(segments_mutex);
+            segments.emplace_back(segment, stable);
+        });
+    ASSERT_NE(session, nullptr);
+    EXPECT_TRUE(session->isActive());
+    
+    // Push 5 seconds in 100 ms chunks
+    auto audio = AudioGenerator::generateSineWave(440.0f, 5.0f, 16000);
+    for (size_t pos = 0; pos < audio.size(); pos += 1600) {
+        session->pushAudio(audio.data() + pos, std::min<size_t>(1600, audio.size() - pos));
+    }
+    
+    auto result = session->finish();
+    EXPECT_FALSE(session->isActive());
+    EXPECT_EQ(result.text.find("Error"), std::string::npos);
+    ASSERT_FALSE(result.segments.empty());
+    
+    // Stable segments are the committed ones; windows advance through the stream
+    std::vector<WhisperEngine::TranscriptionResult::Segment> stable;
+    for (const auto& entry : segments) {
+        EXPECT_FALSE(entry.first.text.empty());
+        EXPECT_LE(entry.first.end_ms - entry.first.start_ms, 5000);
+        if (entry.second) {
+            stable.push_back(entry.first);
+        }
+    }
+    ASSERT_EQ(stable.size(), result.segments.size());
+    for (size_t i = 1; i < stable.size(); ++i) {
+        EXPECT_GT(stable[i].start_ms, stable[i - 1].start_ms);
+        EXPECT_GE(stable[i - 1].end_ms, stable[i].start_ms);  // overlap
+    }
+    EXPECT_EQ(stable.back().end_ms, 5000);
 }
 
 // Language support tests
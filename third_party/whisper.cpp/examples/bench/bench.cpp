@@ -0,0 +1,75 @@
+#include "whisper.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <algorithm>
+
+// command-line parameters
+struct whisper_params {
+    int32_t n_threads = std::min(4, (int32_t) std::thread::hardware_concurrency());
+    int32_t what      = 0; // what to benchmark: 0 - pcm_to_mel, 1 - ggml_mul_mat, 2 - model load, 3 - kv cache
+
+    std::string model = ""; // model for the load benchmark; empty generates one
+};
+
+static void whisper_print_usage(int argc, char ** argv, const whisper_params & params);
+
+static bool whisper_params_parse(int argc, char ** argv, whisper_params & params) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "-h" || arg == "--help") {
+            whisper_print_usage(argc, argv, params);
+            exit(0);
+        }
+        else if ((arg == "-t" || arg == "--threads") && i + 1 < argc) { params.n_threads = std::stoi(argv[++i]); }
+        else if ((arg == "-w" || arg == "--what")    && i + 1 < argc) { params.what      = std::stoi(argv[++i]); }
+        else if ((arg == "-m" || arg == "--model")   && i + 1 < argc) { params.model     = argv[++i]; }
+        else {
+            fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
+            whisper_print_usage(argc, argv, params);
+            exit(0);
+        }
+    }
+
+    return true;
+}
+
+static void whisper_print_usage(int /*argc*/, char ** argv, const whisper_params & params) {
+    fprintf(stderr, "\n");
+    fprintf(stderr, "usage: %s [options]\n", argv[0]);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "options:\n");
+    fprintf(stderr, "  -h,       --help        [default] show this help message and exit\n");
+    fprintf(stderr, "  -t N,     --threads N   [%-7d] number of threads to use during computation\n", params.n_threads);
+    fprintf(stderr, "  -w N,     --what N      [%-7d] what to benchmark:\n", params.what);
+    fprintf(stderr, "                           %-7s  0 - pcm_to_mel\n", "");
+    fprintf(stderr, "                           %-7s  1 - ggml_mul_mat\n", "");
+    fprintf(stderr, "                           %-7s  2 - model load (mmap vs read)\n", "");
+    fprintf(stderr, "                           %-7s  3 - kv cache (f32 vs f16 vs q8_0)\n", "");
+    fprintf(stderr, "  -m FNAME, --model FNAME [%-7s] model for the load benchmark (default: generated)\n", params.model.c_str());
+    fprintf(stderr, "\n");
+}
+
+int main(int argc, char ** argv) {
+    whisper_params params;
+
+    if (whisper_params_parse(argc, argv, params) == false) {
+        return 1;
+    }
+
+    int ret = -1;
+
+    switch (params.what) {
+        case 0: ret = whisper_bench_pcm_to_mel(params.n_threads);   break;
+        case 1: ret = whisper_bench_ggml_mul_mat(params.n_threads); break;
+        case 2: ret = whisper_bench_model_load(params.model.empty() ? nullptr : params.model.c_str()); break;
+        case 3: ret = whisper_bench_kv_cache(); break;
+        default: fprintf(stderr, "error: unknown benchmark: %d\n", params.what); break;
+    }
+
+    return ret;
+}
@@ -1,9 +1,33 @@
 #include "ggml-alloc.h"
 #include "ggml-backend.h"
+#include "ggml-impl.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdio.h>
 #include <assert.h>
 
+// Tensors are placed in a single buffer. Freed ranges go back to an address-ordered
+// free list (adjacent ranges are merged) and new tensors take the smallest block
+// that fits. When a whole graph is allocated, each intermediate is released right
+// after its last consumer, so later nodes reuse the memory of dead ones.
+
+#define MAX_FREE_BLOCKS 256
+
+// measure mode places tensors at fake addresses starting here
+#define GGML_ALLOCR_MEASURE_BASE ((char *) 0x1000)
+
+struct free_block {
+    size_t offset;
+    size_t size;
+};
+
+// per-tensor liveness while a graph is being allocated
+struct hash_node {
+    int  n_children; // consumers not yet allocated
+    int  n_views;    // views not yet released
+    bool allocated;  // memory owned by this allocator, to be freed after the last use
+};
+
 // Allocator structure
 struct ggml_allocr {
     struct ggml_backend_buffer * buffer;
@@ -11,16 +35,15 @@ struct ggml_allocr {
     void * data;
     size_t size;
     size_t alignment;
-    size_t offset;
     bool measure;
+
+    int n_free_blocks;
+    struct free_block free_blocks[MAX_FREE_BLOCKS];
+
     struct ggml_hash_set hash_set;
-    size_t max_size;
-};
+    struct hash_node * hash_values;
 
-// Hash set for allocated tensors
-struct ggml_hash_set {
-    size_t size;
-    struct ggml_tensor ** keys;
+    size_t max_size;
 };
 
 // Alignment helper
@@ -28,56 +51,52 @@ static size_t aligned_offset(size_t offset, size_t alignment) {
     return (offset + alignment - 1) & ~(alignment - 1);
 }
 
-// Initialize allocator
-ggml_allocr_t ggml_allocr_new(void * data, size_t size, size_t alignment) {
+static char * ggml_allocr_base(ggml_allocr_t alloc) {
+    return alloc->measure ? GGML_ALLOCR_MEASURE_BASE : (char *) alloc->data;
+}
+
+static ggml_allocr_t ggml_allocr_new_impl(struct ggml_backend_buffer * buffer, void * data, size_t size, size_t alignment, bool measure) {
     ggml_allocr_t alloc = (ggml_allocr_t)malloc(sizeof(struct ggml_allocr));
     if (!alloc) return NULL;
-    
+
     *alloc = (struct ggml_allocr) {
-        .buffer = NULL,
+        .buffer = buffer,
         .buffer_owned = false,
         .data = data,
         .size = size,
         .alignment = alignment,
-        .offset = 0,
-        .measure = false,
+        .measure = measure,
+        .n_free_blocks = 0,
         .hash_set = {0},
+        .hash_values = NULL,
         .max_size = 0,
     };
-    
+
+    ggml_allocr_reset(alloc);
+
     return alloc;
 }
 
+// Initialize allocator
+ggml_allocr_t ggml_allocr_new(void * data, size_t size, size_t alignment) {
+    return ggml_allocr_new_impl(NULL, data, size, alignment, false);
+}
+
 ggml_allocr_t ggml_allocr_new_measure(size_t alignment) {
-    ggml_allocr_t alloc = (ggml_allocr_t)malloc(sizeof(struct ggml_allocr));
-    if (!alloc) return NULL;
-    
-    *alloc = (struct ggml_allocr) {
-        .buffer = NULL,
-        .buffer_owned = false,
-        .data = NULL,
-        .size = SIZE_MAX,
-        .alignment = alignment,
-        .offset = 0,
-        .measure = true,
-        .hash_set = {0},
-        .max_size = 0,
-    };
-    
-    return alloc;
+    // large enough to never run out, small enough that offsets cannot overflow
+    return ggml_allocr_new_impl(NULL, NULL, SIZE_MAX/2, alignment, true);
 }
 
 void ggml_allocr_free(ggml_allocr_t alloc) {
     if (!alloc) return;
-    
+
     if (alloc->buffer_owned && alloc->buffer) {
         ggml_backend_buffer_free(alloc->buffer);
     }
-    
-    if (alloc->hash_set.keys) {
-        free(alloc->hash_set.keys);
-    }
-    
+
+    free(alloc->hash_set.keys);
+    free(alloc->hash_values);
+
     free(alloc);
 }
 
@@ -87,95 +106,353 @@ bool ggml_allocr_is_measure(ggml_allocr_t alloc) {
 
 void ggml_allocr_reset(ggml_allocr_t alloc) {
     if (!alloc) return;
-    
-    alloc->offset = 0;
+
+    alloc->n_free_blocks = 1;
+    alloc->free_blocks[0].offset = aligned_offset((size_t) (uintptr_t) ggml_allocr_base(alloc), alloc->alignment) -
+                                   (size_t) (uintptr_t) ggml_allocr_base(alloc);
+    alloc->free_blocks[0].size = alloc->size - alloc->free_blocks[0].offset;
+
     if (alloc->measure) {
         alloc->max_size = 0;
     }
 }
 
+// Best fit over the free list; the last block is the tail of the buffer and is only
+// used when no other block fits, which keeps the high-water mark low
+static bool ggml_allocr_alloc_offset(ggml_allocr_t alloc, size_t size, size_t * offset) {
+    size_t max_avail = 0;
+
+    int best_fit_block = -1;
+    size_t best_fit_size = SIZE_MAX;
+    for (int i = 0; i < alloc->n_free_blocks - 1; i++) {
+        struct free_block * block = &alloc->free_blocks[i];
+        max_avail = block->size > max_avail ? block->size : max_avail;
+        if (block->size >= size && block->size <= best_fit_size) {
+            best_fit_block = i;
+            best_fit_size = block->size;
+        }
+    }
+
+    if (best_fit_block == -1) {
+        struct free_block * block = &alloc->free_blocks[alloc->n_free_blocks - 1];
+        max_avail = block->size > max_avail ? block->size : max_avail;
+        if (block->size >= size) {
+            best_fit_block = alloc->n_free_blocks - 1;
+        } else {
+            fprintf(stderr, "%s: not enough space in the buffer (needed %zu, largest block available %zu)\n",
+                    __func__, size, max_avail);
+            return false;
+        }
+    }
+
+    struct free_block * block = &alloc->free_blocks[best_fit_block];
+    *offset = block->offset;
+    block->offset += size;
+    block->size -= size;
+    if (block->size == 0) {
+        // remove block if empty
+        alloc->n_free_blocks--;
+        for (int j = best_fit_block; j < alloc->n_free_blocks; j++) {
+            alloc->free_blocks[j] = alloc->free_blocks[j+1];
+        }
+    }
+
+    if (*offset + size > alloc->max_size) {
+        alloc->max_size = *offset + size;
+    }
+
+    return true;
+}
+
+static void ggml_allocr_free_offset(ggml_allocr_t alloc, size_t offset, size_t size) {
+    // try to merge with an existing block
+    for (int i = 0; i < alloc->n_free_blocks; i++) {
+        struct free_block * block = &alloc->free_blocks[i];
+        // check if the freed range is adjacent to the end of the block
+        if (block->offset + block->size == offset) {
+            block->size += size;
+            // check if we can merge with the next block
+            if (i < alloc->n_free_blocks - 1 && block->offset + block->size == alloc->free_blocks[i+1].offset) {
+                block->size += alloc->free_blocks[i+1].size;
+                alloc->n_free_blocks--;
+                for (int j = i+1; j < alloc->n_free_blocks; j++) {
+                    alloc->free_blocks[j] = alloc->free_blocks[j+1];
+                }
+            }
+            return;
+        }
+        // check if the freed range is adjacent to the beginning of the block
+        if (offset + size == block->offset) {
+            block->offset = offset;
+            block->size += size;
+            // check if we can merge with the previous block
+            if (i > 0 && alloc->free_blocks[i-1].offset + alloc->free_blocks[i-1].size == block->offset) {
+                alloc->free_blocks[i-1].size += block->size;
+                alloc->n_free_blocks--;
+                for (int j = i; j < alloc->n_free_blocks; j++) {
+                    alloc->free_blocks[j] = alloc->free_blocks[j+1];
+                }
+            }
+            return;
+        }
+    }
+    // otherwise, add a new block
+    assert(alloc->n_free_blocks < MAX_FREE_BLOCKS && "out of free blocks");
+    if (alloc->n_free_blocks >= MAX_FREE_BLOCKS) {
+        // the range is leaked until the next reset
+        return;
+    }
+    // insert the new block in the correct position to keep the array sorted by address
+    int insert_pos = 0;
+    while (insert_pos < alloc->n_free_blocks && alloc->free_blocks[insert_pos].offset < offset) {
+        insert_pos++;
+    }
+    // shift all blocks from insert_pos onward to make room for the new block
+    for (int i = alloc->n_free_blocks; i > insert_pos; i--) {
+        alloc->free_blocks[i] = alloc->free_blocks[i-1];
+    }
+    // insert the new block
+    alloc->free_blocks[insert_pos].offset = offset;
+    alloc->free_blocks[insert_pos].size = size;
+    alloc->n_free_blocks++;
+}
+
+static size_t ggml_allocr_tensor_size(ggml_allocr_t alloc, const struct ggml_tensor * tensor) {
+    return aligned_offset(ggml_nbytes(tensor), alloc->alignment);
+}
+
+static bool ggml_allocr_alloc_tensor(ggml_allocr_t alloc, struct ggml_tensor * tensor) {
+    size_t offset;
+    if (!ggml_allocr_alloc_offset(alloc, ggml_allocr_tensor_size(alloc, tensor), &offset)) {
+        tensor->data = NULL;
+        return false;
+    }
+
+    tensor->data = ggml_allocr_base(alloc) + offset;
+    if (!alloc->measure) {
+        tensor->buffer = alloc->buffer;
+        tensor->backend = GGML_BACKEND_CPU;
+    }
+    return true;
+}
+
+static void ggml_allocr_free_tensor(ggml_allocr_t alloc, struct ggml_tensor * tensor) {
+    const size_t offset = (size_t) ((char *) tensor->data - ggml_allocr_base(alloc));
+    ggml_allocr_free_offset(alloc, offset, ggml_allocr_tensor_size(alloc, tensor));
+}
+
 void ggml_allocr_alloc(ggml_allocr_t alloc, struct ggml_tensor * tensor) {
     if (!alloc || !tensor) return;
-    
-    size_t size = ggml_nbytes(tensor);
-    size_t offset = aligned_offset(alloc->offset, alloc->alignment);
-    
-    if (alloc->measure) {
-        alloc->offset = offset + size;
-        if (alloc->offset > alloc->max_size) {
-            alloc->max_size = alloc->offset;
+
+    ggml_allocr_alloc_tensor(alloc, tensor);
+}
+
+size_t ggml_allocr_get_alloc_size(ggml_allocr_t alloc) {
+    return alloc ? alloc->max_size : 0;
+}
+
+//
+// Graph allocation
+//
+
+static struct hash_node * ggml_allocr_hash_get(ggml_allocr_t alloc, struct ggml_tensor * t) {
+    const size_t i = ggml_hash_find_or_insert(alloc->hash_set, t);
+    return &alloc->hash_values[i];
+}
+
+static bool ggml_allocr_hash_reserve(ggml_allocr_t alloc, size_t min_size) {
+    const size_t size = ggml_hash_size(min_size);
+    if (alloc->hash_set.size < size) {
+        free(alloc->hash_set.keys);
+        free(alloc->hash_values);
+        alloc->hash_set.keys = malloc(size * sizeof(struct ggml_tensor *));
+        alloc->hash_values = malloc(size * sizeof(struct hash_node));
+        alloc->hash_set.size = alloc->hash_set.keys && alloc->hash_values ? size : 0;
+        if (alloc->hash_set.size == 0) {
+            return false;
         }
-        tensor->data = NULL; // measure mode doesn't allocate actual memory
-    } else {
-        if (offset + size > alloc->size) {
-            // Out of memory
-            tensor->data = NULL;
+    }
+    memset(alloc->hash_set.keys, 0, alloc->hash_set.size * sizeof(struct ggml_tensor *));
+    memset(alloc->hash_values, 0, alloc->hash_set.size * sizeof(struct hash_node));
+    return true;
+}
+
+// ops whose kernels may write dst over src[0] element by element
+static bool ggml_op_can_inplace(enum ggml_op op) {
+    switch (op) {
+        case GGML_OP_SCALE:
+        case GGML_OP_DIAG_MASK_ZERO:
+        case GGML_OP_DIAG_MASK_INF:
+        case GGML_OP_ADD:
+        case GGML_OP_ADD1:
+        case GGML_OP_SUB:
+        case GGML_OP_MUL:
+        case GGML_OP_DIV:
+        case GGML_OP_SQR:
+        case GGML_OP_SQRT:
+        case GGML_OP_LOG:
+        case GGML_OP_UNARY:
+        case GGML_OP_ROPE:
+        case GGML_OP_RMS_NORM:
+        case GGML_OP_SOFT_MAX:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static bool ggml_same_layout(const struct ggml_tensor * a, const struct ggml_tensor * b) {
+    if (a->type != b->type) {
+        return false;
+    }
+    for (int i = 0; i < GGML_MAX_DIMS; i++) {
+        if (a->ne[i] != b->ne[i] || a->nb[i] != b->nb[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void ggml_allocr_allocate_node(ggml_allocr_t alloc, struct ggml_tensor * node) {
+    if (node->data != NULL) {
+        // weights, inputs set by the caller, or already placed
+        return;
+    }
+
+    struct hash_node * hn = ggml_allocr_hash_get(alloc, node);
+
+    if (node->view_src != NULL) {
+        ggml_allocr_allocate_node(alloc, node->view_src);
+        if (node->view_src->data != NULL) {
+            node->data = (char *) node->view_src->data + node->view_offs;
+            node->buffer = node->view_src->buffer;
+        }
+        return;
+    }
+
+    // reuse the memory of a parent that dies here
+    if (ggml_op_can_inplace(node->op) && node->src[0] != NULL && node->src[0]->view_src == NULL) {
+        struct ggml_tensor * parent = node->src[0];
+        struct hash_node * p_hn = ggml_allocr_hash_get(alloc, parent);
+        if (p_hn->allocated && p_hn->n_children == 1 && p_hn->n_views == 0 && ggml_same_layout(node, parent)) {
+            node->data = parent->data;
+            node->buffer = parent->buffer;
+            node->backend = parent->backend;
+            // ownership moves to node, the parent is no longer freed on its own
+            p_hn->allocated = false;
+            hn->allocated = true;
             return;
         }
-        
-        tensor->data = (char *)alloc->data + offset;
-        alloc->offset = offset + size;
     }
+
+    hn->allocated = ggml_allocr_alloc_tensor(alloc, node);
 }
 
-size_t ggml_allocr_get_alloc_size(ggml_allocr_t alloc) {
-    return alloc ? (alloc->measure ? alloc->max_size : alloc->offset) : 0;
+static void ggml_allocr_release(ggml_allocr_t alloc, struct ggml_tensor * t) {
+    struct hash_node * hn = ggml_allocr_hash_get(alloc, t);
+    if (hn->n_children > 0 || hn->n_views > 0) {
+        return;
+    }
+
+    if (t->view_src != NULL) {
+        // a view's memory belongs to its source, which may now be dead as well
+        struct hash_node * v_hn = ggml_allocr_hash_get(alloc, t->view_src);
+        v_hn->n_views--;
+        ggml_allocr_release(alloc, t->view_src);
+        return;
+    }
+
+    if (hn->allocated) {
+        ggml_allocr_free_tensor(alloc, t);
+        hn->allocated = false;
+    }
 }
 
 size_t ggml_allocr_alloc_graph(ggml_allocr_t alloc, struct ggml_cgraph * graph) {
     if (!alloc || !graph) return 0;
-    
-    // Allocate all tensors in the graph
+
+    if (!ggml_allocr_hash_reserve(alloc, 2 * (size_t) (graph->n_nodes + graph->n_leafs))) {
+        return 0;
+    }
+
+    // count number of children and views
     for (int i = 0; i < graph->n_nodes; i++) {
-        ggml_allocr_alloc(alloc, graph->nodes[i]);
+        struct ggml_tensor * node = graph->nodes[i];
+
+        if (node->view_src != NULL) {
+            ggml_allocr_hash_get(alloc, node->view_src)->n_views += 1;
+        }
+
+        for (int j = 0; j < (int) (sizeof(node->src)/sizeof(node->src[0])); j++) {
+            struct ggml_tensor * parent = node->src[j];
+            if (parent == NULL) {
+                continue;
+            }
+            ggml_allocr_hash_get(alloc, parent)->n_children += 1;
+        }
+    }
+
+    // allocate nodes in execution order and free the parents they were the last user of
+    for (int i = 0; i < graph->n_nodes; i++) {
+        struct ggml_tensor * node = graph->nodes[i];
+
+        for (int j = 0; j < (int) (sizeof(node->src)/sizeof(node->src[0])); j++) {
+            if (node->src[j] != NULL) {
+                ggml_allocr_allocate_node(alloc, node->src[j]);
+            }
+        }
+
+        ggml_allocr_allocate_node(alloc, node);
+
+        for (int j = 0; j < (int) (sizeof(node->src)/sizeof(node->src[0])); j++) {
+            struct ggml_tensor * parent = node->src[j];
+            if (parent == NULL) {
+                continue;
+            }
+            ggml_allocr_hash_get(alloc, parent)->n_children -= 1;
+            ggml_allocr_release(alloc, parent);
+        }
     }
-    
+
+    // leafs nobody reads still get memory, e.g. inputs of a partial graph
     for (int i = 0; i < graph->n_leafs; i++) {
-        ggml_allocr_alloc(alloc, graph->leafs[i]);
+        ggml_allocr_allocate_node(alloc, graph->leafs[i]);
     }
-    
-    return ggml_allocr_get_alloc_size(alloc);
+
+    return alloc->max_size;
 }
 
-// Backend allocator functions (stubs for now)
+// Backend allocator functions
 ggml_allocr_t ggml_allocr_new_from_buffer(struct ggml_backend_buffer * buffer) {
     if (!buffer) return NULL;
-    
-    ggml_allocr_t alloc = (ggml_allocr_t)malloc(sizeof(struct ggml_allocr));
-    if (!alloc) return NULL;
-    
-    *alloc = (struct ggml_allocr) {
-        .buffer = buffer,
-        .buffer_owned = false,
-        .data = ggml_backend_buffer_get_base(buffer),
-        .size = ggml_backend_buffer_get_size(buffer),
-        .alignment = ggml_backend_buffer_get_alignment(buffer),
-        .offset = 0,
-        .measure = false,
-        .hash_set = {0},
-        .max_size = 0,
-    };
-    
-    return alloc;
+
+    return ggml_allocr_new_impl(buffer,
+                                ggml_backend_buffer_get_base(buffer),
+                                ggml_backend_buffer_get_size(buffer),
+                                ggml_backend_buffer_get_alignment(buffer),
+                                false);
 }
 
 ggml_allocr_t ggml_allocr_new_from_backend(struct ggml_backend * backend, size_t size) {
     if (!backend) return NULL;
-    
+
     struct ggml_backend_buffer * buffer = ggml_backend_alloc_buffer(backend, size);
     if (!buffer) return NULL;
-    
+
     ggml_allocr_t alloc = ggml_allocr_new_from_buffer(buffer);
     if (alloc) {
         alloc->buffer_owned = true;
+    } else {
+        ggml_backend_buffer_free(buffer);
     }
-    
+
     return alloc;
 }
 
 ggml_allocr_t ggml_allocr_new_measure_from_backend(struct ggml_backend * backend) {
     if (!backend) return NULL;
-    
+
     size_t alignment = ggml_backend_get_alignment(backend);
     return ggml_allocr_new_measure(alignment);
 }
@@ -189,5 +466,5 @@ void ggml_allocr_set_parse_seq(ggml_allocr_t alloc, const int * list, int n) {
     (void)alloc;
     (void)list;
     (void)n;
-    // Legacy function - not implemented in this minimal version
-}
\ No newline at end of file
+    // Nodes are always allocated in graph order
+}
@@ -28,10 +28,15 @@ GGML_API void ggml_allocr_reset(ggml_allocr_t alloc);
 // Allocate tensor
 GGML_API void ggml_allocr_alloc(ggml_allocr_t alloc, struct ggml_tensor * tensor);
 
-// Get size of allocator
+// High-water mark of the buffer, i.e. the size a real buffer must have
 GGML_API size_t ggml_allocr_get_alloc_size(ggml_allocr_t alloc);
 
-// Allocate graph
+// Allocate every tensor of the graph that has no data yet, in execution order.
+// An intermediate's memory is reused as soon as its last consumer is placed, so
+// the tensors of one graph may overlap; only the nodes nobody reads (the outputs)
+// and tensors placed with ggml_allocr_alloc stay valid after compute.
+// In measure mode tensors get fake addresses and the result is the buffer size needed.
+// Returns the high-water mark since the last reset.
 GGML_API size_t ggml_allocr_alloc_graph(ggml_allocr_t alloc, struct ggml_cgraph * graph);
 
 // Backend allocator
@@ -5,12 +5,33 @@
 #include <stdio.h>
 #include <assert.h>
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <stdatomic.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
 // Helper function to calculate tensor size
 size_t ggml_nbytes(const struct ggml_tensor * tensor) {
     if (!tensor) return 0;
     
-    size_t nbytes = ggml_type_size(tensor->type);
-    for (int i = 0; i < 4; i++) {
+    size_t nbytes = ggml_row_size(tensor->type, tensor->ne[0]);
+    for (int i = 1; i < 4; i++) {
         nbytes *= tensor->ne[i];
     }
     return nbytes;
@@ -20,14 +41,40 @@ size_t ggml_nbytes_pad(const struct ggml_tensor * tensor) {
     return (ggml_nbytes(tensor) + 31) & ~31; // 32-byte alignment
 }
 
+#define GGML_CPU_BUFFER_ALIGNMENT 32
+
+// Buffers start on an alignment boundary so that a size measured with
+// ggml_allocr_new_measure() fits exactly
+static void * ggml_aligned_malloc(size_t size) {
+#if defined(_WIN32)
+    return _aligned_malloc(size, GGML_CPU_BUFFER_ALIGNMENT);
+#else
+    void * ptr = NULL;
+    return posix_memalign(&ptr, GGML_CPU_BUFFER_ALIGNMENT, size ? size : GGML_CPU_BUFFER_ALIGNMENT) == 0 ? ptr : NULL;
+#endif
+}
+
+static void ggml_aligned_free(void * ptr) {
+#if defined(_WIN32)
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
 // CPU backend buffer implementation
 static void cpu_buffer_free(ggml_backend_buffer_t buffer) {
     if (buffer->context) {
-        free(buffer->context);
+        ggml_aligned_free(buffer->context);
     }
     free(buffer);
 }
 
+// buffers wrapping caller memory do not own it
+static void cpu_buffer_free_from_ptr(ggml_backend_buffer_t buffer) {
+    free(buffer);
+}
+
 static void * cpu_buffer_get_base(ggml_backend_buffer_t buffer) {
     return buffer->context;
 }
@@ -48,6 +95,7 @@ static void cpu_buffer_get_tensor(ggml_backend_buffer_t buffer, const struct ggm
 }
 
 static bool cpu_buffer_cpy_tensor(ggml_backend_buffer_t buffer, const struct ggml_tensor * src, struct ggml_tensor * dst) {
+    (void)buffer;
     if (src->backend == GGML_BACKEND_CPU && dst->backend == GGML_BACKEND_CPU) {
         memcpy(dst->data, src->data, ggml_nbytes(src));
         return true;
@@ -78,12 +126,12 @@ static struct ggml_backend_buffer_i cpu_backend_buffer_i = {
 static ggml_backend_buffer_t cpu_alloc_buffer(ggml_backend_buffer_type_t buft, size_t size) {
     (void)buft;
     
-    void * data = malloc(size);
+    void * data = ggml_aligned_malloc(size);
     if (!data) return NULL;
     
     ggml_backend_buffer_t buffer = malloc(sizeof(struct ggml_backend_buffer));
     if (!buffer) {
-        free(data);
+        ggml_aligned_free(data);
         return NULL;
     }
     
@@ -98,7 +146,7 @@ static ggml_backend_buffer_t cpu_alloc_buffer(ggml_backend_buffer_type_t buft, s
 
 static size_t cpu_get_alignment(ggml_backend_buffer_type_t buft) {
     (void)buft;
-    return 32; // 32-byte alignment for CPU
+    return GGML_CPU_BUFFER_ALIGNMENT;
 }
 
 static size_t cpu_get_max_size(ggml_backend_buffer_type_t buft) {
@@ -121,20 +169,325 @@ static bool cpu_is_host(ggml_backend_buffer_type_t buft) {
     return true;
 }
 
-static struct ggml_backend_buffer_type_i cpu_backend_buffer_type_i = {
-    .alloc_buffer = cpu_alloc_buffer,
-    .get_alignment = cpu_get_alignment,
-    .get_max_size = cpu_get_max_size,
-    .get_alloc_size = cpu_get_alloc_size,
-    .supports_backend = cpu_supports_backend,
-    .is_host = cpu_is_host,
-};
-
 static struct ggml_backend_buffer_type cpu_backend_buffer_type = {
-    .iface = cpu_backend_buffer_type_i,
+    .iface = {
+        .alloc_buffer = cpu_alloc_buffer,
+        .get_alignment = cpu_get_alignment,
+        .get_max_size = cpu_get_max_size,
+        .get_alloc_size = cpu_get_alloc_size,
+        .supports_backend = cpu_supports_backend,
+        .is_host = cpu_is_host,
+    },
     .context = NULL,
 };
 
+//
+// CPU thread pool
+//
+// The workers live as long as the backend (or until the thread count changes).
+// Each graph node is published to them through a generation counter; its tasks
+// are split into one contiguous range per thread, claimed in chunks, and a
+// thread that runs out of its own range steals chunks from the others. Idle
+// workers spin briefly for the next node and then sleep on a condition variable.
+//
+
+#if defined(_MSC_VER) && !defined(__clang__)
+typedef volatile LONG ggml_atomic_int;
+
+static inline int  ggml_atomic_load(ggml_atomic_int * p)                 { return InterlockedOr(p, 0); }
+static inline void ggml_atomic_store(ggml_atomic_int * p, int v)         { InterlockedExchange(p, v); }
+static inline int  ggml_atomic_fetch_add(ggml_atomic_int * p, int v)     { return InterlockedExchangeAdd(p, v); }
+#else
+typedef atomic_int ggml_atomic_int;
+
+static inline int  ggml_atomic_load(ggml_atomic_int * p)                 { return atomic_load(p); }
+static inline void ggml_atomic_store(ggml_atomic_int * p, int v)         { atomic_store(p, v); }
+static inline int  ggml_atomic_fetch_add(ggml_atomic_int * p, int v)     { return atomic_fetch_add(p, v); }
+#endif
+
+#if defined(_WIN32)
+typedef HANDLE             ggml_thread_t;
+typedef SRWLOCK            ggml_mutex_t;
+typedef CONDITION_VARIABLE ggml_cond_t;
+
+static void ggml_mutex_init   (ggml_mutex_t * m) { InitializeSRWLock(m); }
+static void ggml_mutex_destroy(ggml_mutex_t * m) { (void) m; }
+static void ggml_mutex_lock   (ggml_mutex_t * m) { AcquireSRWLockExclusive(m); }
+static void ggml_mutex_unlock (ggml_mutex_t * m) { ReleaseSRWLockExclusive(m); }
+
+static void ggml_cond_init     (ggml_cond_t * c) { InitializeConditionVariable(c); }
+static void ggml_cond_destroy  (ggml_cond_t * c) { (void) c; }
+static void ggml_cond_wait     (ggml_cond_t * c, ggml_mutex_t * m) { SleepConditionVariableSRW(c, m, INFINITE, 0); }
+static void ggml_cond_broadcast(ggml_cond_t * c) { WakeAllConditionVariable(c); }
+
+static void ggml_thread_yield(void) { SwitchToThread(); }
+#else
+typedef pthread_t       ggml_thread_t;
+typedef pthread_mutex_t ggml_mutex_t;
+typedef pthread_cond_t  ggml_cond_t;
+
+static void ggml_mutex_init   (ggml_mutex_t * m) { pthread_mutex_init(m, NULL); }
+static void ggml_mutex_destroy(ggml_mutex_t * m) { pthread_mutex_destroy(m); }
+static void ggml_mutex_lock   (ggml_mutex_t * m) { pthread_mutex_lock(m); }
+static void ggml_mutex_unlock (ggml_mutex_t * m) { pthread_mutex_unlock(m); }
+
+static void ggml_cond_init     (ggml_cond_t * c) { pthread_cond_init(c, NULL); }
+static void ggml_cond_destroy  (ggml_cond_t * c) { pthread_cond_destroy(c); }
+static void ggml_cond_wait     (ggml_cond_t * c, ggml_mutex_t * m) { pthread_cond_wait(c, m); }
+static void ggml_cond_broadcast(ggml_cond_t * c) { pthread_cond_broadcast(c); }
+
+static void ggml_thread_yield(void) { sched_yield(); }
+#endif
+
+static inline void ggml_cpu_relax(void) {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+    __asm__ __volatile__("yield");
+#endif
+}
+
+// pause-spin, then yield, before a worker goes to sleep
+#define GGML_POOL_N_SPIN  4096
+#define GGML_POOL_N_YIELD 64
+
+// tasks claimed per grab, relative to the per-thread share
+#define GGML_POOL_CHUNKS_PER_THREAD 4
+
+struct ggml_cpu_pool_range {
+    ggml_atomic_int next;
+    int             end;
+    char            pad[64 - sizeof(ggml_atomic_int) - sizeof(int)]; // one cache line per thread
+};
+
+struct ggml_cpu_pool;
+
+struct ggml_cpu_pool_worker {
+    struct ggml_cpu_pool * pool;
+    ggml_thread_t          thread;
+    int                    ith;
+};
+
+struct ggml_cpu_pool {
+    int n_threads;
+
+    struct ggml_cpu_pool_worker * workers;  // n_threads - 1, the caller is thread 0
+    struct ggml_cpu_pool_range  * ranges;   // n_threads
+
+    ggml_mutex_t mutex;
+    ggml_cond_t  cond;
+
+    ggml_atomic_int generation; // bumped once per published node
+    ggml_atomic_int n_sleeping;
+    ggml_atomic_int n_done;     // workers finished with the current node
+    ggml_atomic_int stop;
+
+    // current node, valid while generation is stable
+    struct ggml_tensor * node;
+    int                  chunk;
+
+    // per-thread scratch, work_stride bytes each
+    uint8_t * work_data;
+    size_t    work_size;
+    size_t    work_stride;
+};
+
+static void ggml_cpu_pool_run(struct ggml_cpu_pool * pool, int ith) {
+    const int nth = pool->n_threads;
+    const int chunk = pool->chunk;
+
+    struct ggml_compute_params params = {
+        .ith   = ith,
+        .nth   = nth,
+        .wsize = pool->work_size,
+        .wdata = pool->work_data + (size_t) ith*pool->work_stride,
+    };
+
+    // own range first, then steal from the others in ring order
+    for (int k = 0; k < nth; ++k) {
+        struct ggml_cpu_pool_range * range = &pool->ranges[(ith + k) % nth];
+        for (;;) {
+            const int it0 = ggml_atomic_fetch_add(&range->next, chunk);
+            if (it0 >= range->end) {
+                break;
+            }
+            const int it1 = it0 + chunk < range->end ? it0 + chunk : range->end;
+            ggml_compute_forward_range(&params, pool->node, it0, it1);
+        }
+    }
+}
+
+// wait until the generation moves past seen; returns false on shutdown
+static bool ggml_cpu_pool_wait(struct ggml_cpu_pool * pool, int seen) {
+    for (int i = 0; i < GGML_POOL_N_SPIN + GGML_POOL_N_YIELD; ++i) {
+        if (ggml_atomic_load(&pool->generation) != seen || ggml_atomic_load(&pool->stop)) {
+            return !ggml_atomic_load(&pool->stop);
+        }
+        if (i < GGML_POOL_N_SPIN) {
+            ggml_cpu_relax();
+        } else {
+            ggml_thread_yield();
+        }
+    }
+
+    ggml_mutex_lock(&pool->mutex);
+    ggml_atomic_fetch_add(&pool->n_sleeping, 1);
+    while (ggml_atomic_load(&pool->generation) == seen && !ggml_atomic_load(&pool->stop)) {
+        ggml_cond_wait(&pool->cond, &pool->mutex);
+    }
+    ggml_atomic_fetch_add(&pool->n_sleeping, -1);
+    ggml_mutex_unlock(&pool->mutex);
+
+    return !ggml_atomic_load(&pool->stop);
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI ggml_cpu_pool_thread(LPVOID arg) {
+#else
+static void * ggml_cpu_pool_thread(void * arg) {
+#endif
+    struct ggml_cpu_pool_worker * worker = (struct ggml_cpu_pool_worker *) arg;
+    struct ggml_cpu_pool * pool = worker->pool;
+
+    int seen = 0;
+    while (ggml_cpu_pool_wait(pool, seen)) {
+        seen = ggml_atomic_load(&pool->generation);
+        ggml_cpu_pool_run(pool, worker->ith);
+        ggml_atomic_fetch_add(&pool->n_done, 1);
+    }
+
+    return 0;
+}
+
+static void ggml_cpu_pool_wake(struct ggml_cpu_pool * pool) {
+    // pairs with the re-check under the mutex in ggml_cpu_pool_wait
+    if (ggml_atomic_load(&pool->n_sleeping) > 0) {
+        ggml_mutex_lock(&pool->mutex);
+        ggml_cond_broadcast(&pool->cond);
+        ggml_mutex_unlock(&pool->mutex);
+    }
+}
+
+static void ggml_cpu_pool_free(struct ggml_cpu_pool * pool) {
+    if (!pool) {
+        return;
+    }
+
+    ggml_atomic_store(&pool->stop, 1);
+    ggml_mutex_lock(&pool->mutex);
+    ggml_cond_broadcast(&pool->cond);
+    ggml_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->n_threads - 1; ++i) {
+#if defined(_WIN32)
+        WaitForSingleObject(pool->workers[i].thread, INFINITE);
+        CloseHandle(pool->workers[i].thread);
+#else
+        pthread_join(pool->workers[i].thread, NULL);
+#endif
+    }
+
+    ggml_cond_destroy(&pool->cond);
+    ggml_mutex_destroy(&pool->mutex);
+
+    free(pool->work_data);
+    free(pool->ranges);
+    free(pool->workers);
+    free(pool);
+}
+
+static struct ggml_cpu_pool * ggml_cpu_pool_new(int n_threads) {
+    struct ggml_cpu_pool * pool = calloc(1, sizeof(struct ggml_cpu_pool));
+    if (!pool) {
+        return NULL;
+    }
+
+    pool->n_threads = n_threads;
+    pool->ranges  = calloc(n_threads, sizeof(struct ggml_cpu_pool_range));
+    pool->workers = calloc(n_threads, sizeof(struct ggml_cpu_pool_worker));
+    if (!pool->ranges || !pool->workers) {
+        free(pool->ranges);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+
+    ggml_mutex_init(&pool->mutex);
+    ggml_cond_init(&pool->cond);
+
+    for (int i = 0; i < n_threads - 1; ++i) {
+        struct ggml_cpu_pool_worker * worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->ith  = i + 1;
+#if defined(_WIN32)
+        worker->thread = CreateThread(NULL, 0, ggml_cpu_pool_thread, worker, 0, NULL);
+        const bool ok = worker->thread != NULL;
+#else
+        const bool ok = pthread_create(&worker->thread, NULL, ggml_cpu_pool_thread, worker) == 0;
+#endif
+        if (!ok) {
+            // run with the threads that did start
+            pool->n_threads = i + 1;
+            break;
+        }
+    }
+
+    return pool;
+}
+
+static bool ggml_cpu_pool_reserve(struct ggml_cpu_pool * pool, size_t work_size) {
+    const size_t stride = ggml_up(work_size, 64);
+    if (stride <= pool->work_stride) {
+        return true;
+    }
+
+    uint8_t * data = malloc(stride*pool->n_threads);
+    if (!data) {
+        return false;
+    }
+
+    free(pool->work_data);
+    pool->work_data   = data;
+    pool->work_stride = stride;
+    return true;
+}
+
+static void ggml_cpu_pool_compute_node(struct ggml_cpu_pool * pool, struct ggml_tensor * node, int n_tasks) {
+    const int nth = pool->n_threads;
+
+    pool->node  = node;
+    pool->chunk = n_tasks/(nth*GGML_POOL_CHUNKS_PER_THREAD) > 1 ? n_tasks/(nth*GGML_POOL_CHUNKS_PER_THREAD) : 1;
+
+    for (int i = 0; i < nth; ++i) {
+        ggml_atomic_store(&pool->ranges[i].next, (int) ((int64_t) n_tasks*i/nth));
+        pool->ranges[i].end = (int) ((int64_t) n_tasks*(i + 1)/nth);
+    }
+
+    if (nth == 1) {
+        ggml_cpu_pool_run(pool, 0);
+        return;
+    }
+
+    ggml_atomic_store(&pool->n_done, 0);
+    ggml_atomic_fetch_add(&pool->generation, 1);
+    ggml_cpu_pool_wake(pool);
+
+    ggml_cpu_pool_run(pool, 0);
+
+    for (int i = 0; ggml_atomic_load(&pool->n_done) < nth - 1; ++i) {
+        if (i < GGML_POOL_N_SPIN) {
+            ggml_cpu_relax();
+        } else {
+            ggml_thread_yield();
+        }
+    }
+}
+
+struct ggml_backend_cpu_context {
+    int n_threads;
+    struct ggml_cpu_pool * pool; // created on first use
+};
+
 // CPU backend implementation
 static const char * cpu_backend_name(ggml_backend_t backend) {
     (void)backend;
@@ -142,6 +495,11 @@ static const char * cpu_backend_name(ggml_backend_t backend) {
 }
 
 static void cpu_backend_free(ggml_backend_t backend) {
+    struct ggml_backend_cpu_context * cpu_ctx = (struct ggml_backend_cpu_context *) backend->context;
+    if (cpu_ctx) {
+        ggml_cpu_pool_free(cpu_ctx->pool);
+        free(cpu_ctx);
+    }
     free(backend);
 }
 
@@ -178,13 +536,38 @@ static bool cpu_backend_graph_plan_compute(ggml_backend_t backend, struct ggml_c
 }
 
 static bool cpu_backend_graph_compute(ggml_backend_t backend, struct ggml_cgraph * cgraph) {
-    (void)backend;
-    
+    struct ggml_backend_cpu_context * cpu_ctx = (struct ggml_backend_cpu_context *) backend->context;
+
+    if (!cpu_ctx->pool) {
+        cpu_ctx->pool = ggml_cpu_pool_new(cpu_ctx->n_threads);
+        if (!cpu_ctx->pool) {
+            return false;
+        }
+    }
+
+    struct ggml_cpu_pool * pool = cpu_ctx->pool;
+
+    size_t work_size = 0;
+    for (int i = 0; i < cgraph->n_nodes; i++) {
+        const size_t size = ggml_compute_forward_work_size(cgraph->nodes[i]);
+        work_size = size > work_size ? size : work_size;
+    }
+    if (!ggml_cpu_pool_reserve(pool, work_size)) {
+        return false;
+    }
+    pool->work_size = work_size;
+
     for (int i = 0; i < cgraph->n_nodes; i++) {
         struct ggml_tensor * node = cgraph->nodes[i];
-        ggml_compute_forward(node, NULL);
+
+        const int n_tasks = ggml_get_n_tasks(node);
+        if (n_tasks == 0) {
+            continue;
+        }
+
+        ggml_cpu_pool_compute_node(pool, node, n_tasks);
     }
-    
+
     return true;
 }
 
@@ -309,11 +692,20 @@ bool ggml_backend_supports_op(ggml_backend_t backend, const struct ggml_tensor *
 
 // CPU backend specific functions
 ggml_backend_t ggml_backend_cpu_init(void) {
+    struct ggml_backend_cpu_context * cpu_ctx = malloc(sizeof(struct ggml_backend_cpu_context));
+    if (!cpu_ctx) return NULL;
+    
+    cpu_ctx->n_threads = GGML_DEFAULT_N_THREADS;
+    cpu_ctx->pool = NULL;
+    
     ggml_backend_t backend = malloc(sizeof(struct ggml_backend));
-    if (!backend) return NULL;
+    if (!backend) {
+        free(cpu_ctx);
+        return NULL;
+    }
     
     backend->iface = cpu_backend_i;
-    backend->context = NULL;
+    backend->context = cpu_ctx;
     
     return backend;
 }
@@ -323,9 +715,21 @@ bool ggml_backend_is_cpu(ggml_backend_t backend) {
 }
 
 void ggml_backend_cpu_set_n_threads(ggml_backend_t backend_cpu, int n_threads) {
-    (void)backend_cpu;
-    (void)n_threads;
-    // Not implemented in this minimal version
+    if (!ggml_backend_is_cpu(backend_cpu)) {
+        return;
+    }
+
+    struct ggml_backend_cpu_context * cpu_ctx = (struct ggml_backend_cpu_context *) backend_cpu->context;
+
+    n_threads = n_threads > 0 ? n_threads : 1;
+    if (cpu_ctx->n_threads == n_threads) {
+        return;
+    }
+
+    // the pool is rebuilt with the new size on the next graph_compute
+    cpu_ctx->n_threads = n_threads;
+    ggml_cpu_pool_free(cpu_ctx->pool);
+    cpu_ctx->pool = NULL;
 }
 
 ggml_backend_buffer_type_t ggml_backend_cpu_buffer_type(void) {
@@ -337,6 +741,7 @@ ggml_backend_buffer_t ggml_backend_cpu_buffer_from_ptr(void * ptr, size_t size)
     if (!buffer) return NULL;
     
     buffer->iface = cpu_backend_buffer_i;
+    buffer->iface.free_buffer = cpu_buffer_free_from_ptr;
     buffer->buft = &cpu_backend_buffer_type;
     buffer->context = ptr;
     buffer->size = size;
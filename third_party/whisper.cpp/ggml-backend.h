@@ -16,6 +16,16 @@ typedef struct ggml_backend_buffer * ggml_backend_buffer_t;
 struct ggml_backend;
 typedef struct ggml_backend * ggml_backend_t;
 
+// Backend buffer type
+struct ggml_backend_buffer_type;
+typedef struct ggml_backend_buffer_type * ggml_backend_buffer_type_t;
+
+enum ggml_backend_buffer_usage {
+    GGML_BACKEND_BUFFER_USAGE_ANY = 0,
+    GGML_BACKEND_BUFFER_USAGE_WEIGHTS = 1,
+    GGML_BACKEND_BUFFER_USAGE_COMPUTE = 2,
+};
+
 // Backend buffer interface
 typedef struct ggml_backend_buffer_i {
     void (*free_buffer)(ggml_backend_buffer_t buffer);
@@ -28,7 +38,7 @@ typedef struct ggml_backend_buffer_i {
     void (*reset)(ggml_backend_buffer_t buffer);
 } ggml_backend_buffer_i;
 
-// Backend buffer type
+// Backend buffer type interface
 typedef struct ggml_backend_buffer_type_i {
     ggml_backend_buffer_t (*alloc_buffer)(ggml_backend_buffer_type_t buft, size_t size);
     size_t (*get_alignment)(ggml_backend_buffer_type_t buft);
@@ -43,8 +53,6 @@ typedef struct ggml_backend_buffer_type {
     void * context;
 } ggml_backend_buffer_type;
 
-typedef ggml_backend_buffer_type * ggml_backend_buffer_type_t;
-
 // Backend buffer
 struct ggml_backend_buffer {
     struct ggml_backend_buffer_i iface;
@@ -54,12 +62,6 @@ struct ggml_backend_buffer {
     enum ggml_backend_buffer_usage usage;
 };
 
-enum ggml_backend_buffer_usage {
-    GGML_BACKEND_BUFFER_USAGE_ANY = 0,
-    GGML_BACKEND_BUFFER_USAGE_WEIGHTS = 1,
-    GGML_BACKEND_BUFFER_USAGE_COMPUTE = 2,
-};
-
 // Backend interface
 typedef struct ggml_backend_i {
     const char * (*get_name)(ggml_backend_t backend);
@@ -21,9 +21,18 @@ extern "C" {
 #define GGML_DEFAULT_N_THREADS 4
 #define GGML_DEFAULT_GRAPH_SIZE 2048
 
-// Forward declarations
-struct ggml_cgraph;
-struct ggml_hash_set;
+// Graph evaluation order
+enum ggml_cgraph_eval_order {
+    GGML_CGRAPH_EVAL_ORDER_LEFT_TO_RIGHT = 0,
+    GGML_CGRAPH_EVAL_ORDER_RIGHT_TO_LEFT,
+    GGML_CGRAPH_EVAL_ORDER_COUNT
+};
+
+// Hash set for visited nodes
+struct ggml_hash_set {
+    size_t size;
+    struct ggml_tensor ** keys;
+};
 
 // Graph structure
 struct ggml_cgraph {
@@ -45,19 +54,6 @@ struct ggml_cgraph {
     int64_t perf_time_us;
 };
 
-// Graph evaluation order
-enum ggml_cgraph_eval_order {
-    GGML_CGRAPH_EVAL_ORDER_LEFT_TO_RIGHT = 0,
-    GGML_CGRAPH_EVAL_ORDER_RIGHT_TO_LEFT,
-    GGML_CGRAPH_EVAL_ORDER_COUNT
-};
-
-// Hash set for visited nodes
-struct ggml_hash_set {
-    size_t size;
-    struct ggml_tensor ** keys;
-};
-
 // Thread pool
 struct ggml_compute_state_shared {
     const struct ggml_cgraph * cgraph;
@@ -107,78 +103,86 @@ static inline size_t ggml_up(size_t n, size_t m) {
     return (n + m - 1) & ~(m - 1);
 }
 
-// Type conversion helpers
-uint16_t ggml_fp32_to_fp16(float x);
-float    ggml_fp16_to_fp32(uint16_t h);
-
-void ggml_fp16_to_fp32_row(const uint16_t * x, float * y, int n);
-void ggml_fp32_to_fp16_row(const float * x, uint16_t * y, int n);
-
-// Quantization functions
-void quantize_row_q4_0_reference(const float * restrict x, block_q4_0 * restrict y, int k);
-void quantize_row_q4_1_reference(const float * restrict x, block_q4_1 * restrict y, int k);
-void quantize_row_q5_0_reference(const float * restrict x, block_q5_0 * restrict y, int k);
-void quantize_row_q5_1_reference(const float * restrict x, block_q5_1 * restrict y, int k);
-void quantize_row_q8_0_reference(const float * restrict x, block_q8_0 * restrict y, int k);
-void quantize_row_q8_1_reference(const float * restrict x, block_q8_1 * restrict y, int k);
-
-void dequantize_row_q4_0(const block_q4_0 * restrict x, float * restrict y, int k);
-void dequantize_row_q4_1(const block_q4_1 * restrict x, float * restrict y, int k);
-void dequantize_row_q5_0(const block_q5_0 * restrict x, float * restrict y, int k);
-void dequantize_row_q5_1(const block_q5_1 * restrict x, float * restrict y, int k);
-void dequantize_row_q8_0(const block_q8_0 * restrict x, float * restrict y, int k);
-void dequantize_row_q8_1(const block_q8_1 * restrict x, float * restrict y, int k);
-
-// Quantization block structures (mock definitions)
-typedef struct {
-    uint16_t d;          // delta
-    uint8_t  qs[16];     // nibbles / quants
-} block_q4_0;
-
-typedef struct {
-    uint16_t d;          // delta
-    uint16_t m;          // min
-    uint8_t  qs[16];     // nibbles / quants
-} block_q4_1;
-
-typedef struct {
-    uint16_t d;          // delta
-    uint8_t  qh[4];      // 5-th bit of quants
-    uint8_t  qs[16];     // nibbles / quants
-} block_q5_0;
-
-typedef struct {
-    uint16_t d;          // delta
-    uint16_t m;          // min
-    uint8_t  qh[4];      // 5-th bit of quants
-    uint8_t  qs[16];     // nibbles / quants
-} block_q5_1;
-
-typedef struct {
-    float    d;          // delta
-    int8_t   qs[32];     // quants
-} block_q8_0;
-
-typedef struct {
-    float    d;          // delta
-    float    s;          // d * sum(qs[i]) / 256
-    int8_t   qs[32];     // quants
-} block_q8_1;
+// FP16 <-> FP32
+// bit-exact conversions from https://github.com/Maratyszcza/FP16
+
+static inline float ggml_fp32_from_bits(uint32_t w) {
+    union {
+        uint32_t as_bits;
+        float    as_value;
+    } fp32 = { w };
+    return fp32.as_value;
+}
+
+static inline uint32_t ggml_fp32_to_bits(float f) {
+    union {
+        float    as_value;
+        uint32_t as_bits;
+    } fp32 = { f };
+    return fp32.as_bits;
+}
+
+static inline float ggml_compute_fp16_to_fp32(ggml_fp16_t h) {
+    const uint32_t w = (uint32_t) h << 16;
+    const uint32_t sign = w & UINT32_C(0x80000000);
+    const uint32_t two_w = w + w;
+
+    const uint32_t exp_offset = UINT32_C(0xE0) << 23;
+    const float exp_scale = 0x1.0p-112f;
+    const float normalized_value = ggml_fp32_from_bits((two_w >> 4) + exp_offset) * exp_scale;
+
+    const uint32_t magic_mask = UINT32_C(126) << 23;
+    const float magic_bias = 0.5f;
+    const float denormalized_value = ggml_fp32_from_bits((two_w >> 17) | magic_mask) - magic_bias;
+
+    const uint32_t denormalized_cutoff = UINT32_C(1) << 27;
+    const uint32_t result = sign |
+        (two_w < denormalized_cutoff ? ggml_fp32_to_bits(denormalized_value) : ggml_fp32_to_bits(normalized_value));
+    return ggml_fp32_from_bits(result);
+}
+
+static inline ggml_fp16_t ggml_compute_fp32_to_fp16(float f) {
+    const float scale_to_inf = 0x1.0p+112f;
+    const float scale_to_zero = 0x1.0p-110f;
+    const uint32_t w = ggml_fp32_to_bits(f);
+    const float abs_f = ggml_fp32_from_bits(w & UINT32_C(0x7FFFFFFF));
+    float base = (abs_f * scale_to_inf) * scale_to_zero;
+
+    const uint32_t shl1_w = w + w;
+    const uint32_t sign = w & UINT32_C(0x80000000);
+    uint32_t bias = shl1_w & UINT32_C(0xFF000000);
+    if (bias < UINT32_C(0x71000000)) {
+        bias = UINT32_C(0x71000000);
+    }
+
+    base = ggml_fp32_from_bits((bias >> 1) + UINT32_C(0x07800000)) + base;
+    const uint32_t bits = ggml_fp32_to_bits(base);
+    const uint32_t exp_bits = (bits >> 13) & UINT32_C(0x00007C00);
+    const uint32_t mantissa_bits = bits & UINT32_C(0x00000FFF);
+    const uint32_t nonsign = exp_bits + mantissa_bits;
+    return (ggml_fp16_t) ((sign >> 16) | (shl1_w > UINT32_C(0xFF000000) ? UINT16_C(0x7E00) : nonsign));
+}
+
+#define GGML_FP16_TO_FP32(x) ggml_compute_fp16_to_fp32(x)
+#define GGML_FP32_TO_FP16(x) ggml_compute_fp32_to_fp16(x)
+
+// Hash set of tensor pointers, open addressing with linear probing
+#define GGML_HASHTABLE_FULL           ((size_t)-1)
+#define GGML_HASHTABLE_ALREADY_EXISTS ((size_t)-2)
+
+size_t ggml_hash_size(size_t min_sz);
+size_t ggml_hash_find(const struct ggml_hash_set hash_set, struct ggml_tensor * key);
+bool   ggml_hash_contains(const struct ggml_hash_set hash_set, struct ggml_tensor * key);
+size_t ggml_hash_insert(struct ggml_hash_set hash_set, struct ggml_tensor * key);
+size_t ggml_hash_find_or_insert(struct ggml_hash_set hash_set, struct ggml_tensor * key);
 
 // Graph functions
-struct ggml_cgraph * ggml_new_graph(struct ggml_context * ctx);
-struct ggml_cgraph * ggml_new_graph_custom(struct ggml_context * ctx, size_t size, bool grads);
 struct ggml_cgraph * ggml_graph_dup(struct ggml_context * ctx, struct ggml_cgraph * cgraph);
 struct ggml_cgraph   ggml_graph_view(struct ggml_cgraph * cgraph, int i0, int i1);
 void ggml_graph_cpy(struct ggml_cgraph * src, struct ggml_cgraph * dst);
 void ggml_graph_reset(struct ggml_cgraph * cgraph);
-void ggml_graph_clear(struct ggml_cgraph * cgraph);
-
-size_t ggml_graph_overhead(void);
-size_t ggml_graph_overhead_custom(size_t size, bool grads);
 
 // Build operations
-void ggml_build_forward_expand (struct ggml_cgraph * cgraph, struct ggml_tensor * tensor);
 void ggml_build_backward_expand(struct ggml_context * ctx, struct ggml_cgraph * gf, struct ggml_cgraph * gb, bool keep);
 
 // Compute functions
@@ -2,92 +2,422 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <float.h>
+#include <assert.h>
 
-// Mock implementations for quantization functions
-// In a real implementation, these would contain optimized quantization algorithms
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GGML_QUANTS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define GGML_QUANTS_NEON 1
+#include <arm_neon.h>
+#endif
 
-void quantize_row_q4_0_reference(const float * restrict x, void * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
+// The AVX2 kernels are built per function and selected at runtime (see ggml_init);
+// MSVC accepts the intrinsics without a target flag
+#if defined(GGML_QUANTS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define GGML_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#else
+#define GGML_TARGET_AVX2
+#endif
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+//
+// Reference quantization, one block of 32 values at a time
+//
+
+void quantize_row_q4_0_reference(const float * restrict x, void * restrict vy, int k) {
+    static const int qk = QK4_0;
+
+    assert(k % qk == 0);
+
+    block_q4_0 * restrict y = vy;
+    const int nb = k / qk;
+
+    for (int i = 0; i < nb; i++) {
+        float amax = 0.0f; // absolute max
+        float max  = 0.0f;
+
+        for (int j = 0; j < qk; j++) {
+            const float v = x[i*qk + j];
+            if (amax < fabsf(v)) {
+                amax = fabsf(v);
+                max  = v;
+            }
+        }
+
+        const float d  = max / -8;
+        const float id = d ? 1.0f/d : 0.0f;
+
+        y[i].d = GGML_FP32_TO_FP16(d);
+
+        for (int j = 0; j < qk/2; ++j) {
+            const float x0 = x[i*qk + 0    + j]*id;
+            const float x1 = x[i*qk + qk/2 + j]*id;
+
+            const uint8_t xi0 = MIN(15, (int8_t)(x0 + 8.5f));
+            const uint8_t xi1 = MIN(15, (int8_t)(x1 + 8.5f));
+
+            y[i].qs[j]  = xi0;
+            y[i].qs[j] |= xi1 << 4;
+        }
+    }
 }
 
 void quantize_row_q4_0(const float * restrict x, void * restrict y, int k) {
     quantize_row_q4_0_reference(x, y, k);
 }
 
-void dequantize_row_q4_0(const void * restrict x, float * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
-}
+void quantize_row_q4_1_reference(const float * restrict x, void * restrict vy, int k) {
+    const int qk = QK4_1;
+
+    assert(k % qk == 0);
+
+    block_q4_1 * restrict y = vy;
+    const int nb = k / qk;
+
+    for (int i = 0; i < nb; i++) {
+        float min = FLT_MAX;
+        float max = -FLT_MAX;
+
+        for (int j = 0; j < qk; j++) {
+            const float v = x[i*qk + j];
+
+            if (v < min) min = v;
+            if (v > max) max = v;
+        }
+
+        const float d  = (max - min) / ((1 << 4) - 1);
+        const float id = d ? 1.0f/d : 0.0f;
+
+        y[i].d = GGML_FP32_TO_FP16(d);
+        y[i].m = GGML_FP32_TO_FP16(min);
 
-void quantize_row_q4_1_reference(const float * restrict x, void * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
+        for (int j = 0; j < qk/2; ++j) {
+            const float x0 = (x[i*qk + 0    + j] - min)*id;
+            const float x1 = (x[i*qk + qk/2 + j] - min)*id;
+
+            const uint8_t xi0 = MIN(15, (int8_t)(x0 + 0.5f));
+            const uint8_t xi1 = MIN(15, (int8_t)(x1 + 0.5f));
+
+            y[i].qs[j]  = xi0;
+            y[i].qs[j] |= xi1 << 4;
+        }
+    }
 }
 
 void quantize_row_q4_1(const float * restrict x, void * restrict y, int k) {
     quantize_row_q4_1_reference(x, y, k);
 }
 
-void dequantize_row_q4_1(const void * restrict x, float * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
-}
+void quantize_row_q5_0_reference(const float * restrict x, void * restrict vy, int k) {
+    static const int qk = QK5_0;
+
+    assert(k % qk == 0);
+
+    block_q5_0 * restrict y = vy;
+    const int nb = k / qk;
+
+    for (int i = 0; i < nb; i++) {
+        float amax = 0.0f; // absolute max
+        float max  = 0.0f;
+
+        for (int j = 0; j < qk; j++) {
+            const float v = x[i*qk + j];
+            if (amax < fabsf(v)) {
+                amax = fabsf(v);
+                max  = v;
+            }
+        }
+
+        const float d  = max / -16;
+        const float id = d ? 1.0f/d : 0.0f;
+
+        y[i].d = GGML_FP32_TO_FP16(d);
+
+        uint32_t qh = 0;
 
-void quantize_row_q5_0_reference(const float * restrict x, void * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
+        for (int j = 0; j < qk/2; ++j) {
+            const float x0 = x[i*qk + 0    + j]*id;
+            const float x1 = x[i*qk + qk/2 + j]*id;
+
+            const uint8_t xi0 = MIN(31, (int8_t)(x0 + 16.5f));
+            const uint8_t xi1 = MIN(31, (int8_t)(x1 + 16.5f));
+
+            y[i].qs[j] = (xi0 & 0x0F) | ((xi1 & 0x0F) << 4);
+
+            // get the 5-th bit and store it in qh at the right position
+            qh |= ((xi0 & 0x10u) >> 4) << (j + 0);
+            qh |= ((xi1 & 0x10u) >> 4) << (j + qk/2);
+        }
+
+        memcpy(&y[i].qh, &qh, sizeof(qh));
+    }
 }
 
 void quantize_row_q5_0(const float * restrict x, void * restrict y, int k) {
     quantize_row_q5_0_reference(x, y, k);
 }
 
-void dequantize_row_q5_0(const void * restrict x, float * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
-}
+void quantize_row_q5_1_reference(const float * restrict x, void * restrict vy, int k) {
+    const int qk = QK5_1;
+
+    assert(k % qk == 0);
+
+    block_q5_1 * restrict y = vy;
+    const int nb = k / qk;
+
+    for (int i = 0; i < nb; i++) {
+        float min = FLT_MAX;
+        float max = -FLT_MAX;
+
+        for (int j = 0; j < qk; j++) {
+            const float v = x[i*qk + j];
+
+            if (v < min) min = v;
+            if (v > max) max = v;
+        }
 
-void quantize_row_q5_1_reference(const float * restrict x, void * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
+        const float d  = (max - min) / ((1 << 5) - 1);
+        const float id = d ? 1.0f/d : 0.0f;
+
+        y[i].d = GGML_FP32_TO_FP16(d);
+        y[i].m = GGML_FP32_TO_FP16(min);
+
+        uint32_t qh = 0;
+
+        for (int j = 0; j < qk/2; ++j) {
+            const float x0 = (x[i*qk + 0    + j] - min)*id;
+            const float x1 = (x[i*qk + qk/2 + j] - min)*id;
+
+            const uint8_t xi0 = MIN(31, (uint8_t)(x0 + 0.5f));
+            const uint8_t xi1 = MIN(31, (uint8_t)(x1 + 0.5f));
+
+            y[i].qs[j] = (xi0 & 0x0F) | ((xi1 & 0x0F) << 4);
+
+            // get the 5-th bit and store it in qh at the right position
+            qh |= ((xi0 & 0x10u) >> 4) << (j + 0);
+            qh |= ((xi1 & 0x10u) >> 4) << (j + qk/2);
+        }
+
+        memcpy(&y[i].qh, &qh, sizeof(y[i].qh));
+    }
 }
 
 void quantize_row_q5_1(const float * restrict x, void * restrict y, int k) {
     quantize_row_q5_1_reference(x, y, k);
 }
 
-void dequantize_row_q5_1(const void * restrict x, float * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
-}
+void quantize_row_q8_0_reference(const float * restrict x, void * restrict vy, int k) {
+    assert(k % QK8_0 == 0);
+
+    block_q8_0 * restrict y = vy;
+    const int nb = k / QK8_0;
+
+    for (int i = 0; i < nb; i++) {
+        float amax = 0.0f; // absolute max
 
-void quantize_row_q8_0_reference(const float * restrict x, void * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
+        for (int j = 0; j < QK8_0; j++) {
+            const float v = x[i*QK8_0 + j];
+            amax = MAX(amax, fabsf(v));
+        }
+
+        const float d  = amax / ((1 << 7) - 1);
+        const float id = d ? 1.0f/d : 0.0f;
+
+        y[i].d = GGML_FP32_TO_FP16(d);
+
+        for (int j = 0; j < QK8_0; ++j) {
+            const float x0 = x[i*QK8_0 + j]*id;
+
+            y[i].qs[j] = (int8_t) roundf(x0);
+        }
+    }
 }
 
 void quantize_row_q8_0(const float * restrict x, void * restrict y, int k) {
     quantize_row_q8_0_reference(x, y, k);
 }
 
-void dequantize_row_q8_0(const void * restrict x, float * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
-}
+void quantize_row_q8_1_reference(const float * restrict x, void * restrict vy, int k) {
+    assert(k % QK8_1 == 0);
+
+    block_q8_1 * restrict y = vy;
+    const int nb = k / QK8_1;
+
+    for (int i = 0; i < nb; i++) {
+        float amax = 0.0f; // absolute max
+
+        for (int j = 0; j < QK8_1; j++) {
+            const float v = x[i*QK8_1 + j];
+            amax = MAX(amax, fabsf(v));
+        }
+
+        const float d  = amax / ((1 << 7) - 1);
+        const float id = d ? 1.0f/d : 0.0f;
+
+        y[i].d = d;
 
-void quantize_row_q8_1_reference(const float * restrict x, void * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
+        int sum = 0;
+
+        for (int j = 0; j < QK8_1/2; ++j) {
+            const float v0 = x[i*QK8_1 + j]*id;
+            const float v1 = x[i*QK8_1 + QK8_1/2 + j]*id;
+
+            y[i].qs[          j] = (int8_t) roundf(v0);
+            y[i].qs[QK8_1/2 + j] = (int8_t) roundf(v1);
+
+            sum += y[i].qs[          j];
+            sum += y[i].qs[QK8_1/2 + j];
+        }
+
+        y[i].s = sum*d;
+    }
 }
 
 void quantize_row_q8_1(const float * restrict x, void * restrict y, int k) {
     quantize_row_q8_1_reference(x, y, k);
 }
 
-void dequantize_row_q8_1(const void * restrict x, float * restrict y, int k) {
-    (void)x; (void)y; (void)k;
-    // Mock implementation - not functional
+//
+// Dequantization
+//
+
+void dequantize_row_q4_0(const void * restrict vx, float * restrict y, int k) {
+    static const int qk = QK4_0;
+
+    assert(k % qk == 0);
+
+    const block_q4_0 * restrict x = vx;
+    const int nb = k / qk;
+
+    for (int i = 0; i < nb; i++) {
+        const float d = GGML_FP16_TO_FP32(x[i].d);
+
+        for (int j = 0; j < qk/2; ++j) {
+            const int x0 = (x[i].qs[j] & 0x0F) - 8;
+            const int x1 = (x[i].qs[j] >>   4) - 8;
+
+            y[i*qk + j + 0   ] = x0*d;
+            y[i*qk + j + qk/2] = x1*d;
+        }
+    }
+}
+
+void dequantize_row_q4_1(const void * restrict vx, float * restrict y, int k) {
+    static const int qk = QK4_1;
+
+    assert(k % qk == 0);
+
+    const block_q4_1 * restrict x = vx;
+    const int nb = k / qk;
+
+    for (int i = 0; i < nb; i++) {
+        const float d = GGML_FP16_TO_FP32(x[i].d);
+        const float m = GGML_FP16_TO_FP32(x[i].m);
+
+        for (int j = 0; j < qk/2; ++j) {
+            const int x0 = (x[i].qs[j] & 0x0F);
+            const int x1 = (x[i].qs[j] >>   4);
+
+            y[i*qk + j + 0   ] = x0*d + m;
+            y[i*qk + j + qk/2] = x1*d + m;
+        }
+    }
+}
+
+void dequantize_row_q5_0(const void * restrict vx, float * restrict y, int k) {
+    static const int qk = QK5_0;
+
+    assert(k % qk == 0);
+
+    const block_q5_0 * restrict x = vx;
+    const int nb = k / qk;
+
+    for (int i = 0; i < nb; i++) {
+        const float d = GGML_FP16_TO_FP32(x[i].d);
+
+        uint32_t qh;
+        memcpy(&qh, x[i].qh, sizeof(qh));
+
+        for (int j = 0; j < qk/2; ++j) {
+            const uint8_t xh_0 = ((qh >> (j +  0)) << 4) & 0x10;
+            const uint8_t xh_1 = ((qh >> (j + 12))     ) & 0x10;
+
+            const int32_t x0 = ((x[i].qs[j] & 0x0F) | xh_0) - 16;
+            const int32_t x1 = ((x[i].qs[j] >>   4) | xh_1) - 16;
+
+            y[i*qk + j + 0   ] = x0*d;
+            y[i*qk + j + qk/2] = x1*d;
+        }
+    }
+}
+
+void dequantize_row_q5_1(const void * restrict vx, float * restrict y, int k) {
+    static const int qk = QK5_1;
+
+    assert(k % qk == 0);
+
+    const block_q5_1 * restrict x = vx;
+    const int nb = k / qk;
+
+    for (int i = 0; i < nb; i++) {
+        const float d = GGML_FP16_TO_FP32(x[i].d);
+        const float m = GGML_FP16_TO_FP32(x[i].m);
+
+        uint32_t qh;
+        memcpy(&qh, x[i].qh, sizeof(qh));
+
+        for (int j = 0; j < qk/2; ++j) {
+            const uint8_t xh_0 = ((qh >> (j +  0)) << 4) & 0x10;
+            const uint8_t xh_1 = ((qh >> (j + 12))     ) & 0x10;
+
+            const int x0 = (x[i].qs[j] & 0x0F) | xh_0;
+            const int x1 = (x[i].qs[j] >>   4) | xh_1;
+
+            y[i*qk + j + 0   ] = x0*d + m;
+            y[i*qk + j + qk/2] = x1*d + m;
+        }
+    }
+}
+
+void dequantize_row_q8_0(const void * restrict vx, float * restrict y, int k) {
+    static const int qk = QK8_0;
+
+    assert(k % qk == 0);
+
+    const block_q8_0 * restrict x = vx;
+    const int nb = k / qk;
+
+    for (int i = 0; i < nb; i++) {
+        const float d = GGML_FP16_TO_FP32(x[i].d);
+
+        for (int j = 0; j < qk; ++j) {
+            y[i*qk + j] = x[i].qs[j]*d;
+        }
+    }
+}
+
+void dequantize_row_q8_1(const void * restrict vx, float * restrict y, int k) {
+    static const int qk = QK8_1;
+
+    assert(k % qk == 0);
+
+    const block_q8_1 * restrict x = vx;
+    const int nb = k / qk;
+
+    for (int i = 0; i < nb; i++) {
+        const float d = x[i].d;
+
+        for (int j = 0; j < qk; ++j) {
+            y[i*qk + j] = x[i].qs[j]*d;
+        }
+    }
 }
 
 // K-quantization stubs
@@ -115,19 +445,699 @@ void quantize_row_q8_K_reference(const float * restrict x, void * restrict y, in
 void quantize_row_q8_K(const float * restrict x, void * restrict y, int k) { (void)x; (void)y; (void)k; }
 void dequantize_row_q8_K(const void * restrict x, float * restrict y, int k) { (void)x; (void)y; (void)k; }
 
-// Vector dot product stubs
-void ggml_vec_dot_q4_0_q8_0(int n, float * restrict s, const void * restrict vx, const void * restrict vy) { (void)n; (void)s; (void)vx; (void)vy; }
-void ggml_vec_dot_q4_1_q8_1(int n, float * restrict s, const void * restrict vx, const void * restrict vy) { (void)n; (void)s; (void)vx; (void)vy; }
-void ggml_vec_dot_q5_0_q8_0(int n, float * restrict s, const void * restrict vx, const void * restrict vy) { (void)n; (void)s; (void)vx; (void)vy; }
-void ggml_vec_dot_q5_1_q8_1(int n, float * restrict s, const void * restrict vx, const void * restrict vy) { (void)n; (void)s; (void)vx; (void)vy; }
-void ggml_vec_dot_q8_0_q8_0(int n, float * restrict s, const void * restrict vx, const void * restrict vy) { (void)n; (void)s; (void)vx; (void)vy; }
-
-// Utility function stubs
-size_t ggml_quantize_q4_0(const float * src, void * dst, int n, int k, int64_t * hist) { (void)src; (void)dst; (void)n; (void)k; (void)hist; return 0; }
-size_t ggml_quantize_q4_1(const float * src, void * dst, int n, int k, int64_t * hist) { (void)src; (void)dst; (void)n; (void)k; (void)hist; return 0; }
-size_t ggml_quantize_q5_0(const float * src, void * dst, int n, int k, int64_t * hist) { (void)src; (void)dst; (void)n; (void)k; (void)hist; return 0; }
-size_t ggml_quantize_q5_1(const float * src, void * dst, int n, int k, int64_t * hist) { (void)src; (void)dst; (void)n; (void)k; (void)hist; return 0; }
-size_t ggml_quantize_q8_0(const float * src, void * dst, int n, int k, int64_t * hist) { (void)src; (void)dst; (void)n; (void)k; (void)hist; return 0; }
+//
+// Fused dot products: a quantized row of x against a Q8 row of y
+//
+
+#if defined(GGML_QUANTS_X86)
+
+// horizontally add 8 floats
+GGML_TARGET_AVX2
+static inline float hsum_float_8(const __m256 x) {
+    __m128 res = _mm256_extractf128_ps(x, 1);
+    res = _mm_add_ps(res, _mm256_castps256_ps128(x));
+    res = _mm_add_ps(res, _mm_movehl_ps(res, res));
+    res = _mm_add_ss(res, _mm_movehdup_ps(res));
+    return _mm_cvtss_f32(res);
+}
+
+// unpack 32 4-bit fields into 32 bytes: low nibbles first, then high nibbles
+GGML_TARGET_AVX2
+static inline __m256i bytes_from_nibbles_32(const uint8_t * rsi) {
+    const __m128i tmp = _mm_loadu_si128((const __m128i *) rsi);
+    const __m256i bytes = _mm256_insertf128_si256(_mm256_castsi128_si256(tmp), _mm_srli_epi16(tmp, 4), 1);
+    const __m256i lowMask = _mm256_set1_epi8(0xF);
+    return _mm256_and_si256(lowMask, bytes);
+}
+
+// spread 32 bits to 32 bytes { 0x00, 0xFF }
+GGML_TARGET_AVX2
+static inline __m256i bytes_from_bits_32(const uint8_t * x) {
+    uint32_t x32;
+    memcpy(&x32, x, sizeof(uint32_t));
+    const __m256i shuf_mask = _mm256_set_epi64x(
+            0x0303030303030303, 0x0202020202020202,
+            0x0101010101010101, 0x0000000000000000);
+    __m256i bytes = _mm256_shuffle_epi8(_mm256_set1_epi32((int) x32), shuf_mask);
+    const __m256i bit_mask = _mm256_set1_epi64x(0x7fbfdfeff7fbfdfe);
+    bytes = _mm256_or_si256(bytes, bit_mask);
+    return _mm256_cmpeq_epi8(bytes, _mm256_set1_epi64x(-1));
+}
+
+// add int16_t pairwise and return as float vector
+GGML_TARGET_AVX2
+static inline __m256 sum_i16_pairs_float(const __m256i x) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i summed_pairs = _mm256_madd_epi16(ones, x);
+    return _mm256_cvtepi32_ps(summed_pairs);
+}
+
+// multiply unsigned by signed int8_t, add results pairwise twice
+GGML_TARGET_AVX2
+static inline __m256 mul_sum_us8_pairs_float(const __m256i ax, const __m256i sy) {
+    const __m256i dot = _mm256_maddubs_epi16(ax, sy);
+    return sum_i16_pairs_float(dot);
+}
+
+// multiply int8_t, add results pairwise twice and return as float vector
+GGML_TARGET_AVX2
+static inline __m256 mul_sum_i8_pairs_float(const __m256i x, const __m256i y) {
+    // get absolute values of x vectors
+    const __m256i ax = _mm256_sign_epi8(x, x);
+    // sign the values of the y vectors
+    const __m256i sy = _mm256_sign_epi8(y, x);
+    return mul_sum_us8_pairs_float(ax, sy);
+}
+
+GGML_TARGET_AVX2
+static void ggml_vec_dot_q4_0_q8_0_avx2(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const block_q4_0 * restrict x = vx;
+    const block_q8_0 * restrict y = vy;
+    const int nb = n / QK8_0;
+
+    __m256 acc = _mm256_setzero_ps();
+
+    for (int i = 0; i < nb; ++i) {
+        const __m256 d = _mm256_set1_ps(GGML_FP16_TO_FP32(x[i].d) * GGML_FP16_TO_FP32(y[i].d));
+
+        // [0, 15] -> [-8, 7]
+        __m256i qx = bytes_from_nibbles_32(x[i].qs);
+        qx = _mm256_sub_epi8(qx, _mm256_set1_epi8(8));
+
+        const __m256i qy = _mm256_loadu_si256((const __m256i *) y[i].qs);
+        const __m256 q = mul_sum_i8_pairs_float(qx, qy);
+
+        acc = _mm256_fmadd_ps(d, q, acc);
+    }
+
+    *s = hsum_float_8(acc);
+}
+
+GGML_TARGET_AVX2
+static void ggml_vec_dot_q4_1_q8_1_avx2(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const block_q4_1 * restrict x = vx;
+    const block_q8_1 * restrict y = vy;
+    const int nb = n / QK8_1;
+
+    __m256 acc = _mm256_setzero_ps();
+    float summs = 0.0f;
+
+    for (int i = 0; i < nb; ++i) {
+        summs += GGML_FP16_TO_FP32(x[i].m) * y[i].s;
+
+        const __m256 d0d1 = _mm256_set1_ps(GGML_FP16_TO_FP32(x[i].d) * y[i].d);
+
+        const __m256i qx = bytes_from_nibbles_32(x[i].qs);
+        const __m256i qy = _mm256_loadu_si256((const __m256i *) y[i].qs);
+
+        const __m256 xy = mul_sum_us8_pairs_float(qx, qy);
+
+        acc = _mm256_fmadd_ps(d0d1, xy, acc);
+    }
+
+    *s = hsum_float_8(acc) + summs;
+}
+
+GGML_TARGET_AVX2
+static void ggml_vec_dot_q5_0_q8_0_avx2(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const block_q5_0 * restrict x = vx;
+    const block_q8_0 * restrict y = vy;
+    const int nb = n / QK8_0;
+
+    __m256 acc = _mm256_setzero_ps();
+
+    for (int i = 0; i < nb; ++i) {
+        const __m256 d = _mm256_set1_ps(GGML_FP16_TO_FP32(x[i].d) * GGML_FP16_TO_FP32(y[i].d));
+
+        // a clear 5th bit means the value is below 16: set the high nibble to make it negative
+        __m256i qx = bytes_from_nibbles_32(x[i].qs);
+        __m256i bxhi = bytes_from_bits_32(x[i].qh);
+        bxhi = _mm256_andnot_si256(bxhi, _mm256_set1_epi8((char) 0xF0));
+        qx = _mm256_or_si256(qx, bxhi);
+
+        const __m256i qy = _mm256_loadu_si256((const __m256i *) y[i].qs);
+        const __m256 q = mul_sum_i8_pairs_float(qx, qy);
+
+        acc = _mm256_fmadd_ps(d, q, acc);
+    }
+
+    *s = hsum_float_8(acc);
+}
+
+GGML_TARGET_AVX2
+static void ggml_vec_dot_q5_1_q8_1_avx2(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const block_q5_1 * restrict x = vx;
+    const block_q8_1 * restrict y = vy;
+    const int nb = n / QK8_1;
+
+    __m256 acc = _mm256_setzero_ps();
+    float summs = 0.0f;
+
+    for (int i = 0; i < nb; ++i) {
+        summs += GGML_FP16_TO_FP32(x[i].m) * y[i].s;
+
+        const __m256 d0d1 = _mm256_set1_ps(GGML_FP16_TO_FP32(x[i].d) * y[i].d);
+
+        __m256i qx = bytes_from_nibbles_32(x[i].qs);
+        __m256i bxhi = bytes_from_bits_32(x[i].qh);
+        bxhi = _mm256_and_si256(bxhi, _mm256_set1_epi8(0x10));
+        qx = _mm256_or_si256(qx, bxhi);
+
+        const __m256i qy = _mm256_loadu_si256((const __m256i *) y[i].qs);
+        const __m256 q = mul_sum_us8_pairs_float(qx, qy);
+
+        acc = _mm256_fmadd_ps(q, d0d1, acc);
+    }
+
+    *s = hsum_float_8(acc) + summs;
+}
+
+GGML_TARGET_AVX2
+static void ggml_vec_dot_q8_0_q8_0_avx2(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const block_q8_0 * restrict x = vx;
+    const block_q8_0 * restrict y = vy;
+    const int nb = n / QK8_0;
+
+    __m256 acc = _mm256_setzero_ps();
+
+    for (int i = 0; i < nb; ++i) {
+        const __m256 d = _mm256_set1_ps(GGML_FP16_TO_FP32(x[i].d) * GGML_FP16_TO_FP32(y[i].d));
+
+        const __m256i qx = _mm256_loadu_si256((const __m256i *) x[i].qs);
+        const __m256i qy = _mm256_loadu_si256((const __m256i *) y[i].qs);
+
+        const __m256 q = mul_sum_i8_pairs_float(qx, qy);
+
+        acc = _mm256_fmadd_ps(d, q, acc);
+    }
+
+    *s = hsum_float_8(acc);
+}
+
+static bool ggml_quants_has_avx2(void) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#else
+    static int has_avx2 = -1;
+    if (has_avx2 < 0) {
+        int info[4];
+        __cpuidex(info, 1, 0);
+        const bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+        const bool fma = (info[2] & (1 << 12)) != 0;
+        __cpuidex(info, 7, 0);
+        has_avx2 = os_avx && fma && (info[1] & (1 << 5)) != 0;
+    }
+    return has_avx2 != 0;
+#endif
+}
+
+#elif defined(GGML_QUANTS_NEON)
+
+static inline int32x4_t ggml_vdotq_s32(int32x4_t acc, int8x16_t a, int8x16_t b) {
+#if defined(__ARM_FEATURE_DOTPROD)
+    return vdotq_s32(acc, a, b);
+#else
+    const int16x8_t p0 = vmull_s8(vget_low_s8 (a), vget_low_s8 (b));
+    const int16x8_t p1 = vmull_s8(vget_high_s8(a), vget_high_s8(b));
+    return vaddq_s32(acc, vaddq_s32(vpaddlq_s16(p0), vpaddlq_s16(p1)));
+#endif
+}
+
+// the 5th bits of a Q5 block as two 16-byte vectors of 0x00 / 0x10
+static inline void ggml_q5_high_bits(const uint8_t * qh, uint8x16_t * hl, uint8x16_t * hh) {
+    static const uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    const uint8x16_t mask = vld1q_u8(bits);
+    const uint8x16_t b0 = vcombine_u8(vdup_n_u8(qh[0]), vdup_n_u8(qh[1]));
+    const uint8x16_t b1 = vcombine_u8(vdup_n_u8(qh[2]), vdup_n_u8(qh[3]));
+    *hl = vandq_u8(vtstq_u8(b0, mask), vdupq_n_u8(0x10));
+    *hh = vandq_u8(vtstq_u8(b1, mask), vdupq_n_u8(0x10));
+}
+
+static void ggml_vec_dot_q4_0_q8_0_neon(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const block_q4_0 * restrict x = vx;
+    const block_q8_0 * restrict y = vy;
+    const int nb = n / QK8_0;
+
+    const uint8x16_t m4b = vdupq_n_u8(0x0F);
+    const int8x16_t  s8b = vdupq_n_s8(0x8);
+
+    float32x4_t acc = vdupq_n_f32(0.0f);
+
+    for (int i = 0; i < nb; ++i) {
+        const uint8x16_t v0 = vld1q_u8(x[i].qs);
+
+        const int8x16_t xl = vsubq_s8(vreinterpretq_s8_u8(vandq_u8(v0, m4b)), s8b);
+        const int8x16_t xh = vsubq_s8(vreinterpretq_s8_u8(vshrq_n_u8(v0, 4)), s8b);
+
+        const int32x4_t p = ggml_vdotq_s32(ggml_vdotq_s32(vdupq_n_s32(0), xl, vld1q_s8(y[i].qs)), xh, vld1q_s8(y[i].qs + 16));
+
+        acc = vmlaq_n_f32(acc, vcvtq_f32_s32(p), GGML_FP16_TO_FP32(x[i].d)*GGML_FP16_TO_FP32(y[i].d));
+    }
+
+    *s = vaddvq_f32(acc);
+}
+
+static void ggml_vec_dot_q4_1_q8_1_neon(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const block_q4_1 * restrict x = vx;
+    const block_q8_1 * restrict y = vy;
+    const int nb = n / QK8_1;
+
+    const uint8x16_t m4b = vdupq_n_u8(0x0F);
+
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    float summs = 0.0f;
+
+    for (int i = 0; i < nb; ++i) {
+        summs += GGML_FP16_TO_FP32(x[i].m) * y[i].s;
+
+        const uint8x16_t v0 = vld1q_u8(x[i].qs);
+
+        const int8x16_t xl = vreinterpretq_s8_u8(vandq_u8(v0, m4b));
+        const int8x16_t xh = vreinterpretq_s8_u8(vshrq_n_u8(v0, 4));
+
+        const int32x4_t p = ggml_vdotq_s32(ggml_vdotq_s32(vdupq_n_s32(0), xl, vld1q_s8(y[i].qs)), xh, vld1q_s8(y[i].qs + 16));
+
+        acc = vmlaq_n_f32(acc, vcvtq_f32_s32(p), GGML_FP16_TO_FP32(x[i].d)*y[i].d);
+    }
+
+    *s = vaddvq_f32(acc) + summs;
+}
+
+static void ggml_vec_dot_q5_0_q8_0_neon(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const block_q5_0 * restrict x = vx;
+    const block_q8_0 * restrict y = vy;
+    const int nb = n / QK8_0;
+
+    const uint8x16_t m4b = vdupq_n_u8(0x0F);
+    const int8x16_t  s16b = vdupq_n_s8(0x10);
+
+    float32x4_t acc = vdupq_n_f32(0.0f);
+
+    for (int i = 0; i < nb; ++i) {
+        uint8x16_t hl, hh;
+        ggml_q5_high_bits(x[i].qh, &hl, &hh);
+
+        const uint8x16_t v0 = vld1q_u8(x[i].qs);
+
+        const int8x16_t xl = vsubq_s8(vreinterpretq_s8_u8(vorrq_u8(vandq_u8(v0, m4b), hl)), s16b);
+        const int8x16_t xh = vsubq_s8(vreinterpretq_s8_u8(vorrq_u8(vshrq_n_u8(v0, 4), hh)), s16b);
+
+        const int32x4_t p = ggml_vdotq_s32(ggml_vdotq_s32(vdupq_n_s32(0), xl, vld1q_s8(y[i].qs)), xh, vld1q_s8(y[i].qs + 16));
+
+        acc = vmlaq_n_f32(acc, vcvtq_f32_s32(p), GGML_FP16_TO_FP32(x[i].d)*GGML_FP16_TO_FP32(y[i].d));
+    }
+
+    *s = vaddvq_f32(acc);
+}
+
+static void ggml_vec_dot_q5_1_q8_1_neon(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const block_q5_1 * restrict x = vx;
+    const block_q8_1 * restrict y = vy;
+    const int nb = n / QK8_1;
+
+    const uint8x16_t m4b = vdupq_n_u8(0x0F);
+
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    float summs = 0.0f;
+
+    for (int i = 0; i < nb; ++i) {
+        summs += GGML_FP16_TO_FP32(x[i].m) * y[i].s;
+
+        uint8x16_t hl, hh;
+        ggml_q5_high_bits(x[i].qh, &hl, &hh);
+
+        const uint8x16_t v0 = vld1q_u8(x[i].qs);
+
+        const int8x16_t xl = vreinterpretq_s8_u8(vorrq_u8(vandq_u8(v0, m4b), hl));
+        const int8x16_t xh = vreinterpretq_s8_u8(vorrq_u8(vshrq_n_u8(v0, 4), hh));
+
+        const int32x4_t p = ggml_vdotq_s32(ggml_vdotq_s32(vdupq_n_s32(0), xl, vld1q_s8(y[i].qs)), xh, vld1q_s8(y[i].qs + 16));
+
+        acc = vmlaq_n_f32(acc, vcvtq_f32_s32(p), GGML_FP16_TO_FP32(x[i].d)*y[i].d);
+    }
+
+    *s = vaddvq_f32(acc) + summs;
+}
+
+static void ggml_vec_dot_q8_0_q8_0_neon(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const block_q8_0 * restrict x = vx;
+    const block_q8_0 * restrict y = vy;
+    const int nb = n / QK8_0;
+
+    float32x4_t acc = vdupq_n_f32(0.0f);
+
+    for (int i = 0; i < nb; ++i) {
+        const int32x4_t p = ggml_vdotq_s32(ggml_vdotq_s32(vdupq_n_s32(0),
+                vld1q_s8(x[i].qs),      vld1q_s8(y[i].qs)),
+                vld1q_s8(x[i].qs + 16), vld1q_s8(y[i].qs + 16));
+
+        acc = vmlaq_n_f32(acc, vcvtq_f32_s32(p), GGML_FP16_TO_FP32(x[i].d)*GGML_FP16_TO_FP32(y[i].d));
+    }
+
+    *s = vaddvq_f32(acc);
+}
+
+#endif
+
+void ggml_vec_dot_q4_0_q8_0(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+
+    assert(n % qk == 0);
+
+#if defined(GGML_QUANTS_X86)
+    if (ggml_quants_has_avx2()) {
+        ggml_vec_dot_q4_0_q8_0_avx2(n, s, vx, vy);
+        return;
+    }
+#elif defined(GGML_QUANTS_NEON)
+    ggml_vec_dot_q4_0_q8_0_neon(n, s, vx, vy);
+    return;
+#endif
+
+    const block_q4_0 * restrict x = vx;
+    const block_q8_0 * restrict y = vy;
+
+    float sumf = 0.0f;
+
+    for (int i = 0; i < nb; i++) {
+        int sumi = 0;
+
+        for (int j = 0; j < qk/2; ++j) {
+            const int v0 = (x[i].qs[j] & 0x0F) - 8;
+            const int v1 = (x[i].qs[j] >>   4) - 8;
+
+            sumi += (v0 * y[i].qs[j]) + (v1 * y[i].qs[j + qk/2]);
+        }
+
+        sumf += sumi*GGML_FP16_TO_FP32(x[i].d)*GGML_FP16_TO_FP32(y[i].d);
+    }
+
+    *s = sumf;
+}
+
+void ggml_vec_dot_q4_1_q8_1(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const int qk = QK8_1;
+    const int nb = n / qk;
+
+    assert(n % qk == 0);
+
+#if defined(GGML_QUANTS_X86)
+    if (ggml_quants_has_avx2()) {
+        ggml_vec_dot_q4_1_q8_1_avx2(n, s, vx, vy);
+        return;
+    }
+#elif defined(GGML_QUANTS_NEON)
+    ggml_vec_dot_q4_1_q8_1_neon(n, s, vx, vy);
+    return;
+#endif
+
+    const block_q4_1 * restrict x = vx;
+    const block_q8_1 * restrict y = vy;
+
+    float sumf = 0.0f;
+
+    for (int i = 0; i < nb; i++) {
+        int sumi = 0;
+
+        for (int j = 0; j < qk/2; ++j) {
+            const int v0 = (x[i].qs[j] & 0x0F);
+            const int v1 = (x[i].qs[j] >>   4);
+
+            sumi += (v0 * y[i].qs[j]) + (v1 * y[i].qs[j + qk/2]);
+        }
+
+        sumf += (GGML_FP16_TO_FP32(x[i].d)*y[i].d)*sumi + GGML_FP16_TO_FP32(x[i].m)*y[i].s;
+    }
+
+    *s = sumf;
+}
+
+void ggml_vec_dot_q5_0_q8_0(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+
+    assert(n % qk == 0);
+
+#if defined(GGML_QUANTS_X86)
+    if (ggml_quants_has_avx2()) {
+        ggml_vec_dot_q5_0_q8_0_avx2(n, s, vx, vy);
+        return;
+    }
+#elif defined(GGML_QUANTS_NEON)
+    ggml_vec_dot_q5_0_q8_0_neon(n, s, vx, vy);
+    return;
+#endif
+
+    const block_q5_0 * restrict x = vx;
+    const block_q8_0 * restrict y = vy;
+
+    float sumf = 0.0f;
+
+    for (int i = 0; i < nb; i++) {
+        uint32_t qh;
+        memcpy(&qh, x[i].qh, sizeof(qh));
+
+        int sumi = 0;
+
+        for (int j = 0; j < qk/2; ++j) {
+            const uint8_t xh_0 = ((qh & (1u << (j + 0 ))) >> (j + 0 )) << 4;
+            const uint8_t xh_1 = ((qh & (1u << (j + 16))) >> (j + 12));
+
+            const int32_t x0 = ((x[i].qs[j] & 0x0F) | xh_0) - 16;
+            const int32_t x1 = ((x[i].qs[j] >>   4) | xh_1) - 16;
+
+            sumi += (x0 * y[i].qs[j]) + (x1 * y[i].qs[j + qk/2]);
+        }
+
+        sumf += (GGML_FP16_TO_FP32(x[i].d)*GGML_FP16_TO_FP32(y[i].d)) * sumi;
+    }
+
+    *s = sumf;
+}
+
+void ggml_vec_dot_q5_1_q8_1(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const int qk = QK8_1;
+    const int nb = n / qk;
+
+    assert(n % qk == 0);
+
+#if defined(GGML_QUANTS_X86)
+    if (ggml_quants_has_avx2()) {
+        ggml_vec_dot_q5_1_q8_1_avx2(n, s, vx, vy);
+        return;
+    }
+#elif defined(GGML_QUANTS_NEON)
+    ggml_vec_dot_q5_1_q8_1_neon(n, s, vx, vy);
+    return;
+#endif
+
+    const block_q5_1 * restrict x = vx;
+    const block_q8_1 * restrict y = vy;
+
+    float sumf = 0.0f;
+
+    for (int i = 0; i < nb; i++) {
+        uint32_t qh;
+        memcpy(&qh, x[i].qh, sizeof(qh));
+
+        int sumi = 0;
+
+        for (int j = 0; j < qk/2; ++j) {
+            const uint8_t xh_0 = ((qh >> (j +  0)) << 4) & 0x10;
+            const uint8_t xh_1 = ((qh >> (j + 12))     ) & 0x10;
+
+            const int32_t x0 = (x[i].qs[j] & 0xF) | xh_0;
+            const int32_t x1 = (x[i].qs[j] >>  4) | xh_1;
+
+            sumi += (x0 * y[i].qs[j]) + (x1 * y[i].qs[j + qk/2]);
+        }
+
+        sumf += (GGML_FP16_TO_FP32(x[i].d)*y[i].d)*sumi + GGML_FP16_TO_FP32(x[i].m)*y[i].s;
+    }
+
+    *s = sumf;
+}
+
+void ggml_vec_dot_q8_0_q8_0(int n, float * restrict s, const void * restrict vx, const void * restrict vy) {
+    const int qk = QK8_0;
+    const int nb = n / qk;
+
+    assert(n % qk == 0);
+
+#if defined(GGML_QUANTS_X86)
+    if (ggml_quants_has_avx2()) {
+        ggml_vec_dot_q8_0_q8_0_avx2(n, s, vx, vy);
+        return;
+    }
+#elif defined(GGML_QUANTS_NEON)
+    ggml_vec_dot_q8_0_q8_0_neon(n, s, vx, vy);
+    return;
+#endif
+
+    const block_q8_0 * restrict x = vx;
+    const block_q8_0 * restrict y = vy;
+
+    float sumf = 0.0f;
+
+    for (int i = 0; i < nb; i++) {
+        int sumi = 0;
+
+        for (int j = 0; j < qk; j++) {
+            sumi += x[i].qs[j]*y[i].qs[j];
+        }
+
+        sumf += sumi*(GGML_FP16_TO_FP32(x[i].d)*GGML_FP16_TO_FP32(y[i].d));
+    }
+
+    *s = sumf;
+}
+
+//
+// Whole-tensor quantization with a 16-bucket histogram of the quantized values
+//
+
+size_t ggml_quantize_q4_0(const float * src, void * dst, int n, int k, int64_t * hist) {
+    assert(k % QK4_0 == 0);
+    const int nb = k / QK4_0;
+
+    for (int b = 0; b < n; b += k) {
+        block_q4_0 * restrict y = (block_q4_0 *) dst + b/QK4_0;
+
+        quantize_row_q4_0_reference(src + b, y, k);
+
+        if (!hist) {
+            continue;
+        }
+        for (int i = 0; i < nb; i++) {
+            for (int j = 0; j < QK4_0; j += 2) {
+                const uint8_t vi0 = y[i].qs[j/2] & 0x0F;
+                const uint8_t vi1 = y[i].qs[j/2] >> 4;
+
+                hist[vi0]++;
+                hist[vi1]++;
+            }
+        }
+    }
+
+    return (n/QK4_0*sizeof(block_q4_0));
+}
+
+size_t ggml_quantize_q4_1(const float * src, void * dst, int n, int k, int64_t * hist) {
+    assert(k % QK4_1 == 0);
+    const int nb = k / QK4_1;
+
+    for (int b = 0; b < n; b += k) {
+        block_q4_1 * restrict y = (block_q4_1 *) dst + b/QK4_1;
+
+        quantize_row_q4_1_reference(src + b, y, k);
+
+        if (!hist) {
+            continue;
+        }
+        for (int i = 0; i < nb; i++) {
+            for (int j = 0; j < QK4_1; j += 2) {
+                const uint8_t vi0 = y[i].qs[j/2] & 0x0F;
+                const uint8_t vi1 = y[i].qs[j/2] >> 4;
+
+                hist[vi0]++;
+                hist[vi1]++;
+            }
+        }
+    }
+
+    return (n/QK4_1*sizeof(block_q4_1));
+}
+
+size_t ggml_quantize_q5_0(const float * src, void * dst, int n, int k, int64_t * hist) {
+    assert(k % QK5_0 == 0);
+    const int nb = k / QK5_0;
+
+    for (int b = 0; b < n; b += k) {
+        block_q5_0 * restrict y = (block_q5_0 *) dst + b/QK5_0;
+
+        quantize_row_q5_0_reference(src + b, y, k);
+
+        if (!hist) {
+            continue;
+        }
+        for (int i = 0; i < nb; i++) {
+            uint32_t qh;
+            memcpy(&qh, &y[i].qh, sizeof(qh));
+
+            for (int j = 0; j < QK5_0; j += 2) {
+                const uint8_t vh0 = ((qh & (1u << (j/2 + 0 ))) >> (j/2 + 0 )) << 4;
+                const uint8_t vh1 = ((qh & (1u << (j/2 + 16))) >> (j/2 + 12));
+
+                // cast to 16 bins
+                const uint8_t vi0 = ((y[i].qs[j/2] & 0x0F) | vh0) / 2;
+                const uint8_t vi1 = ((y[i].qs[j/2] >>   4) | vh1) / 2;
+
+                hist[vi0]++;
+                hist[vi1]++;
+            }
+        }
+    }
+
+    return (n/QK5_0*sizeof(block_q5_0));
+}
+
+size_t ggml_quantize_q5_1(const float * src, void * dst, int n, int k, int64_t * hist) {
+    assert(k % QK5_1 == 0);
+    const int nb = k / QK5_1;
+
+    for (int b = 0; b < n; b += k) {
+        block_q5_1 * restrict y = (block_q5_1 *) dst + b/QK5_1;
+
+        quantize_row_q5_1_reference(src + b, y, k);
+
+        if (!hist) {
+            continue;
+        }
+        for (int i = 0; i < nb; i++) {
+            uint32_t qh;
+            memcpy(&qh, &y[i].qh, sizeof(qh));
+
+            for (int j = 0; j < QK5_1; j += 2) {
+                const uint8_t vh0 = ((qh & (1u << (j/2 + 0 ))) >> (j/2 + 0 )) << 4;
+                const uint8_t vh1 = ((qh & (1u << (j/2 + 16))) >> (j/2 + 12));
+
+                // cast to 16 bins
+                const uint8_t vi0 = ((y[i].qs[j/2] & 0x0F) | vh0) / 2;
+                const uint8_t vi1 = ((y[i].qs[j/2] >>   4) | vh1) / 2;
+
+                hist[vi0]++;
+                hist[vi1]++;
+            }
+        }
+    }
+
+    return (n/QK5_1*sizeof(block_q5_1));
+}
+
+size_t ggml_quantize_q8_0(const float * src, void * dst, int n, int k, int64_t * hist) {
+    assert(k % QK8_0 == 0);
+    const int nb = k / QK8_0;
+
+    for (int b = 0; b < n; b += k) {
+        block_q8_0 * restrict y = (block_q8_0 *) dst + b/QK8_0;
+
+        quantize_row_q8_0_reference(src + b, y, k);
+
+        if (!hist) {
+            continue;
+        }
+        for (int i = 0; i < nb; i++) {
+            for (int j = 0; j < QK8_0; ++j) {
+                const int8_t vi = y[i].qs[j];
+
+                hist[vi/16 + 8]++;
+            }
+        }
+    }
+
+    return (n/QK8_0*sizeof(block_q8_0));
+}
 
 size_t ggml_quantize_q2_K(const float * src, void * dst, int n, int k, int64_t * hist) { (void)src; (void)dst; (void)n; (void)k; (void)hist; return 0; }
 size_t ggml_quantize_q3_K(const float * src, void * dst, int n, int k, int64_t * hist) { (void)src; (void)dst; (void)n; (void)k; (void)hist; return 0; }
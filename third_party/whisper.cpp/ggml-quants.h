@@ -1,12 +1,55 @@
 #ifndef GGML_QUANTS_H
 #define GGML_QUANTS_H
 
-#include "ggml.h"
+#include "ggml-impl.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// Quantization block structures, laid out as in the ggml model files
+
+#define QK4_0 32
+typedef struct {
+    ggml_fp16_t d;          // delta
+    uint8_t qs[QK4_0 / 2];  // nibbles / quants
+} block_q4_0;
+
+#define QK4_1 32
+typedef struct {
+    ggml_fp16_t d;          // delta
+    ggml_fp16_t m;          // min
+    uint8_t qs[QK4_1 / 2];  // nibbles / quants
+} block_q4_1;
+
+#define QK5_0 32
+typedef struct {
+    ggml_fp16_t d;          // delta
+    uint8_t qh[4];          // 5-th bit of quants
+    uint8_t qs[QK5_0 / 2];  // nibbles / quants
+} block_q5_0;
+
+#define QK5_1 32
+typedef struct {
+    ggml_fp16_t d;          // delta
+    ggml_fp16_t m;          // min
+    uint8_t qh[4];          // 5-th bit of quants
+    uint8_t qs[QK5_1 / 2];  // nibbles / quants
+} block_q5_1;
+
+#define QK8_0 32
+typedef struct {
+    ggml_fp16_t d;          // delta
+    int8_t  qs[QK8_0];      // quants
+} block_q8_0;
+
+#define QK8_1 32
+typedef struct {
+    float d;                // delta
+    float s;                // d * sum(qs[i])
+    int8_t  qs[QK8_1];      // quants
+} block_q8_1;
+
 // Quantization functions
 
 // Q4_0 quantization (4-bit with FP16 scale)
@@ -29,7 +72,7 @@ void quantize_row_q5_1_reference(const float * restrict x, void * restrict y, in
 void quantize_row_q5_1(const float * restrict x, void * restrict y, int k);
 void dequantize_row_q5_1(const void * restrict x, float * restrict y, int k);
 
-// Q8_0 quantization (8-bit with FP32 scale)
+// Q8_0 quantization (8-bit with FP16 scale)
 void quantize_row_q8_0_reference(const float * restrict x, void * restrict y, int k);
 void quantize_row_q8_0(const float * restrict x, void * restrict y, int k);
 void dequantize_row_q8_0(const void * restrict x, float * restrict y, int k);
@@ -39,7 +82,8 @@ void quantize_row_q8_1_reference(const float * restrict x, void * restrict y, in
 void quantize_row_q8_1(const float * restrict x, void * restrict y, int k);
 void dequantize_row_q8_1(const void * restrict x, float * restrict y, int k);
 
-// K-quantization methods
+// K-quantization methods (not implemented: the functions are no-ops and the
+// types report no kernels through ggml_internal_get_type_traits())
 void quantize_row_q2_K_reference(const float * restrict x, void * restrict y, int k);
 void quantize_row_q2_K(const float * restrict x, void * restrict y, int k);
 void dequantize_row_q2_K(const void * restrict x, float * restrict y, int k);
@@ -1,15 +1,38 @@
 #include "ggml.h"
 #include "ggml-impl.h"
+#include "ggml-quants.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <math.h>
 #include <assert.h>
 
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GGML_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// GCC/Clang build the AVX2 paths per function and pick them at runtime;
+// MSVC accepts the intrinsics without a target flag
+#if defined(GGML_X86) && (defined(__GNUC__) || defined(__clang__))
+#define GGML_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define GGML_TARGET_F16C __attribute__((target("f16c")))
+#else
+#define GGML_TARGET_AVX2
+#define GGML_TARGET_F16C
+#endif
+
 // Context structure
 struct ggml_context {
     size_t mem_size;
     void * mem_buffer;
+    bool   mem_buffer_owned;
     bool   no_alloc;
     size_t mem_used;
     
@@ -18,32 +41,111 @@ struct ggml_context {
 };
 
 // Type information
-static const size_t type_sizes[GGML_TYPE_COUNT] = {
-    [GGML_TYPE_F32]  = sizeof(float),
-    [GGML_TYPE_F16]  = sizeof(uint16_t),
-    [GGML_TYPE_Q4_0] = sizeof(uint32_t) + 16*sizeof(uint8_t),
-    [GGML_TYPE_Q4_1] = sizeof(float) + sizeof(uint32_t) + 16*sizeof(uint8_t),
-    [GGML_TYPE_Q5_0] = sizeof(uint32_t) + sizeof(uint32_t) + 16*sizeof(uint8_t),
-    [GGML_TYPE_Q5_1] = sizeof(float) + sizeof(uint32_t) + sizeof(uint32_t) + 16*sizeof(uint8_t),
-    [GGML_TYPE_Q8_0] = sizeof(float) + 32*sizeof(uint8_t),
-    [GGML_TYPE_Q8_1] = sizeof(float) + sizeof(float) + 32*sizeof(uint8_t),
-    [GGML_TYPE_I8]   = sizeof(int8_t),
-    [GGML_TYPE_I16]  = sizeof(int16_t),
-    [GGML_TYPE_I32]  = sizeof(int32_t),
-};
-
-static const char * type_names[GGML_TYPE_COUNT] = {
-    [GGML_TYPE_F32]  = "f32",
-    [GGML_TYPE_F16]  = "f16",
-    [GGML_TYPE_Q4_0] = "q4_0",
-    [GGML_TYPE_Q4_1] = "q4_1",
-    [GGML_TYPE_Q5_0] = "q5_0",
-    [GGML_TYPE_Q5_1] = "q5_1",
-    [GGML_TYPE_Q8_0] = "q8_0",
-    [GGML_TYPE_Q8_1] = "q8_1",
-    [GGML_TYPE_I8]   = "i8",
-    [GGML_TYPE_I16]  = "i16",
-    [GGML_TYPE_I32]  = "i32",
+static const ggml_type_traits_t type_traits[GGML_TYPE_COUNT] = {
+    [GGML_TYPE_F32] = {
+        .type_name                = "f32",
+        .blck_size                = 1,
+        .type_size                = sizeof(float),
+        .is_quantized             = false,
+        .vec_dot_type             = GGML_TYPE_F32,
+    },
+    [GGML_TYPE_F16] = {
+        .type_name                = "f16",
+        .blck_size                = 1,
+        .type_size                = sizeof(ggml_fp16_t),
+        .is_quantized             = false,
+        .to_float                 = (ggml_to_float_t) ggml_fp16_to_fp32_row,
+        .from_float               = (ggml_from_float_t) ggml_fp32_to_fp16_row,
+        .from_float_reference     = (ggml_from_float_t) ggml_fp32_to_fp16_row,
+        .vec_dot_type             = GGML_TYPE_F16,
+    },
+    [GGML_TYPE_Q4_0] = {
+        .type_name                = "q4_0",
+        .blck_size                = QK4_0,
+        .type_size                = sizeof(block_q4_0),
+        .is_quantized             = true,
+        .to_float                 = dequantize_row_q4_0,
+        .from_float               = quantize_row_q4_0,
+        .from_float_reference     = quantize_row_q4_0_reference,
+        .vec_dot                  = ggml_vec_dot_q4_0_q8_0,
+        .vec_dot_type             = GGML_TYPE_Q8_0,
+    },
+    [GGML_TYPE_Q4_1] = {
+        .type_name                = "q4_1",
+        .blck_size                = QK4_1,
+        .type_size                = sizeof(block_q4_1),
+        .is_quantized             = true,
+        .to_float                 = dequantize_row_q4_1,
+        .from_float               = quantize_row_q4_1,
+        .from_float_reference     = quantize_row_q4_1_reference,
+        .vec_dot                  = ggml_vec_dot_q4_1_q8_1,
+        .vec_dot_type             = GGML_TYPE_Q8_1,
+    },
+    [GGML_TYPE_Q5_0] = {
+        .type_name                = "q5_0",
+        .blck_size                = QK5_0,
+        .type_size                = sizeof(block_q5_0),
+        .is_quantized             = true,
+        .to_float                 = dequantize_row_q5_0,
+        .from_float               = quantize_row_q5_0,
+        .from_float_reference     = quantize_row_q5_0_reference,
+        .vec_dot                  = ggml_vec_dot_q5_0_q8_0,
+        .vec_dot_type             = GGML_TYPE_Q8_0,
+    },
+    [GGML_TYPE_Q5_1] = {
+        .type_name                = "q5_1",
+        .blck_size                = QK5_1,
+        .type_size                = sizeof(block_q5_1),
+        .is_quantized             = true,
+        .to_float                 = dequantize_row_q5_1,
+        .from_float               = quantize_row_q5_1,
+        .from_float_reference     = quantize_row_q5_1_reference,
+        .vec_dot                  = ggml_vec_dot_q5_1_q8_1,
+        .vec_dot_type             = GGML_TYPE_Q8_1,
+    },
+    [GGML_TYPE_Q8_0] = {
+        .type_name                = "q8_0",
+        .blck_size                = QK8_0,
+        .type_size                = sizeof(block_q8_0),
+        .is_quantized             = true,
+        .to_float                 = dequantize_row_q8_0,
+        .from_float               = quantize_row_q8_0,
+        .from_float_reference     = quantize_row_q8_0_reference,
+        .vec_dot                  = ggml_vec_dot_q8_0_q8_0,
+        .vec_dot_type             = GGML_TYPE_Q8_0,
+    },
+    [GGML_TYPE_Q8_1] = {
+        .type_name                = "q8_1",
+        .blck_size                = QK8_1,
+        .type_size                = sizeof(block_q8_1),
+        .is_quantized             = true,
+        .to_float                 = dequantize_row_q8_1,
+        .from_float               = quantize_row_q8_1,
+        .from_float_reference     = quantize_row_q8_1_reference,
+        .vec_dot_type             = GGML_TYPE_Q8_1,
+    },
+    // K-quants: sizes only so that model files can be sized, no kernels yet
+    [GGML_TYPE_Q2_K] = { .type_name = "q2_K", .blck_size = 256, .type_size = 84,  .is_quantized = true },
+    [GGML_TYPE_Q3_K] = { .type_name = "q3_K", .blck_size = 256, .type_size = 110, .is_quantized = true },
+    [GGML_TYPE_Q4_K] = { .type_name = "q4_K", .blck_size = 256, .type_size = 144, .is_quantized = true },
+    [GGML_TYPE_Q5_K] = { .type_name = "q5_K", .blck_size = 256, .type_size = 176, .is_quantized = true },
+    [GGML_TYPE_Q6_K] = { .type_name = "q6_K", .blck_size = 256, .type_size = 210, .is_quantized = true },
+    [GGML_TYPE_Q8_K] = { .type_name = "q8_K", .blck_size = 256, .type_size = 292, .is_quantized = true },
+    [GGML_TYPE_I8] = {
+        .type_name                = "i8",
+        .blck_size                = 1,
+        .type_size                = sizeof(int8_t),
+    },
+    [GGML_TYPE_I16] = {
+        .type_name                = "i16",
+        .blck_size                = 1,
+        .type_size                = sizeof(int16_t),
+    },
+    [GGML_TYPE_I32] = {
+        .type_name                = "i32",
+        .blck_size                = 1,
+        .type_size                = sizeof(int32_t),
+    },
 };
 
 static const char * op_names[GGML_OP_COUNT] = {
@@ -123,12 +225,21 @@ static const char * op_names[GGML_OP_COUNT] = {
 };
 
 // Utility functions
+int ggml_blck_size(enum ggml_type type) {
+    return type_traits[type].blck_size;
+}
+
 size_t ggml_type_size(enum ggml_type type) {
-    return type_sizes[type];
+    return type_traits[type].type_size;
+}
+
+size_t ggml_row_size(enum ggml_type type, int64_t ne) {
+    assert(ne % ggml_blck_size(type) == 0);
+    return ggml_type_size(type)*ne/ggml_blck_size(type);
 }
 
 const char * ggml_type_name(enum ggml_type type) {
-    return type_names[type];
+    return type_traits[type].type_name;
 }
 
 const char * ggml_op_name(enum ggml_op op) {
@@ -136,12 +247,165 @@ const char * ggml_op_name(enum ggml_op op) {
 }
 
 bool ggml_is_quantized(enum ggml_type type) {
-    return type == GGML_TYPE_Q4_0 || type == GGML_TYPE_Q4_1 || 
-           type == GGML_TYPE_Q5_0 || type == GGML_TYPE_Q5_1 ||
-           type == GGML_TYPE_Q8_0 || type == GGML_TYPE_Q8_1 ||
-           type == GGML_TYPE_Q2_K || type == GGML_TYPE_Q3_K ||
-           type == GGML_TYPE_Q4_K || type == GGML_TYPE_Q5_K ||
-           type == GGML_TYPE_Q6_K || type == GGML_TYPE_Q8_K;
+    return type_traits[type].is_quantized;
+}
+
+ggml_type_traits_t ggml_internal_get_type_traits(enum ggml_type type) {
+    assert(type < GGML_TYPE_COUNT);
+    return type_traits[type];
+}
+
+size_t ggml_quantize_chunk(enum ggml_type type, const float * src, void * dst, int start, int n, int64_t * hist) {
+    size_t result = 0;
+    switch (type) {
+        case GGML_TYPE_Q4_0:
+            {
+                assert(start % QK4_0 == 0);
+                block_q4_0 * block = (block_q4_0 *) dst + start / QK4_0;
+                result = ggml_quantize_q4_0(src + start, block, n, n, hist);
+            } break;
+        case GGML_TYPE_Q4_1:
+            {
+                assert(start % QK4_1 == 0);
+                block_q4_1 * block = (block_q4_1 *) dst + start / QK4_1;
+                result = ggml_quantize_q4_1(src + start, block, n, n, hist);
+            } break;
+        case GGML_TYPE_Q5_0:
+            {
+                assert(start % QK5_0 == 0);
+                block_q5_0 * block = (block_q5_0 *) dst + start / QK5_0;
+                result = ggml_quantize_q5_0(src + start, block, n, n, hist);
+            } break;
+        case GGML_TYPE_Q5_1:
+            {
+                assert(start % QK5_1 == 0);
+                block_q5_1 * block = (block_q5_1 *) dst + start / QK5_1;
+                result = ggml_quantize_q5_1(src + start, block, n, n, hist);
+            } break;
+        case GGML_TYPE_Q8_0:
+            {
+                assert(start % QK8_0 == 0);
+                block_q8_0 * block = (block_q8_0 *) dst + start / QK8_0;
+                result = ggml_quantize_q8_0(src + start, block, n, n, hist);
+            } break;
+        case GGML_TYPE_F16:
+            {
+                ggml_fp32_to_fp16_row(src + start, (ggml_fp16_t *) dst + start, n);
+                result = n * sizeof(ggml_fp16_t);
+            } break;
+        case GGML_TYPE_F32:
+            {
+                memcpy((float *) dst + start, src + start, n * sizeof(float));
+                result = n * sizeof(float);
+            } break;
+        default:
+            assert(false);
+    }
+    return result;
+}
+
+// FP16 <-> FP32
+float ggml_fp16_to_fp32(ggml_fp16_t h) {
+    return GGML_FP16_TO_FP32(h);
+}
+
+ggml_fp16_t ggml_fp32_to_fp16(float f) {
+    return GGML_FP32_TO_FP16(f);
+}
+
+// CPU features, probed once in ggml_init()
+static struct {
+    bool initialized;
+    bool avx2; // AVX2 + FMA
+    bool f16c;
+} ggml_cpu_features;
+
+static void ggml_cpu_features_init(void) {
+    if (ggml_cpu_features.initialized) {
+        return;
+    }
+#if defined(GGML_X86) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    ggml_cpu_features.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    ggml_cpu_features.f16c = __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#elif defined(GGML_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    const int n_ids = info[0];
+    bool os_avx = false;
+    bool fma = false;
+    if (n_ids >= 1) {
+        __cpuidex(info, 1, 0);
+        fma = (info[2] & (1 << 12)) != 0;
+        ggml_cpu_features.f16c = (info[2] & (1 << 29)) != 0;
+        // OSXSAVE + AVX, and the OS saves the YMM state
+        if ((info[2] & (1 << 27)) && (info[2] & (1 << 28))) {
+            os_avx = (_xgetbv(0) & 0x6) == 0x6;
+        }
+    }
+    if (n_ids >= 7) {
+        __cpuidex(info, 7, 0);
+        ggml_cpu_features.avx2 = os_avx && fma && (info[1] & (1 << 5)) != 0;
+    }
+    ggml_cpu_features.f16c = ggml_cpu_features.f16c && os_avx;
+#endif
+    ggml_cpu_features.initialized = true;
+}
+
+#if defined(GGML_X86)
+GGML_TARGET_F16C
+static void ggml_fp16_to_fp32_row_f16c(const ggml_fp16_t * x, float * y, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm256_storeu_ps(y + i, _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(x + i))));
+    }
+    for (; i < n; ++i) {
+        y[i] = ggml_fp16_to_fp32(x[i]);
+    }
+}
+
+GGML_TARGET_F16C
+static void ggml_fp32_to_fp16_row_f16c(const float * x, ggml_fp16_t * y, int n) {
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm_storeu_si128((__m128i *)(y + i), _mm256_cvtps_ph(_mm256_loadu_ps(x + i), 0));
+    }
+    for (; i < n; ++i) {
+        y[i] = ggml_fp32_to_fp16(x[i]);
+    }
+}
+#endif
+
+void ggml_fp16_to_fp32_row(const ggml_fp16_t * x, float * y, int n) {
+#if defined(GGML_X86)
+    ggml_cpu_features_init(); // also called without a context, e.g. on K/V cache rows
+    if (ggml_cpu_features.f16c) {
+        ggml_fp16_to_fp32_row_f16c(x, y, n);
+        return;
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(y + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(x + i))));
+    }
+    x += i; y += i; n -= i;
+#endif
+    for (int i = 0; i < n; ++i) {
+        y[i] = ggml_fp16_to_fp32(x[i]);
+    }
+}
+
+void ggml_fp32_to_fp16_row(const float * x, ggml_fp16_t * y, int n) {
+#if defined(GGML_X86)
+    ggml_cpu_features_init(); // also called without a context, e.g. on K/V cache rows
+    if (ggml_cpu_features.f16c) {
+        ggml_fp32_to_fp16_row_f16c(x, y, n);
+        return;
+    }
+#endif
+    for (int i = 0; i < n; ++i) {
+        y[i] = ggml_fp32_to_fp16(x[i]);
+    }
 }
 
 // Context management
@@ -151,12 +415,15 @@ struct ggml_context * ggml_init(struct ggml_init_params params) {
         return NULL;
     }
     
+    ggml_cpu_features_init();
+    
     ctx->mem_size = params.mem_size;
     ctx->no_alloc = params.no_alloc;
     ctx->mem_used = 0;
     ctx->tensors = NULL;
     ctx->n_tensors = 0;
     
+    ctx->mem_buffer_owned = params.mem_buffer == NULL;
     if (params.mem_buffer) {
         ctx->mem_buffer = params.mem_buffer;
     } else {
@@ -173,8 +440,8 @@ struct ggml_context * ggml_init(struct ggml_init_params params) {
 void ggml_free(struct ggml_context * ctx) {
     if (!ctx) return;
     
-    // Free tensor data if allocated internally
-    if (!ctx->no_alloc && ctx->mem_buffer) {
+    // Free the tensor (and data) memory if allocated internally
+    if (ctx->mem_buffer_owned && ctx->mem_buffer) {
         free(ctx->mem_buffer);
     }
     
@@ -185,14 +452,12 @@ size_t ggml_used_mem(const struct ggml_context * ctx) {
     return ctx ? ctx->mem_used : 0;
 }
 
-// Helper function to calculate tensor size
-static size_t ggml_tensor_overhead() {
+size_t ggml_tensor_overhead(void) {
     return sizeof(struct ggml_tensor);
 }
 
 static size_t ggml_calc_tensor_size(enum ggml_type type, int64_t ne0, int64_t ne1, int64_t ne2, int64_t ne3) {
-    size_t type_size = ggml_type_size(type);
-    return ne0 * ne1 * ne2 * ne3 * type_size;
+    return ggml_row_size(type, ne0) * ne1 * ne2 * ne3;
 }
 
 // Tensor creation
@@ -205,15 +470,14 @@ static struct ggml_tensor * ggml_new_tensor_impl(
     if (!ctx) return NULL;
     
     size_t tensor_size = ggml_tensor_overhead();
-    size_t data_size = 1;
+    size_t data_size = ggml_row_size(type, ne[0]);
     
-    for (int i = 0; i < n_dims; i++) {
+    for (int i = 1; i < n_dims; i++) {
         data_size *= ne[i];
     }
-    data_size *= ggml_type_size(type);
     
-    // Check if we have enough memory
-    if (ctx->mem_used + tensor_size + data_size > ctx->mem_size) {
+    // Check if we have enough memory; no_alloc contexts only hold the tensor struct
+    if (ctx->mem_used + tensor_size + (ctx->no_alloc ? 0 : data_size) > ctx->mem_size) {
         return NULL;
     }
     
@@ -241,7 +505,8 @@ static struct ggml_tensor * ggml_new_tensor_impl(
     
     // Calculate strides
     tensor->nb[0] = ggml_type_size(type);
-    for (int i = 1; i < 4; i++) {
+    tensor->nb[1] = tensor->nb[0]*(tensor->ne[0]/ggml_blck_size(type));
+    for (int i = 2; i < 4; i++) {
         tensor->nb[i] = tensor->nb[i-1] * tensor->ne[i-1];
     }
     
@@ -298,6 +563,185 @@ struct ggml_tensor * ggml_new_tensor_4d(
 }
 
 // Tensor operations (mock implementations)
+//
+// Computation graphs
+//
+
+size_t ggml_hash_size(size_t min_sz) {
+    // odd sizes spread the (aligned) pointer keys over all slots
+    return min_sz | 1;
+}
+
+static size_t ggml_hash(const void * p) {
+    return (size_t) (uintptr_t) p >> 4;
+}
+
+size_t ggml_hash_find(const struct ggml_hash_set hash_set, struct ggml_tensor * key) {
+    size_t h = ggml_hash(key) % hash_set.size;
+
+    // linear probing
+    size_t i = h;
+    while (hash_set.keys[i] != NULL && hash_set.keys[i] != key) {
+        i = (i + 1) % hash_set.size;
+        if (i == h) {
+            // visited all hash table entries -> not found
+            return GGML_HASHTABLE_FULL;
+        }
+    }
+    return i;
+}
+
+bool ggml_hash_contains(const struct ggml_hash_set hash_set, struct ggml_tensor * key) {
+    const size_t i = ggml_hash_find(hash_set, key);
+    return i != GGML_HASHTABLE_FULL && hash_set.keys[i] == key;
+}
+
+size_t ggml_hash_insert(struct ggml_hash_set hash_set, struct ggml_tensor * key) {
+    const size_t i = ggml_hash_find(hash_set, key);
+
+    assert(i != GGML_HASHTABLE_FULL);
+
+    if (hash_set.keys[i] == key) {
+        return GGML_HASHTABLE_ALREADY_EXISTS;
+    }
+
+    // insert
+    assert(hash_set.keys[i] == NULL);
+    hash_set.keys[i] = key;
+    return i;
+}
+
+size_t ggml_hash_find_or_insert(struct ggml_hash_set hash_set, struct ggml_tensor * key) {
+    const size_t i = ggml_hash_find(hash_set, key);
+
+    assert(i != GGML_HASHTABLE_FULL);
+
+    hash_set.keys[i] = key;
+    return i;
+}
+
+static size_t ggml_graph_nbytes(size_t size, bool grads) {
+    const size_t hash_size = ggml_hash_size(size * 2);
+    const size_t nbytes = sizeof(struct ggml_cgraph) +
+                          size * sizeof(struct ggml_tensor *) * (grads ? 3 : 2) + // nodes, leafs, grads
+                          hash_size * sizeof(struct ggml_tensor *);
+    return ggml_up(nbytes, GGML_MEM_ALIGN);
+}
+
+size_t ggml_graph_overhead_custom(size_t size, bool grads) {
+    // including the padding that aligns the graph in the context
+    return ggml_graph_nbytes(size, grads) + GGML_MEM_ALIGN;
+}
+
+size_t ggml_graph_overhead(void) {
+    return ggml_graph_overhead_custom(GGML_DEFAULT_GRAPH_SIZE, false);
+}
+
+struct ggml_cgraph * ggml_new_graph_custom(struct ggml_context * ctx, size_t size, bool grads) {
+    if (!ctx) return NULL;
+
+    // graphs live in the context memory even when tensor data is not allocated
+    const size_t offs = ggml_up(ctx->mem_used, GGML_MEM_ALIGN);
+    const size_t nbytes = ggml_graph_nbytes(size, grads);
+    if (offs + nbytes > ctx->mem_size) {
+        return NULL;
+    }
+    ctx->mem_used = offs + nbytes;
+
+    char * mem = (char *) ctx->mem_buffer + offs;
+    memset(mem, 0, nbytes);
+
+    struct ggml_cgraph * cgraph = (struct ggml_cgraph *) mem;
+    struct ggml_tensor ** ptrs = (struct ggml_tensor **) (cgraph + 1);
+
+    cgraph->size    = (int) size;
+    cgraph->n_nodes = 0;
+    cgraph->n_leafs = 0;
+    cgraph->nodes   = ptrs;
+    cgraph->leafs   = ptrs + size;
+    cgraph->grads   = grads ? ptrs + 2*size : NULL;
+    cgraph->visited_hash_table.size = ggml_hash_size(size * 2);
+    cgraph->visited_hash_table.keys = ptrs + (grads ? 3 : 2)*size;
+    cgraph->order   = GGML_CGRAPH_EVAL_ORDER_LEFT_TO_RIGHT;
+
+    return cgraph;
+}
+
+struct ggml_cgraph * ggml_new_graph(struct ggml_context * ctx) {
+    return ggml_new_graph_custom(ctx, GGML_DEFAULT_GRAPH_SIZE, false);
+}
+
+void ggml_graph_clear(struct ggml_cgraph * cgraph) {
+    cgraph->n_nodes = 0;
+    cgraph->n_leafs = 0;
+    memset(cgraph->visited_hash_table.keys, 0, cgraph->visited_hash_table.size * sizeof(struct ggml_tensor *));
+}
+
+int ggml_graph_n_nodes(const struct ggml_cgraph * cgraph) {
+    return cgraph->n_nodes;
+}
+
+struct ggml_tensor * ggml_graph_node(const struct ggml_cgraph * cgraph, int i) {
+    return i < 0 ? cgraph->nodes[cgraph->n_nodes + i] : cgraph->nodes[i];
+}
+
+// post-order DFS: every node is appended after the tensors it reads
+static void ggml_visit_parents(struct ggml_cgraph * cgraph, struct ggml_tensor * node) {
+    if (ggml_hash_insert(cgraph->visited_hash_table, node) == GGML_HASHTABLE_ALREADY_EXISTS) {
+        return;
+    }
+
+    const int n_src = (int) (sizeof(node->src)/sizeof(node->src[0]));
+    for (int i = 0; i < n_src; ++i) {
+        const int k =
+            (cgraph->order == GGML_CGRAPH_EVAL_ORDER_LEFT_TO_RIGHT) ? i :
+            (cgraph->order == GGML_CGRAPH_EVAL_ORDER_RIGHT_TO_LEFT) ? (n_src - 1 - i) :
+            /* unknown order, just fall back to using i*/ i;
+        if (node->src[k]) {
+            ggml_visit_parents(cgraph, node->src[k]);
+        }
+    }
+
+    if (node->op == GGML_OP_NONE && node->grad == NULL) {
+        // reached a leaf node, not part of the gradient graph (e.g. a constant)
+        assert(cgraph->n_leafs < cgraph->size);
+
+        if (strlen(node->name) == 0) {
+            snprintf(node->name, sizeof(node->name), "leaf_%d", cgraph->n_leafs);
+        }
+
+        cgraph->leafs[cgraph->n_leafs] = node;
+        cgraph->n_leafs++;
+    } else {
+        assert(cgraph->n_nodes < cgraph->size);
+
+        if (strlen(node->name) == 0) {
+            snprintf(node->name, sizeof(node->name), "node_%d", cgraph->n_nodes);
+        }
+
+        cgraph->nodes[cgraph->n_nodes] = node;
+        if (cgraph->grads) {
+            cgraph->grads[cgraph->n_nodes] = node->grad;
+        }
+        cgraph->n_nodes++;
+    }
+}
+
+void ggml_build_forward_expand(struct ggml_cgraph * cgraph, struct ggml_tensor * tensor) {
+    if (!cgraph || !tensor) return;
+
+    const int n0 = cgraph->n_nodes;
+
+    ggml_visit_parents(cgraph, tensor);
+
+    const int n_new = cgraph->n_nodes - n0;
+    (void) n_new;
+    if (n_new > 0) {
+        // the last added node should always be starting point
+        assert(cgraph->nodes[cgraph->n_nodes - 1] == tensor);
+    }
+}
+
 struct ggml_tensor * ggml_add(
         struct ggml_context * ctx,
         struct ggml_tensor  * a,
@@ -341,9 +785,14 @@ struct ggml_tensor * ggml_mul_mat(
     
     if (!ctx || !a || !b) return NULL;
     
-    // Result dimensions: [ne00, ne11, ne12, ne13]
-    int64_t ne[4] = { a->ne[0], b->ne[1], b->ne[2], b->ne[3] };
-    struct ggml_tensor * result = ggml_new_tensor_impl(ctx, a->type, 4, ne);
+    // a: [K, M, ...], b: [K, N, ...] -> result: [M, N, ...], always F32
+    // a is broadcast over the batch dims of b
+    if (a->ne[0] != b->ne[0] || b->ne[2] % a->ne[2] != 0 || b->ne[3] % a->ne[3] != 0) {
+        return NULL;
+    }
+    
+    int64_t ne[4] = { a->ne[1], b->ne[1], b->ne[2], b->ne[3] };
+    struct ggml_tensor * result = ggml_new_tensor_impl(ctx, GGML_TYPE_F32, 4, ne);
     if (!result) return NULL;
     
     result->op = GGML_OP_MUL_MAT;
@@ -353,18 +802,689 @@ struct ggml_tensor * ggml_mul_mat(
     return result;
 }
 
-// Computation (mock implementation)
-void ggml_compute_forward(struct ggml_tensor * tensor, void * ctx) {
-    (void)ctx; // unused
+struct ggml_tensor * ggml_reshape_3d(
+        struct ggml_context * ctx,
+        struct ggml_tensor  * a,
+        int64_t ne0,
+        int64_t ne1,
+        int64_t ne2) {
+    
+    if (!ctx || !a || ne0 % ggml_blck_size(a->type) != 0 ||
+        ne0*ne1*ne2 != a->ne[0]*a->ne[1]*a->ne[2]*a->ne[3]) {
+        return NULL;
+    }
+    
+    // only contiguous tensors can be viewed with another shape
+    if (a->nb[0] != ggml_type_size(a->type) ||
+        a->nb[2] != a->nb[1]*a->ne[1] || a->nb[3] != a->nb[2]*a->ne[2]) {
+        return NULL;
+    }
+    
+    // the view has no data of its own
+    const bool no_alloc = ctx->no_alloc;
+    ctx->no_alloc = true;
+    int64_t ne[3] = { ne0, ne1, ne2 };
+    struct ggml_tensor * result = ggml_new_tensor_impl(ctx, a->type, 3, ne);
+    ctx->no_alloc = no_alloc;
+    if (!result) return NULL;
     
+    result->op = GGML_OP_RESHAPE;
+    result->src[0] = a;
+    result->view_src = a->view_src ? a->view_src : a;
+    result->view_offs = a->view_offs;
+    result->data = a->data;
+    result->buffer = a->buffer;
+    
+    return result;
+}
+
+//
+// Matrix multiplication
+//
+// dst[n][m] = sum_k src0[m][k] * src1[n][k]. Both operands are K-contiguous, so
+// each output is a dot product. The output is cut into MB x NB tiles (one task
+// each); within a tile K is walked in KC-sized slices so the A and B panels stay
+// cache-resident, and a 4x2 micro-kernel produces eight dot products per pass.
+//
+
+#define GGML_GEMM_MB 64
+#define GGML_GEMM_NB 64
+#define GGML_GEMM_KC 256
+
+struct ggml_gemm_kernels {
+    // s[j*4 + i] = dot(a + i*lda, b + j*ldb) for i < 4, j < 2
+    void  (*dot_4x2)(int k, const float * a, size_t lda, const float * b, size_t ldb, float * s);
+    float (*dot)    (int k, const float * a, const float * b);
+};
+
+static void ggml_dot_4x2_f32_scalar(int k, const float * a, size_t lda, const float * b, size_t ldb, float * s) {
+    float acc[8] = { 0.0f };
+    for (int l = 0; l < k; ++l) {
+        const float b0 = b[l];
+        const float b1 = b[ldb + l];
+        for (int i = 0; i < 4; ++i) {
+            const float ai = a[i*lda + l];
+            acc[i]     += ai*b0;
+            acc[4 + i] += ai*b1;
+        }
+    }
+    memcpy(s, acc, sizeof(acc));
+}
+
+static float ggml_dot_f32_scalar(int k, const float * a, const float * b) {
+    float sum = 0.0f;
+    for (int l = 0; l < k; ++l) {
+        sum += a[l]*b[l];
+    }
+    return sum;
+}
+
+static const struct ggml_gemm_kernels ggml_gemm_kernels_scalar = {
+    ggml_dot_4x2_f32_scalar,
+    ggml_dot_f32_scalar,
+};
+
+#if defined(GGML_X86)
+static inline float ggml_hsum_f32_sse(__m128 x) {
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 0x55));
+    return _mm_cvtss_f32(x);
+}
+
+static void ggml_dot_4x2_f32_sse(int k, const float * a, size_t lda, const float * b, size_t ldb, float * s) {
+    __m128 acc[8];
+    for (int i = 0; i < 8; ++i) {
+        acc[i] = _mm_setzero_ps();
+    }
+
+    int l = 0;
+    for (; l + 4 <= k; l += 4) {
+        const __m128 b0 = _mm_loadu_ps(b + l);
+        const __m128 b1 = _mm_loadu_ps(b + ldb + l);
+        for (int i = 0; i < 4; ++i) {
+            const __m128 ai = _mm_loadu_ps(a + i*lda + l);
+            acc[i]     = _mm_add_ps(acc[i],     _mm_mul_ps(ai, b0));
+            acc[4 + i] = _mm_add_ps(acc[4 + i], _mm_mul_ps(ai, b1));
+        }
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        s[i] = ggml_hsum_f32_sse(acc[i]);
+    }
+    for (; l < k; ++l) {
+        for (int i = 0; i < 4; ++i) {
+            s[i]     += a[i*lda + l]*b[l];
+            s[4 + i] += a[i*lda + l]*b[ldb + l];
+        }
+    }
+}
+
+static float ggml_dot_f32_sse(int k, const float * a, const float * b) {
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+
+    int l = 0;
+    for (; l + 8 <= k; l += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + l),     _mm_loadu_ps(b + l)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + l + 4), _mm_loadu_ps(b + l + 4)));
+    }
+
+    float sum = ggml_hsum_f32_sse(_mm_add_ps(acc0, acc1));
+    for (; l < k; ++l) {
+        sum += a[l]*b[l];
+    }
+    return sum;
+}
+
+static const struct ggml_gemm_kernels ggml_gemm_kernels_sse = {
+    ggml_dot_4x2_f32_sse,
+    ggml_dot_f32_sse,
+};
+
+GGML_TARGET_AVX2
+static inline float ggml_hsum_f32_avx(__m256 x) {
+    const __m128 lo = _mm256_castps256_ps128(x);
+    const __m128 hi = _mm256_extractf128_ps(x, 1);
+    __m128 r = _mm_add_ps(lo, hi);
+    r = _mm_add_ps(r, _mm_movehl_ps(r, r));
+    r = _mm_add_ss(r, _mm_shuffle_ps(r, r, 0x55));
+    return _mm_cvtss_f32(r);
+}
+
+GGML_TARGET_AVX2
+static void ggml_dot_4x2_f32_avx2(int k, const float * a, size_t lda, const float * b, size_t ldb, float * s) {
+    __m256 c00 = _mm256_setzero_ps(), c10 = _mm256_setzero_ps(), c20 = _mm256_setzero_ps(), c30 = _mm256_setzero_ps();
+    __m256 c01 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+
+    const float * a0 = a;
+    const float * a1 = a + lda;
+    const float * a2 = a + 2*lda;
+    const float * a3 = a + 3*lda;
+    const float * b0 = b;
+    const float * b1 = b + ldb;
+
+    int l = 0;
+    for (; l + 8 <= k; l += 8) {
+        const __m256 vb0 = _mm256_loadu_ps(b0 + l);
+        const __m256 vb1 = _mm256_loadu_ps(b1 + l);
+
+        __m256 va = _mm256_loadu_ps(a0 + l);
+        c00 = _mm256_fmadd_ps(va, vb0, c00);
+        c01 = _mm256_fmadd_ps(va, vb1, c01);
+
+        va = _mm256_loadu_ps(a1 + l);
+        c10 = _mm256_fmadd_ps(va, vb0, c10);
+        c11 = _mm256_fmadd_ps(va, vb1, c11);
+
+        va = _mm256_loadu_ps(a2 + l);
+        c20 = _mm256_fmadd_ps(va, vb0, c20);
+        c21 = _mm256_fmadd_ps(va, vb1, c21);
+
+        va = _mm256_loadu_ps(a3 + l);
+        c30 = _mm256_fmadd_ps(va, vb0, c30);
+        c31 = _mm256_fmadd_ps(va, vb1, c31);
+    }
+
+    s[0] = ggml_hsum_f32_avx(c00);
+    s[1] = ggml_hsum_f32_avx(c10);
+    s[2] = ggml_hsum_f32_avx(c20);
+    s[3] = ggml_hsum_f32_avx(c30);
+    s[4] = ggml_hsum_f32_avx(c01);
+    s[5] = ggml_hsum_f32_avx(c11);
+    s[6] = ggml_hsum_f32_avx(c21);
+    s[7] = ggml_hsum_f32_avx(c31);
+
+    for (; l < k; ++l) {
+        s[0] += a0[l]*b0[l]; s[4] += a0[l]*b1[l];
+        s[1] += a1[l]*b0[l]; s[5] += a1[l]*b1[l];
+        s[2] += a2[l]*b0[l]; s[6] += a2[l]*b1[l];
+        s[3] += a3[l]*b0[l]; s[7] += a3[l]*b1[l];
+    }
+}
+
+GGML_TARGET_AVX2
+static float ggml_dot_f32_avx2(int k, const float * a, const float * b) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+
+    int l = 0;
+    for (; l + 16 <= k; l += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + l),     _mm256_loadu_ps(b + l),     acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + l + 8), _mm256_loadu_ps(b + l + 8), acc1);
+    }
+    for (; l + 8 <= k; l += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + l), _mm256_loadu_ps(b + l), acc0);
+    }
+
+    float sum = ggml_hsum_f32_avx(_mm256_add_ps(acc0, acc1));
+    for (; l < k; ++l) {
+        sum += a[l]*b[l];
+    }
+    return sum;
+}
+
+static const struct ggml_gemm_kernels ggml_gemm_kernels_avx2 = {
+    ggml_dot_4x2_f32_avx2,
+    ggml_dot_f32_avx2,
+};
+#elif defined(__ARM_NEON)
+static inline float ggml_hsum_f32_neon(float32x4_t x) {
+#if defined(__aarch64__)
+    return vaddvq_f32(x);
+#else
+    const float32x2_t r = vadd_f32(vget_low_f32(x), vget_high_f32(x));
+    return vget_lane_f32(vpadd_f32(r, r), 0);
+#endif
+}
+
+static void ggml_dot_4x2_f32_neon(int k, const float * a, size_t lda, const float * b, size_t ldb, float * s) {
+    float32x4_t acc[8];
+    for (int i = 0; i < 8; ++i) {
+        acc[i] = vdupq_n_f32(0.0f);
+    }
+
+    int l = 0;
+    for (; l + 4 <= k; l += 4) {
+        const float32x4_t b0 = vld1q_f32(b + l);
+        const float32x4_t b1 = vld1q_f32(b + ldb + l);
+        for (int i = 0; i < 4; ++i) {
+            const float32x4_t ai = vld1q_f32(a + i*lda + l);
+            acc[i]     = vmlaq_f32(acc[i],     ai, b0);
+            acc[4 + i] = vmlaq_f32(acc[4 + i], ai, b1);
+        }
+    }
+
+    for (int i = 0; i < 8; ++i) {
+        s[i] = ggml_hsum_f32_neon(acc[i]);
+    }
+    for (; l < k; ++l) {
+        for (int i = 0; i < 4; ++i) {
+            s[i]     += a[i*lda + l]*b[l];
+            s[4 + i] += a[i*lda + l]*b[ldb + l];
+        }
+    }
+}
+
+static float ggml_dot_f32_neon(int k, const float * a, const float * b) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+
+    int l = 0;
+    for (; l + 8 <= k; l += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + l),     vld1q_f32(b + l));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + l + 4), vld1q_f32(b + l + 4));
+    }
+
+    float sum = ggml_hsum_f32_neon(vaddq_f32(acc0, acc1));
+    for (; l < k; ++l) {
+        sum += a[l]*b[l];
+    }
+    return sum;
+}
+
+static const struct ggml_gemm_kernels ggml_gemm_kernels_neon = {
+    ggml_dot_4x2_f32_neon,
+    ggml_dot_f32_neon,
+};
+#endif
+
+static const struct ggml_gemm_kernels * ggml_gemm_get_kernels(void) {
+#if defined(GGML_X86)
+    if (ggml_cpu_features.avx2) {
+        return &ggml_gemm_kernels_avx2;
+    }
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return &ggml_gemm_kernels_sse;
+#endif
+#elif defined(__ARM_NEON)
+    return &ggml_gemm_kernels_neon;
+#endif
+    return &ggml_gemm_kernels_scalar;
+}
+
+// c[j*ldc + i] (+)= dot(a + i*lda, b + j*ldb) for an m x n block with k <= KC
+static void ggml_gemm_block_f32(
+        const struct ggml_gemm_kernels * kr,
+        int m, int n, int k,
+        const float * a, size_t lda,
+        const float * b, size_t ldb,
+        float * c, size_t ldc,
+        bool accumulate) {
+    float s[8];
+
+    int j = 0;
+    for (; j + 2 <= n; j += 2) {
+        float * c0 = c + (size_t) j*ldc;
+        float * c1 = c0 + ldc;
+
+        int i = 0;
+        for (; i + 4 <= m; i += 4) {
+            kr->dot_4x2(k, a + (size_t) i*lda, lda, b + (size_t) j*ldb, ldb, s);
+            if (accumulate) {
+                for (int ii = 0; ii < 4; ++ii) {
+                    c0[i + ii] += s[ii];
+                    c1[i + ii] += s[4 + ii];
+                }
+            } else {
+                for (int ii = 0; ii < 4; ++ii) {
+                    c0[i + ii] = s[ii];
+                    c1[i + ii] = s[4 + ii];
+                }
+            }
+        }
+        for (; i < m; ++i) {
+            const float s0 = kr->dot(k, a + (size_t) i*lda, b + (size_t) j*ldb);
+            const float s1 = kr->dot(k, a + (size_t) i*lda, b + (size_t) (j + 1)*ldb);
+            c0[i] = accumulate ? c0[i] + s0 : s0;
+            c1[i] = accumulate ? c1[i] + s1 : s1;
+        }
+    }
+    for (; j < n; ++j) {
+        float * cj = c + (size_t) j*ldc;
+        for (int i = 0; i < m; ++i) {
+            const float sj = kr->dot(k, a + (size_t) i*lda, b + (size_t) j*ldb);
+            cj[i] = accumulate ? cj[i] + sj : sj;
+        }
+    }
+}
+
+// Copy rows [r0, r1) x cols [k0, k0 + kc) of a 2D slice into a dense f32 panel
+static void ggml_gemm_pack_f32(
+        const struct ggml_tensor * src, const char * base,
+        int r0, int r1, int k0, int kc, float * dst) {
+    for (int r = r0; r < r1; ++r) {
+        const char * row = base + (size_t) r*src->nb[1];
+        float * out = dst + (size_t) (r - r0)*kc;
+        if (src->type == GGML_TYPE_F16 && src->nb[0] == sizeof(ggml_fp16_t)) {
+            ggml_fp16_to_fp32_row((const ggml_fp16_t *) row + k0, out, kc);
+        } else if (src->type == GGML_TYPE_F16) {
+            for (int l = 0; l < kc; ++l) {
+                out[l] = ggml_fp16_to_fp32(*(const ggml_fp16_t *)(row + (size_t) (k0 + l)*src->nb[0]));
+            }
+        } else {
+            for (int l = 0; l < kc; ++l) {
+                out[l] = *(const float *)(row + (size_t) (k0 + l)*src->nb[0]);
+            }
+        }
+    }
+}
+
+static bool ggml_gemm_is_direct(const struct ggml_tensor * t) {
+    return t->type == GGML_TYPE_F32 && t->nb[0] == sizeof(float) && t->nb[1] % sizeof(float) == 0;
+}
+
+// Quantized src0 is multiplied with its vec_dot kernel against src1 rows quantized to vec_dot_type
+static bool ggml_mul_mat_is_quantized(const struct ggml_tensor * dst) {
+    return type_traits[dst->src[0]->type].vec_dot != NULL;
+}
+
+static bool ggml_mul_mat_supported(const struct ggml_tensor * dst) {
+    const struct ggml_tensor * src0 = dst->src[0];
+    const struct ggml_tensor * src1 = dst->src[1];
+
+    if (!(src1->type == GGML_TYPE_F32 || src1->type == GGML_TYPE_F16) ||
+        dst->type != GGML_TYPE_F32 || dst->nb[0] != sizeof(float)) {
+        return false;
+    }
+
+    if (ggml_mul_mat_is_quantized(dst)) {
+        return src0->ne[0] % ggml_blck_size(src0->type) == 0 &&
+               src0->nb[0] == ggml_type_size(src0->type);
+    }
+
+    return src0->type == GGML_TYPE_F32 || src0->type == GGML_TYPE_F16;
+}
+
+static int ggml_mul_mat_n_tasks(const struct ggml_tensor * dst) {
+    const int64_t nbm = (dst->ne[0] + GGML_GEMM_MB - 1)/GGML_GEMM_MB;
+    const int64_t nbn = (dst->ne[1] + GGML_GEMM_NB - 1)/GGML_GEMM_NB;
+
+    return (int) (nbm*nbn*dst->ne[2]*dst->ne[3]);
+}
+
+static size_t ggml_mul_mat_work_size(const struct ggml_tensor * dst) {
+    // A and B panels
+    size_t size = (size_t) (GGML_GEMM_MB + GGML_GEMM_NB)*GGML_GEMM_KC*sizeof(float);
+
+    if (ggml_mul_mat_is_quantized(dst)) {
+        // NB quantized src1 rows plus one f32 row to convert F16 or strided input
+        const int64_t K = dst->src[0]->ne[0];
+        const size_t qsize = GGML_GEMM_NB*ggml_row_size(type_traits[dst->src[0]->type].vec_dot_type, K) + K*sizeof(float);
+        size = qsize > size ? qsize : size;
+    }
+
+    return size;
+}
+
+static void ggml_compute_forward_mul_mat_q(
+        const struct ggml_compute_params * params,
+        struct ggml_tensor * dst,
+        int it0, int it1) {
+    const struct ggml_tensor * src0 = dst->src[0];
+    const struct ggml_tensor * src1 = dst->src[1];
+
+    const ggml_vec_dot_t    vec_dot      = type_traits[src0->type].vec_dot;
+    const enum ggml_type    vec_dot_type = type_traits[src0->type].vec_dot_type;
+    const ggml_from_float_t from_float   = type_traits[vec_dot_type].from_float;
+
+    const int64_t K  = src0->ne[0];
+    const int64_t M  = dst->ne[0];
+    const int64_t N  = dst->ne[1];
+    const int64_t r2 = src1->ne[2]/src0->ne[2];
+    const int64_t r3 = src1->ne[3]/src0->ne[3];
+
+    const int64_t nbm = (M + GGML_GEMM_MB - 1)/GGML_GEMM_MB;
+    const int64_t nbn = (N + GGML_GEMM_NB - 1)/GGML_GEMM_NB;
+
+    const size_t row_size = ggml_row_size(vec_dot_type, K);
+
+    char  * wq   = (char *) params->wdata;
+    float * wrow = (float *) (wq + GGML_GEMM_NB*row_size);
+
+    const size_t ldc = dst->nb[1]/sizeof(float);
+
+    // the quantized B panel is reused while consecutive tasks stay on the same (batch, n-block)
+    int64_t cached = -1;
+
+    for (int it = it0; it < it1; ++it) {
+        const int64_t im  = it % nbm;
+        const int64_t in  = (it/nbm) % nbn;
+        const int64_t i23 = it/(nbm*nbn);
+        const int64_t i12 = i23 % dst->ne[2];
+        const int64_t i13 = i23/dst->ne[2];
+
+        const int m0 = (int) (im*GGML_GEMM_MB);
+        const int m1 = (int) (m0 + GGML_GEMM_MB < M ? m0 + GGML_GEMM_MB : M);
+        const int n0 = (int) (in*GGML_GEMM_NB);
+        const int n1 = (int) (n0 + GGML_GEMM_NB < N ? n0 + GGML_GEMM_NB : N);
+
+        const char * base0 = (const char *) src0->data + (i12/r2)*src0->nb[2] + (i13/r3)*src0->nb[3];
+        const char * base1 = (const char *) src1->data + i12*src1->nb[2] + i13*src1->nb[3];
+        float * c = (float *) ((char *) dst->data + i12*dst->nb[2] + i13*dst->nb[3]);
+
+        if (cached != it/nbm) {
+            for (int n = n0; n < n1; ++n) {
+                const float * row;
+                if (ggml_gemm_is_direct(src1)) {
+                    row = (const float *) (base1 + (size_t) n*src1->nb[1]);
+                } else {
+                    ggml_gemm_pack_f32(src1, base1, n, n + 1, 0, (int) K, wrow);
+                    row = wrow;
+                }
+                from_float(row, wq + (size_t) (n - n0)*row_size, (int) K);
+            }
+            cached = it/nbm;
+        }
+
+        for (int n = n0; n < n1; ++n) {
+            const char * q = wq + (size_t) (n - n0)*row_size;
+            float * cn = c + (size_t) n*ldc;
+            for (int m = m0; m < m1; ++m) {
+                vec_dot((int) K, cn + m, base0 + (size_t) m*src0->nb[1], q);
+            }
+        }
+    }
+}
+
+static void ggml_compute_forward_mul_mat(
+        const struct ggml_compute_params * params,
+        struct ggml_tensor * dst,
+        int it0, int it1) {
+    const struct ggml_tensor * src0 = dst->src[0];
+    const struct ggml_tensor * src1 = dst->src[1];
+
+    assert(params->wsize >= ggml_mul_mat_work_size(dst));
+
+    if (ggml_mul_mat_is_quantized(dst)) {
+        ggml_compute_forward_mul_mat_q(params, dst, it0, it1);
+        return;
+    }
+
+    const int64_t K  = src0->ne[0];
+    const int64_t M  = dst->ne[0];
+    const int64_t N  = dst->ne[1];
+    const int64_t r2 = src1->ne[2]/src0->ne[2];
+    const int64_t r3 = src1->ne[3]/src0->ne[3];
+
+    const int64_t nbm = (M + GGML_GEMM_MB - 1)/GGML_GEMM_MB;
+    const int64_t nbn = (N + GGML_GEMM_NB - 1)/GGML_GEMM_NB;
+
+    const bool direct0 = ggml_gemm_is_direct(src0);
+    const bool direct1 = ggml_gemm_is_direct(src1);
+
+    float * wa = (float *) params->wdata;
+    float * wb = wa + GGML_GEMM_MB*GGML_GEMM_KC;
+
+    const struct ggml_gemm_kernels * kr = ggml_gemm_get_kernels();
+    const size_t ldc = dst->nb[1]/sizeof(float);
+
+    for (int it = it0; it < it1; ++it) {
+        // tasks are ordered batch, n-block, m-block so neighbouring tasks share the B panel
+        const int64_t im  = it % nbm;
+        const int64_t in  = (it/nbm) % nbn;
+        const int64_t i23 = it/(nbm*nbn);
+        const int64_t i12 = i23 % dst->ne[2];
+        const int64_t i13 = i23/dst->ne[2];
+
+        const int m0 = (int) (im*GGML_GEMM_MB);
+        const int m1 = (int) (m0 + GGML_GEMM_MB < M ? m0 + GGML_GEMM_MB : M);
+        const int n0 = (int) (in*GGML_GEMM_NB);
+        const int n1 = (int) (n0 + GGML_GEMM_NB < N ? n0 + GGML_GEMM_NB : N);
+
+        const char * base0 = (const char *) src0->data + (i12/r2)*src0->nb[2] + (i13/r3)*src0->nb[3];
+        const char * base1 = (const char *) src1->data + i12*src1->nb[2] + i13*src1->nb[3];
+        float * c = (float *) ((char *) dst->data + i12*dst->nb[2] + i13*dst->nb[3]) + (size_t) n0*ldc + m0;
+
+        for (int k0 = 0; k0 < K; k0 += GGML_GEMM_KC) {
+            const int kc = (int) (k0 + GGML_GEMM_KC < K ? GGML_GEMM_KC : K - k0);
+
+            const float * a;
+            size_t lda;
+            if (direct0) {
+                a   = (const float *) (base0 + (size_t) m0*src0->nb[1]) + k0;
+                lda = src0->nb[1]/sizeof(float);
+            } else {
+                ggml_gemm_pack_f32(src0, base0, m0, m1, k0, kc, wa);
+                a   = wa;
+                lda = kc;
+            }
+
+            const float * b;
+            size_t ldb;
+            if (direct1) {
+                b   = (const float *) (base1 + (size_t) n0*src1->nb[1]) + k0;
+                ldb = src1->nb[1]/sizeof(float);
+            } else {
+                ggml_gemm_pack_f32(src1, base1, n0, n1, k0, kc, wb);
+                b   = wb;
+                ldb = kc;
+            }
+
+            ggml_gemm_block_f32(kr, m1 - m0, n1 - n0, kc, a, lda, b, ldb, c, ldc, k0 > 0);
+        }
+    }
+}
+
+//
+// Element-wise ops, one task per row of dst; src1 is broadcast (repeated) over src0
+//
+
+static void ggml_compute_forward_binary_f32(
+        struct ggml_tensor * dst,
+        int it0, int it1,
+        bool mul) {
+    const struct ggml_tensor * src0 = dst->src[0];
+    const struct ggml_tensor * src1 = dst->src[1];
+
+    const int64_t ne0 = dst->ne[0];
+
+    for (int it = it0; it < it1; ++it) {
+        const int64_t i1 = it % dst->ne[1];
+        const int64_t i2 = (it/dst->ne[1]) % dst->ne[2];
+        const int64_t i3 = it/(dst->ne[1]*dst->ne[2]);
+
+        const char * x = (const char *) src0->data + i1*src0->nb[1] + i2*src0->nb[2] + i3*src0->nb[3];
+        const char * y = (const char *) src1->data + (i1 % src1->ne[1])*src1->nb[1] +
+                         (i2 % src1->ne[2])*src1->nb[2] + (i3 % src1->ne[3])*src1->nb[3];
+        float * z = (float *) ((char *) dst->data + i1*dst->nb[1] + i2*dst->nb[2] + i3*dst->nb[3]);
+
+        for (int64_t i0 = 0; i0 < ne0; ++i0) {
+            const float a = *(const float *) (x + i0*src0->nb[0]);
+            const float b = *(const float *) (y + (i0 % src1->ne[0])*src1->nb[0]);
+            z[i0] = mul ? a*b : a + b;
+        }
+    }
+}
+
+static bool ggml_binary_supported(const struct ggml_tensor * dst) {
+    const struct ggml_tensor * src0 = dst->src[0];
+    const struct ggml_tensor * src1 = dst->src[1];
+
+    return src0->type == GGML_TYPE_F32 && src1->type == GGML_TYPE_F32 && dst->type == GGML_TYPE_F32 &&
+           dst->nb[0] == sizeof(float);
+}
+
+//
+// Task API
+//
+
+int ggml_get_n_tasks(const struct ggml_tensor * tensor) {
+    if (!tensor || !tensor->data) {
+        return 0;
+    }
+
+    switch (tensor->op) {
+        case GGML_OP_MUL_MAT:
+            return ggml_mul_mat_supported(tensor) ? ggml_mul_mat_n_tasks(tensor) : 0;
+        case GGML_OP_ADD:
+        case GGML_OP_MUL:
+            return ggml_binary_supported(tensor) ? (int) (tensor->ne[1]*tensor->ne[2]*tensor->ne[3]) : 0;
+        default:
+            return 0;
+    }
+}
+
+size_t ggml_compute_forward_work_size(const struct ggml_tensor * tensor) {
+    if (!tensor) {
+        return 0;
+    }
+
+    switch (tensor->op) {
+        case GGML_OP_MUL_MAT:
+            return ggml_mul_mat_work_size(tensor);
+        default:
+            return 0;
+    }
+}
+
+void ggml_compute_forward_range(const struct ggml_compute_params * params, struct ggml_tensor * tensor, int it0, int it1) {
+    if (it0 >= it1) {
+        return;
+    }
+
+    switch (tensor->op) {
+        case GGML_OP_MUL_MAT:
+            ggml_compute_forward_mul_mat(params, tensor, it0, it1);
+            break;
+        case GGML_OP_ADD:
+            ggml_compute_forward_binary_f32(tensor, it0, it1, false);
+            break;
+        case GGML_OP_MUL:
+            ggml_compute_forward_binary_f32(tensor, it0, it1, true);
+            break;
+        default:
+            break;
+    }
+}
+
+void ggml_compute_forward(struct ggml_tensor * tensor, void * ctx) {
     if (!tensor || !tensor->data) return;
     
-    // Mock computation - just zero the output for now
-    size_t total_size = tensor->ne[0] * tensor->ne[1] * tensor->ne[2] * tensor->ne[3] * ggml_type_size(tensor->type);
-    memset(tensor->data, 0, total_size);
+    const int n_tasks = ggml_get_n_tasks(tensor);
+    if (n_tasks == 0) {
+        return;
+    }
+    
+    if (ctx) {
+        // this thread's even share of the tasks
+        const struct ggml_compute_params * params = (const struct ggml_compute_params *) ctx;
+        const int it0 = (int) ((int64_t) n_tasks*params->ith/params->nth);
+        const int it1 = (int) ((int64_t) n_tasks*(params->ith + 1)/params->nth);
+        ggml_compute_forward_range(params, tensor, it0, it1);
+        return;
+    }
+    
+    struct ggml_compute_params params = { 0, 1, ggml_compute_forward_work_size(tensor), NULL };
+    if (params.wsize > 0) {
+        params.wdata = malloc(params.wsize);
+        if (!params.wdata) {
+            return;
+        }
+    }
+    
+    ggml_compute_forward_range(&params, tensor, 0, n_tasks);
     
-    // In a real implementation, this would perform the actual computation
-    // based on tensor->op and tensor->src[0], tensor->src[1]
+    free(params.wdata);
 }
 
 // CUDA support stubs
@@ -5,6 +5,20 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifdef GGML_SHARED
+#    ifdef _WIN32
+#        ifdef GGML_BUILD
+#            define GGML_API __declspec(dllexport)
+#        else
+#            define GGML_API __declspec(dllimport)
+#        endif
+#    else
+#        define GGML_API __attribute__ ((visibility ("default")))
+#    endif
+#else
+#    define GGML_API
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -41,50 +55,25 @@ enum ggml_type {
     GGML_TYPE_COUNT,
 };
 
+// Half-precision storage type
+typedef uint16_t ggml_fp16_t;
+
+// Backend placement of tensor data
+enum ggml_backend_type {
+    GGML_BACKEND_CPU       = 0,
+    GGML_BACKEND_GPU       = 10,
+    GGML_BACKEND_GPU_SPLIT = 20,
+};
+
 // Forward declarations
 struct ggml_context;
 struct ggml_tensor;
+struct ggml_cgraph;
+struct ggml_backend_buffer;
 
 typedef struct ggml_context ggml_context;
 typedef struct ggml_tensor  ggml_tensor;
 
-// Context parameters
-struct ggml_init_params {
-    size_t mem_size;   // bytes
-    void * mem_buffer; // if NULL, memory will be allocated internally
-    bool   no_alloc;   // don't allocate memory for the tensor data
-};
-
-// Tensor struct (simplified)
-struct ggml_tensor {
-    enum ggml_type type;
-    
-    int64_t ne[4]; // number of elements
-    size_t  nb[4]; // stride in bytes
-    
-    // compute data
-    enum ggml_op op;
-    
-    // op params - allocated as int32_t for alignment
-    int32_t op_params[16];
-    
-    bool is_param;
-    
-    struct ggml_tensor * grad;
-    struct ggml_tensor * src[2];
-    
-    // performance
-    int     perf_runs;
-    int64_t perf_cycles;
-    int64_t perf_time_us;
-    
-    void * data;
-    
-    char name[64];
-    
-    void * extra; // extra things e.g. for ggml-cuda.cu
-};
-
 // Operations
 enum ggml_op {
     GGML_OP_NONE = 0,
@@ -173,11 +162,55 @@ enum ggml_op {
     GGML_OP_COUNT,
 };
 
+// Context parameters
+struct ggml_init_params {
+    size_t mem_size;   // bytes
+    void * mem_buffer; // if NULL, memory will be allocated internally
+    bool   no_alloc;   // don't allocate memory for the tensor data
+};
+
+// Tensor struct (simplified)
+struct ggml_tensor {
+    enum ggml_type         type;
+    enum ggml_backend_type backend;
+
+    struct ggml_backend_buffer * buffer;
+    
+    int64_t ne[4]; // number of elements
+    size_t  nb[4]; // stride in bytes
+    
+    // compute data
+    enum ggml_op op;
+    
+    // op params - allocated as int32_t for alignment
+    int32_t op_params[16];
+    
+    bool is_param;
+    
+    struct ggml_tensor * grad;
+    struct ggml_tensor * src[2];
+    
+    // performance
+    int     perf_runs;
+    int64_t perf_cycles;
+    int64_t perf_time_us;
+    
+    struct ggml_tensor * view_src;
+    size_t               view_offs;
+
+    void * data;
+    
+    char name[64];
+    
+    void * extra; // extra things e.g. for ggml-cuda.cu
+};
+
 // Basic functions
 struct ggml_context * ggml_init(struct ggml_init_params params);
 void ggml_free(struct ggml_context * ctx);
 
 size_t ggml_used_mem(const struct ggml_context * ctx);
+size_t ggml_tensor_overhead(void); // context memory per tensor, excluding its data
 
 // Tensor creation
 struct ggml_tensor * ggml_new_tensor_1d(
@@ -222,15 +255,85 @@ struct ggml_tensor * ggml_mul_mat(
         struct ggml_tensor  * a,
         struct ggml_tensor  * b);
 
+// View of contiguous a with another shape of the same size; shares a's data and
+// computes nothing
+struct ggml_tensor * ggml_reshape_3d(
+        struct ggml_context * ctx,
+        struct ggml_tensor  * a,
+        int64_t ne0,
+        int64_t ne1,
+        int64_t ne2);
+
 // Computation
+//
+// A node is split into ggml_get_n_tasks() independent tasks. Each thread runs a
+// range of them with its own scratch buffer of ggml_compute_forward_work_size()
+// bytes. ggml_compute_forward() takes an optional struct ggml_compute_params and
+// runs thread ith's even share of the tasks; with NULL it computes the whole node.
+struct ggml_compute_params {
+    int ith, nth;
+
+    // per-thread work buffer
+    size_t wsize;
+    void * wdata;
+};
+
+int    ggml_get_n_tasks(const struct ggml_tensor * tensor);
+size_t ggml_compute_forward_work_size(const struct ggml_tensor * tensor);
+
 void ggml_compute_forward(struct ggml_tensor * tensor, void * ctx);
+void ggml_compute_forward_range(const struct ggml_compute_params * params, struct ggml_tensor * tensor, int it0, int it1);
+
+// Type conversion
+float       ggml_fp16_to_fp32(ggml_fp16_t x);
+ggml_fp16_t ggml_fp32_to_fp16(float x);
+
+void ggml_fp16_to_fp32_row(const ggml_fp16_t * x, float * y, int n);
+void ggml_fp32_to_fp16_row(const float * x, ggml_fp16_t * y, int n);
+
+// Computation graphs; nodes are stored in dependency order
+struct ggml_cgraph * ggml_new_graph(struct ggml_context * ctx); // size = GGML_DEFAULT_GRAPH_SIZE, no grads
+struct ggml_cgraph * ggml_new_graph_custom(struct ggml_context * ctx, size_t size, bool grads);
+void ggml_graph_clear(struct ggml_cgraph * cgraph);
+
+size_t ggml_graph_overhead(void);
+size_t ggml_graph_overhead_custom(size_t size, bool grads);
+
+int                  ggml_graph_n_nodes(const struct ggml_cgraph * cgraph);
+struct ggml_tensor * ggml_graph_node(const struct ggml_cgraph * cgraph, int i);
+
+void ggml_build_forward_expand(struct ggml_cgraph * cgraph, struct ggml_tensor * tensor);
 
 // Utilities
-size_t ggml_type_size(enum ggml_type type);
+int    ggml_blck_size(enum ggml_type type);
+size_t ggml_type_size(enum ggml_type type);                 // size in bytes of one block
+size_t ggml_row_size (enum ggml_type type, int64_t ne);     // size in bytes of ne elements
 const char * ggml_type_name(enum ggml_type type);
 const char * ggml_op_name(enum ggml_op op);
 bool ggml_is_quantized(enum ggml_type type);
 
+// Quantize n floats of src starting at element start; start and n must be multiples of the row size
+size_t ggml_quantize_chunk(enum ggml_type type, const float * src, void * dst, int start, int n, int64_t * hist);
+
+// Per-type conversion and dot-product kernels
+typedef void (*ggml_to_float_t)  (const void  * x, float * y, int k);
+typedef void (*ggml_from_float_t)(const float * x, void  * y, int k);
+typedef void (*ggml_vec_dot_t)   (int n, float * s, const void * x, const void * y);
+
+typedef struct {
+    const char      * type_name;
+    int               blck_size;
+    size_t            type_size;
+    bool              is_quantized;
+    ggml_to_float_t   to_float;
+    ggml_from_float_t from_float;
+    ggml_from_float_t from_float_reference;
+    ggml_vec_dot_t    vec_dot;
+    enum ggml_type    vec_dot_type;
+} ggml_type_traits_t;
+
+ggml_type_traits_t ggml_internal_get_type_traits(enum ggml_type type);
+
 // For CUDA support
 void ggml_cuda_assign_buffers(struct ggml_tensor * tensor);
 void ggml_cuda_assign_buffers_no_scratch(struct ggml_tensor * tensor);
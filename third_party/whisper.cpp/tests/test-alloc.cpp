@@ -0,0 +1,164 @@
+// Check the graph allocator: intermediates share memory, results match a fully allocated graph
+
+#include "ggml.h"
+#include "ggml-alloc.h"
+#include "ggml-backend.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// encoder-like stack of MLP blocks: x = W2 x ((W1 x x + b1) * g1) + x
+constexpr int n_state  = 64;
+constexpr int n_ff     = 256;
+constexpr int n_ctx    = 150;
+constexpr int n_layers = 6;
+
+struct layer {
+    ggml_tensor * w1;
+    ggml_tensor * b1;
+    ggml_tensor * g1;
+    ggml_tensor * w2;
+};
+
+static void fill(ggml_tensor * t) {
+    const int64_t n = t->ne[0] * t->ne[1] * t->ne[2] * t->ne[3];
+    for (int64_t i = 0; i < n; ++i) {
+        ((float *) t->data)[i] = (rand() / float(RAND_MAX) - 0.5f) * 0.2f;
+    }
+}
+
+static ggml_tensor * build(ggml_context * ctx, const std::vector<layer> & layers, ggml_tensor * x) {
+    for (const layer & l : layers) {
+        ggml_tensor * h = ggml_mul_mat(ctx, l.w1, x);
+        h = ggml_add(ctx, h, l.b1);
+        h = ggml_mul(ctx, h, l.g1);
+        x = ggml_add(ctx, ggml_mul_mat(ctx, l.w2, h), x);
+    }
+    return x;
+}
+
+int main() {
+    srand(3);
+
+    int n_failed = 0;
+
+    // weights live in their own, fully allocated context
+    ggml_init_params wparams = { 16 * 1024 * 1024, nullptr, false };
+    ggml_context * wctx = ggml_init(wparams);
+
+    std::vector<layer> layers(n_layers);
+    for (layer & l : layers) {
+        l.w1 = ggml_new_tensor_2d(wctx, GGML_TYPE_F32, n_state, n_ff);
+        l.b1 = ggml_new_tensor_1d(wctx, GGML_TYPE_F32, n_ff);
+        l.g1 = ggml_new_tensor_1d(wctx, GGML_TYPE_F32, n_ff);
+        l.w2 = ggml_new_tensor_2d(wctx, GGML_TYPE_F32, n_ff, n_state);
+        fill(l.w1);
+        fill(l.b1);
+        fill(l.g1);
+        fill(l.w2);
+    }
+
+    std::vector<float> input(n_state * n_ctx);
+    for (float & v : input) {
+        v = rand() / float(RAND_MAX) - 0.5f;
+    }
+
+    ggml_backend_t backend = ggml_backend_cpu_init();
+    ggml_backend_cpu_set_n_threads(backend, 2);
+
+    // reference: every tensor gets its own memory
+    std::vector<float> ref;
+    size_t total = 0;
+    {
+        ggml_init_params params = { 64 * 1024 * 1024, nullptr, false };
+        ggml_context * ctx = ggml_init(params);
+
+        ggml_tensor * x = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, n_state, n_ctx);
+        std::copy(input.begin(), input.end(), (float *) x->data);
+
+        ggml_tensor * out = build(ctx, layers, x);
+        ggml_cgraph * gf = ggml_new_graph(ctx);
+        ggml_build_forward_expand(gf, out);
+        ggml_backend_graph_compute(backend, gf);
+
+        for (int i = 0; i < ggml_graph_n_nodes(gf); ++i) {
+            total += ggml_nbytes_pad(ggml_graph_node(gf, i));
+        }
+        ref.assign((float *) out->data, (float *) out->data + n_state * n_ctx);
+
+        ggml_free(ctx);
+    }
+
+    // graph contexts only hold tensor metadata
+    const size_t meta_size = 256 * ggml_tensor_overhead() + ggml_graph_overhead();
+
+    // measure
+    size_t measured = 0;
+    {
+        ggml_init_params params = { meta_size, nullptr, true };
+        ggml_context * ctx = ggml_init(params);
+
+        ggml_allocr_t alloc = ggml_allocr_new_measure_from_backend(backend);
+
+        ggml_tensor * x = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, n_state, n_ctx);
+        ggml_allocr_alloc(alloc, x);
+
+        ggml_cgraph * gf = ggml_new_graph(ctx);
+        ggml_build_forward_expand(gf, build(ctx, layers, x));
+        measured = ggml_allocr_alloc_graph(alloc, gf);
+
+        ggml_allocr_free(alloc);
+        ggml_free(ctx);
+    }
+
+    // the peak must stay well below the sum of all intermediates
+    {
+        const bool ok = measured > 0 && measured * 4 < total;
+        printf("  measured %zu bytes, %zu without reuse: %s\n", measured, total, ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    // allocate for real, twice, in a buffer of exactly the measured size
+    ggml_allocr_t alloc = ggml_allocr_new_from_backend(backend, measured);
+    for (int run = 0; run < 2; ++run) {
+        ggml_allocr_reset(alloc);
+
+        ggml_init_params params = { meta_size, nullptr, true };
+        ggml_context * ctx = ggml_init(params);
+
+        ggml_tensor * x = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, n_state, n_ctx);
+        ggml_allocr_alloc(alloc, x);
+        std::copy(input.begin(), input.end(), (float *) x->data);
+
+        ggml_tensor * out = build(ctx, layers, x);
+        ggml_cgraph * gf = ggml_new_graph(ctx);
+        ggml_build_forward_expand(gf, out);
+
+        const size_t size = ggml_allocr_alloc_graph(alloc, gf);
+
+        bool ok = size == measured;
+        for (int i = 0; ok && i < ggml_graph_n_nodes(gf); ++i) {
+            ok = ggml_graph_node(gf, i)->data != nullptr;
+        }
+        ok = ok && ggml_backend_graph_compute(backend, gf);
+        ok = ok && std::vector<float>((float *) out->data, (float *) out->data + n_state * n_ctx) == ref;
+
+        printf("  run %d: %s\n", run, ok ? "ok" : "FAILED");
+        n_failed += !ok;
+
+        ggml_free(ctx);
+    }
+    ggml_allocr_free(alloc);
+
+    ggml_backend_free(backend);
+    ggml_free(wctx);
+
+    if (n_failed > 0) {
+        printf("%d test(s) failed\n", n_failed);
+        return 1;
+    }
+
+    printf("all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,101 @@
+// Check that the CPU backend's thread pool computes graphs exactly as a single thread does
+
+#include "ggml.h"
+#include "ggml-backend.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static float frand() {
+    return rand() / float(RAND_MAX) - 0.5f;
+}
+
+static void fill(ggml_tensor * t) {
+    std::vector<float> v(t->ne[0] * t->ne[1] * t->ne[2] * t->ne[3]);
+    for (auto & x : v) {
+        x = frand();
+    }
+    ggml_quantize_chunk(t->type, v.data(), t->data, 0, (int) v.size(), nullptr);
+}
+
+struct test_graph {
+    ggml_context * ctx;
+    ggml_cgraph  * gf;
+    ggml_tensor  * out;
+};
+
+// out = (W x X + bias) * gain, with uneven tile and row counts
+static test_graph build_graph(ggml_type wtype) {
+    ggml_init_params params = { 32 * 1024 * 1024, nullptr, false };
+    ggml_context * ctx = ggml_init(params);
+
+    ggml_tensor * w    = ggml_new_tensor_2d(ctx, wtype,         320, 200);
+    ggml_tensor * x    = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, 320, 137);
+    ggml_tensor * bias = ggml_new_tensor_1d(ctx, GGML_TYPE_F32, 200);
+    ggml_tensor * gain = ggml_new_tensor_2d(ctx, GGML_TYPE_F32, 200, 137);
+    fill(w);
+    fill(x);
+    fill(bias);
+    fill(gain);
+
+    ggml_tensor * out = ggml_mul(ctx, ggml_add(ctx, ggml_mul_mat(ctx, w, x), bias), gain);
+
+    ggml_cgraph * gf = ggml_new_graph(ctx);
+    ggml_build_forward_expand(gf, out);
+
+    return { ctx, gf, out };
+}
+
+static std::vector<float> output(const test_graph & g) {
+    const float * data = (const float *) g.out->data;
+    return std::vector<float>(data, data + g.out->ne[0] * g.out->ne[1]);
+}
+
+int main() {
+    srand(7);
+
+    int n_failed = 0;
+
+    const ggml_type types[] = { GGML_TYPE_F32, GGML_TYPE_F16, GGML_TYPE_Q4_0 };
+    for (ggml_type wtype : types) {
+        test_graph g = build_graph(wtype);
+
+        if (ggml_graph_n_nodes(g.gf) != 3 || ggml_graph_node(g.gf, -1) != g.out) {
+            printf("  %s: unexpected graph (%d nodes)\n", ggml_type_name(wtype), ggml_graph_n_nodes(g.gf));
+            n_failed++;
+            ggml_free(g.ctx);
+            continue;
+        }
+
+        ggml_backend_t backend = ggml_backend_cpu_init();
+
+        ggml_backend_cpu_set_n_threads(backend, 1);
+        ggml_backend_graph_compute(backend, g.gf);
+        const std::vector<float> ref = output(g);
+
+        // repeated computes reuse the pool; changing the thread count rebuilds it
+        const int thread_counts[] = { 2, 4, 4, 7, 3 };
+        for (int n_threads : thread_counts) {
+            memset(g.out->data, 0, ggml_nbytes(g.out));
+
+            ggml_backend_cpu_set_n_threads(backend, n_threads);
+            const bool ok = ggml_backend_graph_compute(backend, g.gf) && output(g) == ref;
+
+            printf("  %-4s threads=%d: %s\n", ggml_type_name(wtype), n_threads, ok ? "ok" : "FAILED");
+            n_failed += !ok;
+        }
+
+        ggml_backend_free(backend);
+        ggml_free(g.ctx);
+    }
+
+    if (n_failed > 0) {
+        printf("%d test(s) failed\n", n_failed);
+        return 1;
+    }
+
+    printf("all tests passed\n");
+    return 0;
+}
@@ -0,0 +1,511 @@
+// Check the decoder search: the paged K/V cache shares pages between forked
+// sequences and copies them on write, F16 and Q8_0 caches attend as the F32
+// cache does within their precision at a half and about a quarter of its size,
+// greedy, best-of and beam search pick the hypotheses they should on a toy
+// decoder that reads its history back from the cache, the temperature fallback
+// and no-speech exit kick in when they should, and speculative decoding returns
+// what greedy search on the large model does
+
+#include "whisper-decode.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+constexpr int n_vocab = 6;
+constexpr int n_layer = 2;
+constexpr int n_state = 4;
+
+constexpr whisper_token tok_a   = 0;
+constexpr whisper_token tok_b   = 1;
+constexpr whisper_token tok_nosp = 3;
+constexpr whisper_token tok_sot = 4;
+constexpr whisper_token tok_eot = 5;
+
+// After the prompt A is likelier than B. B is almost surely followed by EOT,
+// while after A every token is equally likely, so greedy walks into a long
+// low-probability tail that beam search avoids.
+static void toy_logits(const std::vector<whisper_token> & hist, int n_prompt, float * logits) {
+    for (int i = 0; i < n_vocab; i++) {
+        logits[i] = 0.0f;
+    }
+
+    if ((int) hist.size() < n_prompt) {
+        return; // inside the prompt, unused
+    }
+
+    if ((int) hist.size() == n_prompt) {
+        logits[tok_a]   =   2.0f;
+        logits[tok_b]   =   1.5f;
+        logits[tok_sot] = -10.0f;
+        logits[tok_eot] = -10.0f;
+    } else if (hist[n_prompt] == tok_b) {
+        logits[tok_eot] = 10.0f;
+    }
+}
+
+static double toy_sum_logprob(const std::vector<whisper_token> & prompt, const std::vector<whisper_token> & tokens, bool finished) {
+    std::vector<whisper_token> hist = prompt;
+    std::vector<whisper_token> next = tokens;
+    if (finished) {
+        next.push_back(tok_eot);
+    }
+
+    double sum = 0.0;
+    for (whisper_token token : next) {
+        float logits[n_vocab];
+        toy_logits(hist, (int) prompt.size(), logits);
+
+        double norm = 0.0;
+        for (float l : logits) {
+            norm += std::exp(l);
+        }
+        sum += logits[token] - std::log(norm);
+        hist.push_back(token);
+    }
+
+    return sum;
+}
+
+// Spells out a fixed sentence of n_sentence tokens from A, B and C, then EOT. With
+// wrong_every > 0 every wrong_every-th token is another one, like a draft model
+// that mostly agrees with the large one.
+constexpr int n_sentence = 20;
+
+static void sentence_logits(const std::vector<whisper_token> & hist, int n_prompt, int wrong_every, float * logits) {
+    for (int i = 0; i < n_vocab; i++) {
+        logits[i] = 0.0f;
+    }
+
+    const int i = (int) hist.size() - n_prompt;
+    if (i < 0) {
+        return;
+    }
+
+    whisper_token token = (whisper_token) ((i*i + 1) % 3);
+    if (wrong_every > 0 && i % wrong_every == wrong_every - 1) {
+        token = (token + 1) % 3;
+    }
+    logits[i < n_sentence ? token : tok_eot] = 4.0f;
+}
+
+struct toy_decoder {
+    std::function<void(const std::vector<whisper_token> &, int, float *)> logits_fn = toy_logits;
+
+    int n_prompt  = 0;
+    int n_calls   = 0;
+    int max_batch = 0;
+    int max_pages = 0;
+    bool corrupt  = false;
+
+    float no_speech_logit = 0.0f; // after the prompt
+
+    whisper_decode_step step() {
+        return [this](whisper_kv_pages & kv, const std::vector<whisper_decode_input> & batch, float * logits) {
+            n_calls++;
+            max_batch = std::max(max_batch, (int) batch.size());
+
+            for (size_t i = 0; i < batch.size(); i++) {
+                const whisper_decode_input & in = batch[i];
+                for (int il = 0; il < n_layer; il++) {
+                    for (int j = 0; j < n_state; j++) {
+                        kv.k(in.seq, il, in.pos)[j] = (float) in.token + il + j;
+                        kv.v(in.seq, il, in.pos)[j] = (float) in.token - il - j;
+                    }
+                }
+
+                // the history comes from the cache, so a shared page overwritten by
+                // another sequence changes the logits
+                std::vector<whisper_token> hist;
+                for (int pos = 0; pos <= in.pos; pos++) {
+                    const float token = kv.k(in.seq, 0, pos)[0];
+                    for (int il = 0; il < n_layer; il++) {
+                        for (int j = 0; j < n_state; j++) {
+                            corrupt = corrupt || kv.k(in.seq, il, pos)[j] != token + il + j ||
+                                                 kv.v(in.seq, il, pos)[j] != token - il - j;
+                        }
+                    }
+                    hist.push_back((whisper_token) token);
+                }
+
+                logits_fn(hist, n_prompt, logits + i*n_vocab);
+                if ((int) hist.size() == n_prompt) {
+                    logits[i*n_vocab + tok_nosp] = no_speech_logit;
+                }
+            }
+
+            max_pages = std::max(max_pages, kv.n_pages_used());
+            return true;
+        };
+    }
+};
+
+static bool test_kv_pages() {
+    whisper_kv_pages kv(n_layer, n_state, 4);
+
+    const int a = kv.seq_new();
+    for (int pos = 0; pos < 6; pos++) {
+        kv.seq_push(a);
+        kv.k(a, 1, pos)[0] = (float) pos;
+    }
+
+    // the fork shares both pages; pushing to either copies only the partial one
+    const int b = kv.seq_fork(a);
+    bool ok = kv.n_pages_used() == 2 && kv.seq_len(b) == 6;
+
+    kv.seq_push(b);
+    kv.k(b, 1, 6)[0] = 60.0f;
+    kv.seq_push(a);
+    kv.k(a, 1, 6)[0] = 6.0f;
+
+    ok = ok && kv.n_pages_used() == 3 && kv.n_pages_copied() == 1;
+    for (int pos = 0; pos < 6; pos++) {
+        ok = ok && kv.k(a, 1, pos)[0] == pos && kv.k(b, 1, pos)[0] == pos;
+    }
+    ok = ok && kv.k(a, 1, 6)[0] == 6.0f && kv.k(b, 1, 6)[0] == 60.0f;
+
+    // the full first page stays shared until both sequences are gone
+    kv.seq_free(a);
+    ok = ok && kv.n_pages_used() == 2 && kv.k(b, 1, 3)[0] == 3.0f;
+    kv.seq_free(b);
+    ok = ok && kv.n_pages_used() == 0;
+
+    return ok;
+}
+
+// Attention over rows set through set() against the same computation in floats,
+// before and after forking the sequence
+static bool test_kv_types() {
+    const int n_layer_kv = 2;
+    const int n_state_kv = 64;
+    const int n_head     = 2;
+    const int n_pos      = 10;
+    const int d_head     = n_state_kv / n_head;
+
+    std::vector<float> k(n_pos * n_state_kv), v(n_pos * n_state_kv), q(n_state_kv);
+    for (std::vector<float> * rows : { &k, &v, &q }) {
+        for (float & x : *rows) {
+            x = 2.0f * (rand() / float(RAND_MAX) - 0.5f);
+        }
+    }
+
+    std::vector<float> ref(n_state_kv, 0.0f);
+    for (int h = 0; h < n_head; h++) {
+        std::vector<float> p(n_pos);
+        float sum = 0.0f;
+        for (int pos = 0; pos < n_pos; pos++) {
+            float dot = 0.0f;
+            for (int j = h * d_head; j < (h + 1) * d_head; j++) {
+                dot += q[j] * k[pos * n_state_kv + j];
+            }
+            p[pos] = expf(dot / sqrtf((float) d_head));
+            sum += p[pos];
+        }
+        for (int pos = 0; pos < n_pos; pos++) {
+            for (int j = h * d_head; j < (h + 1) * d_head; j++) {
+                ref[j] += p[pos] / sum * v[pos * n_state_kv + j];
+            }
+        }
+    }
+
+    bool ok = true;
+    size_t n_bytes_f32 = 0;
+    for (const ggml_type type : { GGML_TYPE_F32, GGML_TYPE_F16, GGML_TYPE_Q8_0 }) {
+        whisper_kv_pages kv(n_layer_kv, n_state_kv, 4, type);
+        const int a = kv.seq_new();
+        for (int pos = 0; pos < n_pos; pos++) {
+            kv.seq_push(a);
+            kv.set(a, 1, pos, k.data() + pos * n_state_kv, v.data() + pos * n_state_kv);
+        }
+        const int b = kv.seq_fork(a);
+        kv.seq_push(b); // copies the partial last page
+        kv.seq_truncate(b, n_pos);
+
+        const float tol = type == GGML_TYPE_F32 ? 1e-5f : type == GGML_TYPE_F16 ? 1e-3f : 3e-2f;
+        for (const int seq : { a, b }) {
+            std::vector<float> out(n_state_kv);
+            kv.attend(seq, 1, q.data(), n_head, out.data());
+            for (int j = 0; j < n_state_kv; j++) {
+                ok = ok && std::fabs(out[j] - ref[j]) < tol;
+            }
+        }
+
+        std::vector<float> row(n_state_kv);
+        kv.get_v(b, 1, n_pos - 1, row.data());
+        ok = ok && std::fabs(row[0] - v[(n_pos - 1) * n_state_kv]) < tol;
+
+        if (type == GGML_TYPE_F32) {
+            n_bytes_f32 = kv.n_bytes();
+        }
+        const size_t n_bytes = type == GGML_TYPE_F32 ? n_bytes_f32 : type == GGML_TYPE_F16 ? n_bytes_f32 / 2 : n_bytes_f32 * 34 / 128;
+        ok = ok && kv.type == type && kv.n_bytes() == n_bytes && kv.n_pages_copied() == 1;
+    }
+
+    // Q8_0 rows must be whole blocks
+    ok = ok && whisper_kv_pages(n_layer, n_state, 4, GGML_TYPE_Q8_0).type == GGML_TYPE_F16;
+
+    return ok;
+}
+
+static whisper_search_result run(const whisper_search_params & params, const std::vector<whisper_token> & prompt,
+                                 int page_size, toy_decoder & dec, bool & leaked) {
+    whisper_kv_pages kv(n_layer, n_state, page_size);
+    dec.n_prompt = (int) prompt.size();
+
+    whisper_search_result res = whisper_search(kv, prompt, params, dec.step());
+    leaked = kv.n_pages_used() != 0;
+    return res;
+}
+
+static whisper_search_result run_fallback(const whisper_search_params & params, const whisper_fallback_params & fallback,
+                                          const std::vector<whisper_token> & prompt, toy_decoder & dec, bool & leaked) {
+    whisper_kv_pages kv(n_layer, n_state, 2);
+    dec.n_prompt = (int) prompt.size();
+
+    whisper_search_result res = whisper_search_with_fallback(kv, prompt, params, fallback, dec.step());
+    leaked = kv.n_pages_used() != 0;
+    return res;
+}
+
+static whisper_search_result run_speculative(const whisper_search_params & params, const std::vector<whisper_token> & prompt,
+                                             int n_draft, toy_decoder & dec, toy_decoder & draft, bool & leaked) {
+    whisper_kv_pages kv(n_layer, n_state, 2);
+    whisper_kv_pages kv_draft(n_layer, n_state, 2);
+    dec.n_prompt   = (int) prompt.size();
+    draft.n_prompt = (int) prompt.size();
+
+    whisper_search_result res = whisper_search_speculative(kv, kv_draft, prompt, params, n_draft, dec.step(), draft.step());
+    leaked = kv.n_pages_used() != 0 || kv_draft.n_pages_used() != 0;
+    return res;
+}
+
+static toy_decoder sentence_decoder(int wrong_every) {
+    toy_decoder dec;
+    dec.logits_fn = [wrong_every](const std::vector<whisper_token> & hist, int n_prompt, float * logits) {
+        sentence_logits(hist, n_prompt, wrong_every, logits);
+    };
+    return dec;
+}
+
+int main() {
+    int n_failed = 0;
+
+    {
+        const bool ok = test_kv_pages();
+        printf("  kv pages: %s\n", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    {
+        const bool ok = test_kv_types();
+        printf("  kv cache types: %s\n", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    whisper_search_params params;
+    params.n_vocab    = n_vocab;
+    params.eot        = tok_eot;
+    params.max_tokens = 8;
+
+    const std::vector<whisper_token> prompt = { tok_sot };
+
+    {
+        toy_decoder dec;
+        bool leaked = false;
+        whisper_search_result res = run(params, prompt, 2, dec, leaked);
+
+        // greedy takes A and then never reaches EOT
+        const bool ok = res.ok && !res.finished && res.tokens.size() == 8 && res.tokens[0] == tok_a &&
+                        dec.n_calls == res.n_steps && dec.max_batch == 1 && !dec.corrupt && !leaked &&
+                        std::fabs(res.sum_logprob - toy_sum_logprob(prompt, res.tokens, false)) < 1e-4;
+        printf("  greedy: %s\n", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    {
+        whisper_search_params beam = params;
+        beam.strategy  = WHISPER_SAMPLING_BEAM_SEARCH;
+        beam.beam_size = 2;
+
+        toy_decoder dec;
+        bool leaked = false;
+        whisper_search_result res = run(beam, prompt, 2, dec, leaked);
+
+        // beam search keeps B alive and finds B EOT; the K/V of forked beams stay intact
+        const bool ok = res.ok && res.finished && res.tokens == std::vector<whisper_token>{ tok_b } &&
+                        res.probs.size() == 1 && dec.max_batch == 2 && !dec.corrupt && !leaked &&
+                        std::fabs(res.sum_logprob - toy_sum_logprob(prompt, res.tokens, true)) < 1e-4;
+        printf("  beam search: %s\n", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    {
+        // a long prompt is stored once for all beams
+        whisper_search_params beam = params;
+        beam.strategy  = WHISPER_SAMPLING_BEAM_SEARCH;
+        beam.beam_size = 5;
+
+        std::vector<whisper_token> long_prompt(64, tok_sot);
+        toy_decoder dec;
+        bool leaked = false;
+        whisper_search_result res = run(beam, long_prompt, 16, dec, leaked);
+
+        const int prompt_pages = 64/16;
+        const bool ok = res.ok && res.finished && res.tokens == std::vector<whisper_token>{ tok_b } &&
+                        dec.max_pages <= prompt_pages + beam.beam_size && !dec.corrupt && !leaked;
+        printf("  beam search prefix sharing (%d pages, %d without sharing): %s\n",
+               dec.max_pages, beam.beam_size*(prompt_pages + 1), ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    {
+        whisper_search_params best_of = params;
+        best_of.temperature = 1.0f;
+        best_of.best_of     = 5;
+        best_of.seed        = 42;
+
+        toy_decoder dec1, dec2;
+        bool leaked1 = false, leaked2 = false;
+        whisper_search_result res1 = run(best_of, prompt, 2, dec1, leaked1);
+        whisper_search_result res2 = run(best_of, prompt, 2, dec2, leaked2);
+
+        // sampling is seeded, and all samples of a step go through one call
+        const bool ok = res1.ok && res1.tokens == res2.tokens && res1.tokens.size() == res1.probs.size() &&
+                        dec1.max_batch == 5 && !dec1.corrupt && !leaked1 && !leaked2 &&
+                        (res1.finished || (int) res1.tokens.size() == best_of.max_tokens);
+        printf("  best of: %s\n", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    {
+        // greedy's long tail after A averages below logprob_thold, so the search is
+        // retried at higher temperatures until a sample finds B EOT
+        whisper_search_params sampled = params;
+        sampled.best_of = 5;
+        sampled.seed    = 7;
+
+        toy_decoder dec;
+        bool leaked = false;
+        whisper_search_result res = run_fallback(sampled, whisper_fallback_params(), prompt, dec, leaked);
+
+        const bool ok = res.ok && res.finished && res.tokens == std::vector<whisper_token>{ tok_b } &&
+                        res.n_fallbacks >= 1 && std::fabs(res.temperature - 0.2f*res.n_fallbacks) < 1e-4f &&
+                        res.n_steps == dec.n_calls && res.n_steps > 8 && !dec.corrupt && !leaked;
+        printf("  temperature fallback (accepted at %.1f): %s\n", res.temperature, ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    {
+        // a long run of one token fails the entropy check alone
+        const std::vector<whisper_token> varied = { 0, 1, 2, 3, 4, 5, 0, 1 };
+        const std::vector<whisper_token> repeated(40, tok_a);
+
+        whisper_search_params longer = params;
+        longer.max_tokens = 40;
+
+        whisper_fallback_params fallback;
+        fallback.logprob_thold = -INFINITY;
+
+        toy_decoder dec;
+        bool leaked = false;
+        whisper_search_result res = run_fallback(longer, fallback, prompt, dec, leaked);
+
+        fallback.entropy_thold = 0.0f;
+        toy_decoder dec_once;
+        whisper_search_result once = run_fallback(longer, fallback, prompt, dec_once, leaked);
+
+        const bool ok = whisper_token_entropy(repeated) == 0.0f &&
+                        std::fabs(whisper_token_entropy(varied) - 1.7329f) < 1e-3f &&
+                        res.ok && res.n_fallbacks >= 1 && once.ok && once.n_fallbacks == 0 && !leaked;
+        printf("  entropy check: %s\n", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    {
+        // no speech: the prompt is the only decoder call, even with fallback
+        whisper_search_params nosp = params;
+        nosp.no_speech = tok_nosp;
+
+        toy_decoder dec;
+        dec.no_speech_logit = 5.0f;
+        bool leaked = false;
+        whisper_search_result res = run_fallback(nosp, whisper_fallback_params(), prompt, dec, leaked);
+
+        toy_decoder dec_speech;
+        bool leaked_speech = false;
+        whisper_search_result speech = run(nosp, prompt, 2, dec_speech, leaked_speech);
+
+        const bool ok = res.ok && res.no_speech && res.no_speech_prob > 0.6f && res.tokens.empty() &&
+                        res.n_steps == 1 && dec.n_calls == 1 && res.n_fallbacks == 0 && !leaked &&
+                        speech.ok && !speech.no_speech && speech.no_speech_prob < 0.1f && !speech.tokens.empty() && !leaked_speech;
+        printf("  no speech: %s\n", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    {
+        // a draft that is right four times in five: the large model checks 4 tokens
+        // per step and rejected tokens are dropped from both caches
+        whisper_search_params longer = params;
+        longer.max_tokens = 32;
+
+        toy_decoder dec_greedy = sentence_decoder(0);
+        bool leaked_greedy = false;
+        whisper_search_result greedy = run(longer, prompt, 2, dec_greedy, leaked_greedy);
+
+        toy_decoder dec = sentence_decoder(0);
+        toy_decoder draft = sentence_decoder(5);
+        bool leaked = false;
+        whisper_search_result res = run_speculative(longer, prompt, 4, dec, draft, leaked);
+
+        const bool ok = greedy.ok && greedy.finished && (int) greedy.tokens.size() == n_sentence &&
+                        res.ok && res.finished && res.tokens == greedy.tokens && res.probs == greedy.probs &&
+                        res.sum_logprob == greedy.sum_logprob && res.score == greedy.score &&
+                        res.n_steps == dec.n_calls && 2*res.n_steps <= greedy.n_steps &&
+                        res.n_accepted > 0 && res.n_accepted < res.n_drafted && dec.max_batch == 5 &&
+                        !dec.corrupt && !draft.corrupt && !leaked;
+        printf("  speculative (%d steps, %d without draft, %d/%d drafted tokens accepted): %s\n",
+               res.n_steps, greedy.n_steps, res.n_accepted, res.n_drafted, ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    {
+        // a draft that is always wrong costs steps but not accuracy, also when
+        // max_tokens cuts the sentence
+        toy_decoder dec_greedy = sentence_decoder(0);
+        bool leaked_greedy = false;
+        whisper_search_result greedy = run(params, prompt, 2, dec_greedy, leaked_greedy);
+
+        toy_decoder dec = sentence_decoder(0);
+        toy_decoder draft = sentence_decoder(1);
+        bool leaked = false;
+        whisper_search_result res = run_speculative(params, prompt, 4, dec, draft, leaked);
+
+        // beam search and sampling don't use the draft
+        whisper_search_params beam = params;
+        beam.strategy  = WHISPER_SAMPLING_BEAM_SEARCH;
+        beam.beam_size = 2;
+
+        toy_decoder dec_beam;
+        toy_decoder draft_beam;
+        bool leaked_beam = false;
+        whisper_search_result res_beam = run_speculative(beam, prompt, 4, dec_beam, draft_beam, leaked_beam);
+
+        const bool ok = greedy.ok && !greedy.finished && res.ok && !res.finished && res.tokens == greedy.tokens &&
+                        res.probs == greedy.probs && res.sum_logprob == greedy.sum_logprob &&
+                        res.n_accepted == 0 && res.n_steps == greedy.n_steps && !dec.corrupt && !leaked &&
+                        res_beam.ok && res_beam.tokens == std::vector<whisper_token>{ tok_b } &&
+                        draft_beam.n_calls == 0 && !leaked_beam;
+        printf("  speculative with a wrong draft: %s\n", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    if (n_failed > 0) {
+        printf("%d test(s) failed\n", n_failed);
+        return 1;
+    }
+
+    printf("all tests passed\n");
+    return 0;
+}
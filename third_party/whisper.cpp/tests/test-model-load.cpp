@@ -0,0 +1,419 @@
+// Check model loading: every init path parses the same model, the mmap and buffer
+// paths reference tensor data in place instead of copying it, and the memory usage
+// counts what the model needs, in each K/V cache type. Also check that an encoder output taken from one
+// state decodes the same way in another, that silence and noise are not decoded,
+// and that the acoustic confidence of segments follows the audio.
+
+#include "whisper.h"
+#include "ggml.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <fstream>
+#include <string>
+#include <vector>
+
+constexpr int n_state      = 64;
+constexpr int n_vocab      = 51865;
+constexpr int n_vocab_text = 100;
+constexpr int sample_rate  = 16000;
+
+struct test_tensor {
+    std::string name;
+    ggml_type   type;
+    int64_t     ne[2];
+    std::vector<uint8_t> data;
+    size_t      offs; // of the data in the model file
+};
+
+static void write_i32(std::vector<uint8_t> & buf, int32_t v) {
+    const uint8_t * p = reinterpret_cast<const uint8_t *>(&v);
+    buf.insert(buf.end(), p, p + sizeof(v));
+}
+
+static std::vector<uint8_t> make_model(std::vector<test_tensor> & tensors) {
+    std::vector<uint8_t> buf;
+
+    write_i32(buf, 0x67676d6c);
+    for (int32_t v : { n_vocab, 1500, n_state, 1, 1, 448, n_state, 1, 1, 80, 1 }) {
+        write_i32(buf, v);
+    }
+
+    write_i32(buf, 80);
+    write_i32(buf, 201);
+    buf.resize(buf.size() + 80 * 201 * sizeof(float));
+
+    write_i32(buf, n_vocab_text);
+    for (int i = 0; i < n_vocab_text; i++) {
+        const std::string word = "tok" + std::to_string(i);
+        write_i32(buf, (int32_t) word.size());
+        buf.insert(buf.end(), word.begin(), word.end());
+    }
+
+    for (test_tensor & t : tensors) {
+        std::vector<float> values(t.ne[0] * t.ne[1]);
+        for (float & v : values) {
+            v = rand() / float(RAND_MAX) - 0.5f;
+        }
+
+        t.data.resize(ggml_row_size(t.type, t.ne[0]) * t.ne[1]);
+        if (t.type == GGML_TYPE_F32) {
+            memcpy(t.data.data(), values.data(), t.data.size());
+        } else if (t.type == GGML_TYPE_F16) {
+            ggml_fp32_to_fp16_row(values.data(), (ggml_fp16_t *) t.data.data(), (int) values.size());
+        } else {
+            ggml_quantize_chunk(t.type, values.data(), t.data.data(), 0, (int) values.size(), nullptr);
+        }
+
+        write_i32(buf, t.ne[1] > 1 ? 2 : 1);
+        write_i32(buf, (int32_t) t.name.size());
+        write_i32(buf, (int32_t) t.type);
+        write_i32(buf, (int32_t) t.ne[0]);
+        if (t.ne[1] > 1) {
+            write_i32(buf, (int32_t) t.ne[1]);
+        }
+        buf.insert(buf.end(), t.name.begin(), t.name.end());
+
+        t.offs = buf.size();
+        buf.insert(buf.end(), t.data.begin(), t.data.end());
+    }
+
+    return buf;
+}
+
+// hparams, vocab and tensors match what make_model wrote; with zero_copy the tensors
+// must sit at the same relative offsets as in the file
+static bool check_model(whisper_context * ctx, const std::vector<test_tensor> & tensors, bool zero_copy) {
+    if (!ctx) {
+        return false;
+    }
+
+    bool ok = whisper_model_n_vocab(ctx) == n_vocab &&
+              whisper_model_n_audio_state(ctx) == n_state &&
+              whisper_model_n_text_layer(ctx) == 1 &&
+              whisper_is_multilingual(ctx) &&
+              whisper_token_eot(ctx) == 50257 &&
+              whisper_token_beg(ctx) == 50364 &&
+              strcmp(whisper_token_to_str(ctx, 42), "tok42") == 0;
+
+    const uint8_t * base = nullptr;
+    for (const test_tensor & t : tensors) {
+        const ggml_tensor * tensor = whisper_model_get_tensor(ctx, t.name.c_str());
+        if (!tensor || tensor->type != t.type || tensor->ne[0] != t.ne[0] || tensor->ne[1] != t.ne[1]) {
+            return false;
+        }
+        ok = ok && memcmp(tensor->data, t.data.data(), t.data.size()) == 0;
+
+        const uint8_t * data = (const uint8_t *) tensor->data;
+        if (zero_copy) {
+            if (!base) {
+                base = data - t.offs;
+            }
+            ok = ok && data == base + t.offs;
+        }
+    }
+
+    return ok && whisper_model_get_tensor(ctx, "missing") == nullptr;
+}
+
+// The weights are the tensor data of the file; the K/V caches follow the hparams;
+// the compute buffers hold the largest activation, the attention scores of the
+// encoder and the logits of the decoder prompt, but not two of them at once
+static bool check_memory_usage(whisper_context * ctx, const std::vector<test_tensor> & tensors) {
+    const whisper_memory_usage usage = whisper_get_memory_usage(ctx);
+
+    size_t weights = 0;
+    for (const test_tensor & t : tensors) {
+        weights += t.data.size();
+    }
+
+    const size_t kq     = sizeof(float) * 1500 * 1500;
+    const size_t logits = sizeof(float) * n_vocab * 224;
+
+    return usage.weights == weights &&
+           usage.kv_self  == 2 * sizeof(float) * 448  * n_state &&
+           usage.kv_cross == 2 * sizeof(float) * 1500 * n_state &&
+           usage.mel      == sizeof(float) * 80 * 3000 &&
+           usage.compute_encoder >= kq     && usage.compute_encoder < 2 * kq &&
+           usage.compute_decoder >= logits && usage.compute_decoder < 2 * logits;
+}
+
+// An F16 K/V cache takes half the memory of the default F32 one, Q8_0 34 bytes
+// per 32 values; other types are rejected
+static bool check_kv_types(whisper_context * ctx, std::vector<uint8_t> & model) {
+    const whisper_memory_usage f32 = whisper_get_memory_usage(ctx);
+
+    bool ok = true;
+    for (const ggml_type type : { GGML_TYPE_F16, GGML_TYPE_Q8_0, GGML_TYPE_Q4_0 }) {
+        whisper_context_params params = whisper_context_default_params();
+        params.type_kv = type;
+
+        whisper_context * kv_ctx = whisper_init_from_buffer_with_params(model.data(), model.size(), params);
+        if (type == GGML_TYPE_Q4_0) {
+            ok = ok && kv_ctx == nullptr;
+            continue;
+        }
+
+        const whisper_memory_usage usage = whisper_get_memory_usage(kv_ctx);
+        const size_t num = type == GGML_TYPE_F16 ? 64 : 34;
+        ok = ok && kv_ctx && usage.kv_self == f32.kv_self * num / 128 && usage.kv_cross == f32.kv_cross * num / 128 &&
+             usage.weights == f32.weights && usage.compute_decoder == f32.compute_decoder;
+        whisper_free(kv_ctx);
+    }
+
+    return ok;
+}
+
+// The encoder output of one state, set on a fresh state, decodes to the same
+// segments without running the encoder again
+static bool check_encoder_output(whisper_context * ctx) {
+    std::vector<float> pcm(sample_rate);
+    for (size_t i = 0; i < pcm.size(); i++) {
+        pcm[i] = 0.5f * sinf(2.0f * 3.14159265f * 440.0f * i / sample_rate);
+    }
+
+    int n_encoder_begin = 0;
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.encoder_begin_callback = [](whisper_context *, whisper_state *, void * user_data) {
+        (*(int *) user_data)++;
+        return true;
+    };
+    params.encoder_begin_callback_user_data = &n_encoder_begin;
+
+    whisper_state * s0 = whisper_init_state(ctx);
+    whisper_state * s1 = whisper_init_state(ctx);
+
+    size_t n_floats = 0;
+    bool ok = whisper_get_encoder_output_from_state(s0, &n_floats) == nullptr && n_floats == 0 &&
+              whisper_full_decode_with_state(ctx, s0, params) != 0;
+
+    ok = ok && whisper_full_with_state(ctx, s0, params, pcm.data(), (int) pcm.size()) == 0;
+    const float * out = whisper_get_encoder_output_from_state(s0, &n_floats);
+    ok = ok && out && n_floats > 0;
+
+    if (ok) {
+        const std::vector<float> cached(out, out + n_floats);
+        ok = whisper_set_encoder_output_with_state(ctx, s1, cached.data(), cached.size(), (int) pcm.size()) == 0 &&
+             whisper_full_decode_with_state(ctx, s1, params) == 0 &&
+             n_encoder_begin == 1 &&
+             whisper_full_n_segments_from_state(s1) == whisper_full_n_segments_from_state(s0) &&
+             whisper_full_get_segment_t1_from_state(s1, 0) == whisper_full_get_segment_t1_from_state(s0, 0) &&
+             strcmp(whisper_full_get_segment_text_from_state(s1, 0), whisper_full_get_segment_text_from_state(s0, 0)) == 0;
+    }
+
+    whisper_free_state(s0);
+    whisper_free_state(s1);
+
+    return ok;
+}
+
+// Silence and white noise end without segments unless no_speech_thold allows them
+static bool check_no_speech(whisper_context * ctx) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+
+    std::vector<float> silence(sample_rate, 0.0f);
+    std::vector<float> noise(sample_rate);
+    std::vector<float> tone(sample_rate);
+    for (size_t i = 0; i < noise.size(); i++) {
+        noise[i] = dist(rng);
+        tone[i]  = 0.5f * sinf(2.0f * 3.14159265f * 440.0f * i / sample_rate) + 0.05f * dist(rng);
+    }
+
+    whisper_state * state = whisper_init_state(ctx);
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+
+    auto n_segments = [&](const std::vector<float> & pcm) {
+        if (whisper_full_with_state(ctx, state, params, pcm.data(), (int) pcm.size()) != 0) {
+            return -1;
+        }
+        return whisper_full_n_segments_from_state(state);
+    };
+
+    bool ok = n_segments(silence) == 0 && n_segments(noise) == 0 && n_segments(tone) == 1;
+
+    params.no_speech_thold = 1.0f;
+    ok = ok && n_segments(silence) == 1 && n_segments(noise) == 1;
+
+    whisper_free_state(state);
+
+    return ok;
+}
+
+// The acoustic confidence of a tone is high and that of noise low, while the mock
+// decoder's tokens carry no probability of their own; tokens over the tone skip
+// the pause after it, and token data, probabilities and text agree with the segment
+static bool check_confidence(whisper_context * ctx) {
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> dist(-0.5f, 0.5f);
+
+    std::vector<float> tone(2 * sample_rate, 0.0f);
+    std::vector<float> noise(2 * sample_rate);
+    for (size_t i = 0; i < noise.size(); i++) {
+        if (i < (size_t) sample_rate) {
+            tone[i] = 0.5f * sinf(2.0f * 3.14159265f * 440.0f * i / sample_rate);
+        }
+        noise[i] = dist(rng);
+    }
+
+    whisper_state * state = whisper_init_state(ctx);
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.no_speech_thold = 1.0f;
+
+    // decode pcm and collect its acoustic confidence and the last token end
+    auto decode = [&](const std::vector<float> & pcm, float & confidence, int64_t & t1_max) {
+        confidence = -1.0f;
+        if (whisper_full_with_state(ctx, state, params, pcm.data(), (int) pcm.size()) != 0 ||
+            whisper_full_n_segments_from_state(state) != 1) {
+            return false;
+        }
+
+        const int n_tokens = whisper_full_n_tokens_from_state(state, 0);
+        std::string text;
+        t1_max = 0;
+        for (int i = 0; i < n_tokens; i++) {
+            const whisper_token_data data = whisper_full_get_token_data_from_state(state, 0, i);
+            const float p = whisper_full_get_token_p_from_state(state, 0, i);
+            if (p != 1.0f || data.p != p || data.plog != 0.0f ||
+                data.id != whisper_full_get_token_id_from_state(state, 0, i) || data.t0 >= data.t1) {
+                return false;
+            }
+            t1_max = std::max(t1_max, data.t1);
+            text += whisper_full_get_token_text_from_state(ctx, state, 0, i);
+        }
+
+        confidence = whisper_full_get_segment_acoustic_confidence_from_state(state, 0);
+        return n_tokens > 2 && text == whisper_full_get_segment_text_from_state(state, 0) &&
+               whisper_full_get_token_p_from_state(state, 0, n_tokens) == 0.0f &&
+               whisper_full_get_segment_acoustic_confidence_from_state(state, 1) == 0.0f;
+    };
+
+    float confidence;
+    int64_t t1_max;
+    bool ok = decode(tone, confidence, t1_max) && confidence > 0.9f && t1_max < 105; // the tone ends at frame 100, plus the FFT window
+    ok = ok && decode(noise, confidence, t1_max) && confidence < 0.5f;
+
+    whisper_free_state(state);
+
+    return ok;
+}
+
+struct counting_loader {
+    std::ifstream fin;
+    int n_close = 0;
+};
+
+int main() {
+    srand(5);
+
+    int n_failed = 0;
+
+    std::vector<test_tensor> tensors = {
+        { "encoder.conv1.bias",                 GGML_TYPE_F32,  { n_state, 1 },           {}, 0 },
+        { "encoder.blocks.0.attn.query.weight", GGML_TYPE_F16,  { n_state, n_state },     {}, 0 },
+        { "decoder.blocks.0.mlp.0.weight",      GGML_TYPE_Q8_0, { n_state, 4 * n_state }, {}, 0 },
+        { "decoder.ln.weight",                  GGML_TYPE_F32,  { 3, 5 },                 {}, 0 },
+    };
+    std::vector<uint8_t> model = make_model(tensors);
+
+    const std::string path = (std::filesystem::temp_directory_path() / "whisper-test-model.bin").string();
+    {
+        std::ofstream fout(path, std::ios::binary);
+        fout.write((const char *) model.data(), model.size());
+    }
+
+    {
+        whisper_context * ctx = whisper_init_from_buffer(model.data(), model.size());
+        bool ok = check_model(ctx, tensors, true);
+        const ggml_tensor * t = ctx ? whisper_model_get_tensor(ctx, tensors[0].name.c_str()) : nullptr;
+        ok = ok && t && t->data == model.data() + tensors[0].offs;
+        printf("  buffer: %s\n", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+
+        const bool ok_memory = ctx && check_memory_usage(ctx, tensors);
+        printf("  memory usage: %s\n", ok_memory ? "ok" : "FAILED");
+        n_failed += !ok_memory;
+
+        const bool ok_kv = ctx && check_kv_types(ctx, model);
+        printf("  kv cache types: %s\n", ok_kv ? "ok" : "FAILED");
+        n_failed += !ok_kv;
+
+        const bool ok_encoder = ctx && check_encoder_output(ctx);
+        printf("  encoder output reuse: %s\n", ok_encoder ? "ok" : "FAILED");
+        n_failed += !ok_encoder;
+
+        const bool ok_no_speech = ctx && check_no_speech(ctx);
+        printf("  no speech: %s\n", ok_no_speech ? "ok" : "FAILED");
+        n_failed += !ok_no_speech;
+
+        const bool ok_confidence = ctx && check_confidence(ctx);
+        printf("  acoustic confidence: %s\n", ok_confidence ? "ok" : "FAILED");
+        n_failed += !ok_confidence;
+        whisper_free(ctx);
+    }
+
+    for (const bool use_mmap : { true, false }) {
+        whisper_context_params params = whisper_context_default_params();
+        params.use_mmap = use_mmap;
+
+        whisper_context * ctx = whisper_init_from_file_with_params(path.c_str(), params);
+        const bool ok = check_model(ctx, tensors, use_mmap);
+        printf("  file (%s): %s\n", use_mmap ? "mmap" : "read", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+        whisper_free(ctx);
+    }
+
+    {
+        counting_loader cl;
+        cl.fin.open(path, std::ios::binary);
+
+        whisper_model_loader loader = {};
+        loader.context = &cl;
+        loader.read = [](void * ctx, void * output, size_t read_size) {
+            auto * cl = (counting_loader *) ctx;
+            cl->fin.read((char *) output, read_size);
+            return (size_t) cl->fin.gcount();
+        };
+        loader.eof = [](void * ctx) {
+            return ((counting_loader *) ctx)->fin.eof();
+        };
+        loader.close = [](void * ctx) {
+            ((counting_loader *) ctx)->n_close++;
+        };
+
+        whisper_context * ctx = whisper_init_from_loader_with_params(&loader, whisper_context_default_params());
+        const bool ok = check_model(ctx, tensors, false) && cl.n_close == 1;
+        printf("  loader: %s\n", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+        whisper_free(ctx);
+    }
+
+    {
+        std::vector<uint8_t> bad_magic = model;
+        bad_magic[0] ^= 1;
+        std::vector<uint8_t> bad_type = model;
+        bad_type[tensors[0].offs - tensors[0].name.size() - 2 * sizeof(int32_t)] = 99;
+
+        const bool ok = whisper_init_from_buffer(bad_magic.data(), bad_magic.size()) == nullptr &&
+                        whisper_init_from_buffer(bad_type.data(), bad_type.size()) == nullptr &&
+                        whisper_init_from_buffer(model.data(), model.size() - 10) == nullptr &&
+                        whisper_init_from_buffer(model.data(), 100) == nullptr &&
+                        whisper_init_from_file("/nonexistent/ggml-model.bin") == nullptr;
+        printf("  invalid models: %s\n", ok ? "ok" : "FAILED");
+        n_failed += !ok;
+    }
+
+    std::filesystem::remove(path);
+
+    if (n_failed > 0) {
+        printf("%d test(s) failed\n", n_failed);
+        return 1;
+    }
+
+    printf("all tests passed\n");
+    return 0;
+}
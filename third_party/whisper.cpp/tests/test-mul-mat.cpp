@@ -0,0 +1,164 @@
+// Validate GGML_OP_MUL_MAT against a naive double-precision reference
+
+#include "ggml.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+struct test_case {
+    ggml_type type0;
+    ggml_type type1;
+    int64_t K, M, N;
+    int64_t ne02, ne12; // src0 is broadcast over src1's batches
+    int n_threads;
+};
+
+static float frand() {
+    return rand() / float(RAND_MAX) - 0.5f;
+}
+
+static void fill(ggml_tensor * t) {
+    const int64_t n = t->ne[0] * t->ne[1] * t->ne[2] * t->ne[3];
+    if (ggml_is_quantized(t->type)) {
+        std::vector<float> src(n);
+        for (auto & x : src) {
+            x = frand();
+        }
+        ggml_quantize_chunk(t->type, src.data(), t->data, 0, (int) n, nullptr);
+        return;
+    }
+    for (int64_t i = 0; i < n; ++i) {
+        if (t->type == GGML_TYPE_F16) {
+            ((ggml_fp16_t *) t->data)[i] = ggml_fp32_to_fp16(frand());
+        } else {
+            ((float *) t->data)[i] = frand();
+        }
+    }
+}
+
+// the values the kernels actually see, as a dense [ne2][ne1][ne0] array
+static std::vector<double> values(const ggml_tensor * t) {
+    const int64_t ne0 = t->ne[0];
+    std::vector<double> out(ne0 * t->ne[1] * t->ne[2]);
+    std::vector<float> row(ne0);
+    for (int64_t i2 = 0; i2 < t->ne[2]; ++i2) {
+        for (int64_t i1 = 0; i1 < t->ne[1]; ++i1) {
+            const char * p = (const char *) t->data + i1*t->nb[1] + i2*t->nb[2];
+            if (t->type == GGML_TYPE_F32) {
+                memcpy(row.data(), p, ne0*sizeof(float));
+            } else {
+                ggml_internal_get_type_traits(t->type).to_float(p, row.data(), (int) ne0);
+            }
+            std::copy(row.begin(), row.end(), out.begin() + (i2*t->ne[1] + i1)*ne0);
+        }
+    }
+    return out;
+}
+
+static bool run(const test_case & tc) {
+    const size_t mem_size = 64 * 1024 * 1024;
+    ggml_init_params params = { mem_size, nullptr, false };
+    ggml_context * ctx = ggml_init(params);
+
+    ggml_tensor * a = ggml_new_tensor_3d(ctx, tc.type0, tc.K, tc.M, tc.ne02);
+    ggml_tensor * b = ggml_new_tensor_3d(ctx, tc.type1, tc.K, tc.N, tc.ne12);
+    fill(a);
+    fill(b);
+
+    ggml_tensor * c = ggml_mul_mat(ctx, a, b);
+    if (!c || c->type != GGML_TYPE_F32 || c->ne[0] != tc.M || c->ne[1] != tc.N || c->ne[2] != tc.ne12) {
+        printf("  bad result shape\n");
+        ggml_free(ctx);
+        return false;
+    }
+
+    // run the node as n_threads workers would, one share at a time
+    const size_t wsize = ggml_compute_forward_work_size(c);
+    std::vector<uint8_t> wdata(wsize);
+    for (int ith = 0; ith < tc.n_threads; ++ith) {
+        ggml_compute_params cparams = { ith, tc.n_threads, wsize, wdata.data() };
+        ggml_compute_forward(c, &cparams);
+    }
+
+    const std::vector<double> va = values(a);
+    const std::vector<double> vb = values(b);
+    const std::vector<double> vc = values(c);
+
+    double max_err = 0.0;
+    const int64_t r2 = tc.ne12 / tc.ne02;
+    for (int64_t i2 = 0; i2 < tc.ne12; ++i2) {
+        for (int64_t n = 0; n < tc.N; ++n) {
+            for (int64_t m = 0; m < tc.M; ++m) {
+                const double * x = &va[((i2 / r2)*tc.M + m)*tc.K];
+                const double * y = &vb[(i2*tc.N + n)*tc.K];
+                double ref = 0.0;
+                double mag = 0.0;
+                for (int64_t k = 0; k < tc.K; ++k) {
+                    ref += x[k] * y[k];
+                    mag += std::fabs(x[k] * y[k]);
+                }
+                const double err = std::fabs(vc[(i2*tc.N + n)*tc.M + m] - ref) / (mag + 1e-6);
+                max_err = std::max(max_err, err);
+            }
+        }
+    }
+
+    ggml_free(ctx);
+
+    // quantized weights are multiplied against src1 rounded to 8 bits
+    const bool ok = max_err < (ggml_is_quantized(tc.type0) ? 1e-2 : 1e-5);
+    printf("  %s x %s K=%4lld M=%3lld N=%3lld batch=%lld/%lld threads=%d: max rel err %.2e %s\n",
+           ggml_type_name(tc.type0), ggml_type_name(tc.type1),
+           (long long) tc.K, (long long) tc.M, (long long) tc.N, (long long) tc.ne02, (long long) tc.ne12,
+           tc.n_threads, max_err, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main() {
+    const test_case cases[] = {
+        // exact multiples of the micro-kernel and tile sizes
+        { GGML_TYPE_F32, GGML_TYPE_F32,  256,  64,  64, 1, 1, 1 },
+        // ragged edges in every dimension, K spanning several K-blocks
+        { GGML_TYPE_F32, GGML_TYPE_F32,  601,  67,  33, 1, 1, 1 },
+        { GGML_TYPE_F32, GGML_TYPE_F32,   19,   5,   3, 1, 1, 1 },
+        { GGML_TYPE_F32, GGML_TYPE_F32,    1,   1,   1, 1, 1, 1 },
+        // matrix x vector, as in the decoder
+        { GGML_TYPE_F32, GGML_TYPE_F32,  384, 130,   1, 1, 1, 1 },
+        // F16 weights / F16 activations
+        { GGML_TYPE_F16, GGML_TYPE_F32,  520, 129,  70, 1, 1, 1 },
+        { GGML_TYPE_F16, GGML_TYPE_F16,   77,  31,  17, 1, 1, 1 },
+        // batched and broadcast
+        { GGML_TYPE_F32, GGML_TYPE_F32,   64,  40,  24, 3, 3, 1 },
+        { GGML_TYPE_F16, GGML_TYPE_F32,   96,  40,  24, 1, 4, 1 },
+        // split across threads
+        { GGML_TYPE_F32, GGML_TYPE_F32,  300, 200, 150, 1, 1, 3 },
+        { GGML_TYPE_F16, GGML_TYPE_F32,  300, 200, 150, 2, 4, 7 },
+        // quantized weights
+        { GGML_TYPE_Q4_0, GGML_TYPE_F32,  256,  70,  65, 1, 1, 1 },
+        { GGML_TYPE_Q4_1, GGML_TYPE_F32,   96,  33,   5, 1, 1, 1 },
+        { GGML_TYPE_Q5_0, GGML_TYPE_F16,  160,  64,   1, 1, 1, 1 },
+        { GGML_TYPE_Q5_1, GGML_TYPE_F32,   64,  17, 130, 1, 2, 1 },
+        { GGML_TYPE_Q8_0, GGML_TYPE_F32,  384, 130,  70, 2, 4, 3 },
+    };
+
+    srand(42);
+
+    int n_failed = 0;
+    for (const auto & tc : cases) {
+        if (!run(tc)) {
+            n_failed++;
+        }
+    }
+
+    if (n_failed > 0) {
+        printf("%d test(s) failed\n", n_failed);
+        return 1;
+    }
+
+    printf("all tests passed\n");
+    return 0;
+}
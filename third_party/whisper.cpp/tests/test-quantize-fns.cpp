@@ -0,0 +1,166 @@
+// Unit tests for quantization specific functions - quantize, dequantize and dot product
+
+#include "ggml.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+constexpr float MAX_QUANTIZATION_REFERENCE_ERROR = 0.0001f;
+constexpr float MAX_QUANTIZATION_TOTAL_ERROR     = 0.002f;
+constexpr float MAX_DOT_PRODUCT_ERROR            = 0.02f;
+
+static const char * RESULT_STR[] = { "ok", "FAILED" };
+
+// Generate synthetic data
+static void generate_data(float offset, size_t n, float * dst) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = 0.1f + 2*cosf(i + offset);
+    }
+}
+
+// Calculate RMSE between two float arrays
+static float array_rmse(const float * a1, const float * a2, size_t n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        const double diff = a1[i] - a2[i];
+        sum += diff * diff;
+    }
+    return sqrtf(sum) / n;
+}
+
+// Total quantization error on test data
+static float total_quantization_error(const ggml_type_traits_t & qfns, size_t n, const float * test_data) {
+    std::vector<uint8_t> tmp_q(2*n);
+    std::vector<float> tmp_out(n);
+
+    qfns.from_float(test_data, tmp_q.data(), n);
+    qfns.to_float(tmp_q.data(), tmp_out.data(), n);
+    return array_rmse(test_data, tmp_out.data(), n);
+}
+
+// Total quantization error on test data, reference against the (possibly vectorized) version
+static float reference_quantization_error(const ggml_type_traits_t & qfns, size_t n, const float * test_data) {
+    std::vector<uint8_t> tmp_q(2*n);
+    std::vector<float> tmp_out(n);
+    std::vector<float> tmp_out_ref(n);
+
+    qfns.from_float(test_data, tmp_q.data(), n);
+    qfns.to_float(tmp_q.data(), tmp_out.data(), n);
+
+    qfns.from_float_reference(test_data, tmp_q.data(), n);
+    qfns.to_float(tmp_q.data(), tmp_out_ref.data(), n);
+
+    return array_rmse(tmp_out.data(), tmp_out_ref.data(), n);
+}
+
+static float dot_product(const float * a1, const float * a2, size_t n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += a1[i] * a2[i];
+    }
+    return sum;
+}
+
+// Error of the fused quantized dot product against the f32 dot product
+static float dot_product_error(const ggml_type_traits_t & qfns, size_t n, const float * test_data1, const float * test_data2) {
+    std::vector<uint8_t> tmp_q1(2*n);
+    std::vector<uint8_t> tmp_q2(2*n);
+
+    const auto vdot = ggml_internal_get_type_traits(qfns.vec_dot_type);
+
+    qfns.from_float(test_data1, tmp_q1.data(), n);
+    vdot.from_float(test_data2, tmp_q2.data(), n);
+
+    float result = INFINITY;
+    qfns.vec_dot(n, &result, tmp_q1.data(), tmp_q2.data());
+
+    const float dot_ref = dot_product(test_data1, test_data2, n);
+
+    return fabsf(result - dot_ref) / n;
+}
+
+// The histogram returned by ggml_quantize_chunk must account for every value
+static bool histogram_complete(ggml_type type, size_t n, const float * test_data) {
+    std::vector<uint8_t> tmp_q(2*n);
+    int64_t hist[16] = { 0 };
+
+    const size_t size = ggml_quantize_chunk(type, test_data, tmp_q.data(), 0, n, hist);
+
+    int64_t total = 0;
+    for (int64_t h : hist) {
+        total += h;
+    }
+    return total == (int64_t) n && size == ggml_row_size(type, n);
+}
+
+int main(int argc, char * argv[]) {
+    bool verbose = false;
+    const size_t test_size = 32 * 128;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-v") {
+            verbose = true;
+        } else {
+            fprintf(stderr, "error: unknown argument: %s\n", arg.c_str());
+            return 1;
+        }
+    }
+
+    std::vector<float> test_data(test_size);
+    std::vector<float> test_data2(test_size);
+
+    generate_data(0.0, test_data.size(), test_data.data());
+    generate_data(1.0, test_data2.size(), test_data2.data());
+
+    int num_failed = 0;
+    bool failed = false;
+
+    for (int i = 0; i < GGML_TYPE_COUNT; i++) {
+        const ggml_type type = (ggml_type) i;
+        const ggml_type_traits_t qfns = ggml_internal_get_type_traits(type);
+
+        // only types with a full set of kernels
+        if (!qfns.is_quantized || !qfns.from_float || !qfns.to_float || !qfns.vec_dot) {
+            continue;
+        }
+
+        printf("Testing %s\n", ggml_type_name(type));
+
+        const float total_error = total_quantization_error(qfns, test_size, test_data.data());
+        failed = !(total_error < MAX_QUANTIZATION_TOTAL_ERROR);
+        num_failed += failed;
+        if (failed || verbose) {
+            printf("%5s absolute quantization error:    %s (%f)\n", ggml_type_name(type), RESULT_STR[failed], total_error);
+        }
+
+        const float reference_error = reference_quantization_error(qfns, test_size, test_data.data());
+        failed = !(reference_error < MAX_QUANTIZATION_REFERENCE_ERROR);
+        num_failed += failed;
+        if (failed || verbose) {
+            printf("%5s reference implementation error: %s (%f)\n", ggml_type_name(type), RESULT_STR[failed], reference_error);
+        }
+
+        const float vec_dot_error = dot_product_error(qfns, test_size, test_data.data(), test_data2.data());
+        failed = !(vec_dot_error < MAX_DOT_PRODUCT_ERROR);
+        num_failed += failed;
+        if (failed || verbose) {
+            printf("%5s dot product error:              %s (%f)\n", ggml_type_name(type), RESULT_STR[failed], vec_dot_error);
+        }
+
+        failed = !histogram_complete(type, test_size, test_data.data());
+        num_failed += failed;
+        if (failed || verbose) {
+            printf("%5s quantization histogram:         %s\n", ggml_type_name(type), RESULT_STR[failed]);
+        }
+    }
+
+    if (num_failed || verbose) {
+        printf("%d tests failed\n", num_failed);
+    }
+
+    return num_failed > 0;
+}
@@ -0,0 +1,755 @@
+#include "whisper-decode.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <random>
+
+//
+// whisper_kv_pages
+//
+
+static ggml_type whisper_kv_storage_type(ggml_type type, int n_state) {
+    switch (type) {
+        case GGML_TYPE_F16:  return GGML_TYPE_F16;
+        case GGML_TYPE_Q8_0: return n_state % ggml_blck_size(GGML_TYPE_Q8_0) == 0 ? GGML_TYPE_Q8_0 : GGML_TYPE_F16;
+        default:             return GGML_TYPE_F32;
+    }
+}
+
+whisper_kv_pages::whisper_kv_pages(int n_layer, int n_state, int page_size, ggml_type type)
+    : n_layer(n_layer), n_state(n_state), page_size(std::max(1, page_size)),
+      type(whisper_kv_storage_type(type, n_state)), row_size(ggml_row_size(this->type, n_state)) {
+}
+
+int whisper_kv_pages::seq_new() {
+    int seq;
+    if (!free_seqs.empty()) {
+        seq = free_seqs.back();
+        free_seqs.pop_back();
+    } else {
+        seq = (int) seqs.size();
+        seqs.emplace_back();
+    }
+
+    seqs[seq].pages.clear();
+    seqs[seq].n_pos = 0;
+    seqs[seq].used  = true;
+
+    return seq;
+}
+
+int whisper_kv_pages::seq_fork(int src) {
+    const int seq = seq_new(); // may move seqs
+
+    seqs[seq].pages = seqs[src].pages;
+    seqs[seq].n_pos = seqs[src].n_pos;
+    for (int page : seqs[seq].pages) {
+        page_ref[page]++;
+    }
+
+    return seq;
+}
+
+void whisper_kv_pages::seq_free(int seq) {
+    for (int page : seqs[seq].pages) {
+        page_release(page);
+    }
+    seqs[seq].pages.clear();
+    seqs[seq].n_pos = 0;
+    seqs[seq].used  = false;
+    free_seqs.push_back(seq);
+}
+
+int whisper_kv_pages::seq_len(int seq) const {
+    return seqs[seq].n_pos;
+}
+
+int whisper_kv_pages::seq_push(int seq) {
+    const int slot = seqs[seq].n_pos % page_size;
+
+    if (slot == 0) {
+        const int page = page_alloc();
+        seqs[seq].pages.push_back(page);
+    } else if (page_ref[seqs[seq].pages.back()] > 1) {
+        // copy on write: this sequence gets its own copy of the partially filled page
+        const int src = seqs[seq].pages.back();
+        const int dst = page_alloc();
+
+        for (int il = 0; il < n_layer; il++) {
+            const size_t offs_src = ((size_t) src*n_layer + il)*page_size*row_size;
+            const size_t offs_dst = ((size_t) dst*n_layer + il)*page_size*row_size;
+            memcpy(k_data.data() + offs_dst, k_data.data() + offs_src, (size_t) slot*row_size);
+            memcpy(v_data.data() + offs_dst, v_data.data() + offs_src, (size_t) slot*row_size);
+        }
+
+        page_release(src);
+        seqs[seq].pages.back() = dst;
+        n_copied++;
+    }
+
+    return seqs[seq].n_pos++;
+}
+
+void whisper_kv_pages::seq_truncate(int seq, int n_pos) {
+    n_pos = std::max(0, n_pos);
+    if (n_pos >= seqs[seq].n_pos) {
+        return;
+    }
+
+    // a partially kept page stays shared; the next seq_push copies it if needed
+    const size_t n_keep = (size_t) (n_pos + page_size - 1)/page_size;
+    while (seqs[seq].pages.size() > n_keep) {
+        page_release(seqs[seq].pages.back());
+        seqs[seq].pages.pop_back();
+    }
+    seqs[seq].n_pos = n_pos;
+}
+
+size_t whisper_kv_pages::offset(int seq, int il, int pos) const {
+    const int page = seqs[seq].pages[pos / page_size];
+    const int slot = pos % page_size;
+
+    return (((size_t) page*n_layer + il)*page_size + slot)*row_size;
+}
+
+float * whisper_kv_pages::k(int seq, int il, int pos) {
+    assert(type == GGML_TYPE_F32);
+    return reinterpret_cast<float *>(k_data.data() + offset(seq, il, pos));
+}
+
+float * whisper_kv_pages::v(int seq, int il, int pos) {
+    assert(type == GGML_TYPE_F32);
+    return reinterpret_cast<float *>(v_data.data() + offset(seq, il, pos));
+}
+
+const float * whisper_kv_pages::k(int seq, int il, int pos) const {
+    assert(type == GGML_TYPE_F32);
+    return reinterpret_cast<const float *>(k_data.data() + offset(seq, il, pos));
+}
+
+const float * whisper_kv_pages::v(int seq, int il, int pos) const {
+    assert(type == GGML_TYPE_F32);
+    return reinterpret_cast<const float *>(v_data.data() + offset(seq, il, pos));
+}
+
+// Store or load a row of n_state values in the cache type
+static void whisper_kv_row_store(ggml_type type, const float * src, uint8_t * dst, int n) {
+    if (type == GGML_TYPE_F32) {
+        memcpy(dst, src, n*sizeof(float));
+    } else {
+        ggml_internal_get_type_traits(type).from_float(src, dst, n);
+    }
+}
+
+static void whisper_kv_row_load(ggml_type type, const uint8_t * src, float * dst, int n) {
+    if (type == GGML_TYPE_F32) {
+        memcpy(dst, src, n*sizeof(float));
+    } else {
+        ggml_internal_get_type_traits(type).to_float(src, dst, n);
+    }
+}
+
+void whisper_kv_pages::set(int seq, int il, int pos, const float * k, const float * v) {
+    whisper_kv_row_store(type, k, k_data.data() + offset(seq, il, pos), n_state);
+    whisper_kv_row_store(type, v, v_data.data() + offset(seq, il, pos), n_state);
+}
+
+void whisper_kv_pages::get_k(int seq, int il, int pos, float * k) const {
+    whisper_kv_row_load(type, k_data.data() + offset(seq, il, pos), k, n_state);
+}
+
+void whisper_kv_pages::get_v(int seq, int il, int pos, float * v) const {
+    whisper_kv_row_load(type, v_data.data() + offset(seq, il, pos), v, n_state);
+}
+
+// Values [i0, i0 + n) of a stored row as floats: F32 rows are read in place, other
+// types convert only the slice when it starts and ends on a block boundary
+static const float * whisper_kv_slice(ggml_type type, const uint8_t * row, int i0, int n, int n_state, float * scratch) {
+    if (type == GGML_TYPE_F32) {
+        return reinterpret_cast<const float *>(row) + i0;
+    }
+
+    const int blck = ggml_blck_size(type);
+    if (i0 % blck == 0 && n % blck == 0) {
+        whisper_kv_row_load(type, row + ggml_row_size(type, i0), scratch, n);
+        return scratch;
+    }
+
+    whisper_kv_row_load(type, row, scratch, n_state);
+    return scratch + i0;
+}
+
+void whisper_kv_pages::attend(int seq, int il, const float * q, int n_head, float * out) const {
+    const int n_pos  = seqs[seq].n_pos;
+    const int d_head = n_state / n_head;
+    const float scale = 1.0f / sqrtf((float) d_head);
+
+    std::fill(out, out + n_state, 0.0f);
+    if (n_pos == 0) {
+        return;
+    }
+
+    // A Q8_0 cache scores with integer dot products against the query quantized
+    // once, block by block, as ggml does for Q8_0 weights
+    const ggml_type_traits_t traits = ggml_internal_get_type_traits(type);
+    const bool q8_dot = type == GGML_TYPE_Q8_0 && d_head % traits.blck_size == 0;
+
+    std::vector<uint8_t> q_q8;
+    if (q8_dot) {
+        q_q8.resize(row_size);
+        traits.from_float(q, q_q8.data(), n_state);
+    }
+
+    std::vector<float> scores(n_pos);
+    std::vector<float> scratch(n_state);
+
+    for (int h = 0; h < n_head; h++) {
+        const int i0 = h*d_head;
+
+        float max = -INFINITY;
+        for (int pos = 0; pos < n_pos; pos++) {
+            const uint8_t * k_row = k_data.data() + offset(seq, il, pos);
+
+            float dot = 0.0f;
+            if (q8_dot) {
+                const size_t offs = ggml_row_size(type, i0);
+                traits.vec_dot(d_head, &dot, k_row + offs, q_q8.data() + offs);
+            } else {
+                const float * k = whisper_kv_slice(type, k_row, i0, d_head, n_state, scratch.data());
+                for (int j = 0; j < d_head; j++) {
+                    dot += k[j]*q[i0 + j];
+                }
+            }
+
+            scores[pos] = dot*scale;
+            max = std::max(max, scores[pos]);
+        }
+
+        float sum = 0.0f;
+        for (int pos = 0; pos < n_pos; pos++) {
+            scores[pos] = expf(scores[pos] - max);
+            sum += scores[pos];
+        }
+
+        float * y = out + i0;
+        for (int pos = 0; pos < n_pos; pos++) {
+            const float p = scores[pos]/sum;
+            const float * v = whisper_kv_slice(type, v_data.data() + offset(seq, il, pos), i0, d_head, n_state, scratch.data());
+            for (int j = 0; j < d_head; j++) {
+                y[j] += p*v[j];
+            }
+        }
+    }
+}
+
+int whisper_kv_pages::page_alloc() {
+    int page;
+    if (!free_pages.empty()) {
+        page = free_pages.back();
+        free_pages.pop_back();
+    } else {
+        page = (int) page_ref.size();
+        page_ref.push_back(0);
+
+        const size_t n = (size_t) page_ref.size()*n_layer*page_size*row_size;
+        k_data.resize(n);
+        v_data.resize(n);
+    }
+
+    page_ref[page] = 1;
+
+    return page;
+}
+
+void whisper_kv_pages::page_release(int page) {
+    if (--page_ref[page] == 0) {
+        free_pages.push_back(page);
+    }
+}
+
+//
+// search
+//
+
+namespace {
+
+struct whisper_hypothesis {
+    int seq = -1;
+    int row = 0; // logits row of the last step
+
+    std::vector<whisper_token> tokens;
+    std::vector<float>         probs;
+    double sum_logprob = 0.0;
+    bool   finished    = false;
+};
+
+struct whisper_candidate {
+    int           parent;
+    whisper_token token;
+    float         logprob;
+    double        sum_logprob;
+};
+
+// log-softmax of logits/temperature
+void whisper_log_softmax(const float * logits, int n, float temperature, std::vector<float> & out) {
+    const float scale = temperature > 0.0f ? 1.0f/temperature : 1.0f;
+
+    out.resize(n);
+
+    float max = -INFINITY;
+    for (int i = 0; i < n; i++) {
+        out[i] = logits[i]*scale;
+        max = std::max(max, out[i]);
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < n; i++) {
+        sum += std::exp(out[i] - max);
+    }
+
+    const float log_sum = max + (float) std::log(sum);
+    for (int i = 0; i < n; i++) {
+        out[i] -= log_sum;
+    }
+}
+
+double whisper_length_score(double sum_logprob, size_t n_tokens, float length_penalty) {
+    const double length = (double) std::max<size_t>(1, n_tokens);
+    if (length_penalty <= 0.0f) {
+        return sum_logprob/length;
+    }
+
+    return sum_logprob/std::pow((5.0 + length)/6.0, length_penalty);
+}
+
+whisper_token whisper_argmax(const float * values, int n) {
+    return (whisper_token) (std::max_element(values, values + n) - values);
+}
+
+} // namespace
+
+whisper_search_result whisper_search(
+        whisper_kv_pages                 & kv,
+        const std::vector<whisper_token> & prompt,
+        const whisper_search_params      & params,
+        const whisper_decode_step        & step) {
+    whisper_search_result result;
+
+    const int n_vocab = params.n_vocab;
+    if (prompt.empty() || n_vocab <= 0) {
+        return result;
+    }
+
+    const bool beam   = params.strategy == WHISPER_SAMPLING_BEAM_SEARCH && params.beam_size > 1;
+    const bool sample = !beam && params.temperature > 0.0f;
+
+    const int n_hyp    = beam ? params.beam_size : sample ? std::max(1, params.best_of) : 1;
+    const int n_finish = beam && params.patience > 0.0f ? std::max(1, (int) (params.patience*n_hyp)) : n_hyp;
+
+    // the prompt goes through the decoder once; every hypothesis forks from it
+    std::vector<whisper_decode_input> batch;
+    std::vector<float> logits;
+
+    const int base = kv.seq_new();
+    for (whisper_token token : prompt) {
+        batch.push_back({ base, kv.seq_push(base), token });
+    }
+    logits.resize(batch.size()*n_vocab);
+
+    if (!step(kv, batch, logits.data())) {
+        kv.seq_free(base);
+        return result;
+    }
+    result.n_steps = 1;
+
+    // silence and noise end here, before any token is decoded
+    if (params.no_speech >= 0 && params.no_speech < n_vocab) {
+        std::vector<float> logprobs;
+        whisper_log_softmax(logits.data() + (batch.size() - 1)*n_vocab, n_vocab, 0.0f, logprobs);
+        result.no_speech_prob = std::exp(logprobs[params.no_speech]);
+
+        if (result.no_speech_prob > params.no_speech_thold) {
+            kv.seq_free(base);
+            result.ok          = true;
+            result.no_speech   = true;
+            result.temperature = params.temperature;
+            return result;
+        }
+    }
+
+    std::vector<whisper_hypothesis> hyps(1);
+    hyps[0].seq = base;
+    hyps[0].row = (int) batch.size() - 1;
+
+    std::vector<whisper_hypothesis> done;
+    std::vector<whisper_candidate>  cands;
+    std::vector<float>              logprobs;
+    std::vector<int>                order(n_vocab);
+    std::mt19937                    rng(params.seed);
+
+    bool ok = true;
+    while (!hyps.empty()) {
+        cands.clear();
+        for (int i = 0; i < (int) hyps.size(); i++) {
+            const whisper_hypothesis & hyp = hyps[i];
+            whisper_log_softmax(logits.data() + (size_t) hyp.row*n_vocab, n_vocab, sample ? params.temperature : 0.0f, logprobs);
+
+            if (beam) {
+                std::iota(order.begin(), order.end(), 0);
+                std::partial_sort(order.begin(), order.begin() + std::min(n_hyp, n_vocab), order.end(),
+                        [&](int a, int b) { return logprobs[a] > logprobs[b]; });
+                for (int j = 0; j < std::min(n_hyp, n_vocab); j++) {
+                    cands.push_back({ i, order[j], logprobs[order[j]], hyp.sum_logprob + logprobs[order[j]] });
+                }
+            } else if (sample) {
+                // the prompt hypothesis splits into best_of samples, later ones continue alone
+                std::vector<double> probs(n_vocab);
+                for (int j = 0; j < n_vocab; j++) {
+                    probs[j] = std::exp(logprobs[j]);
+                }
+                std::discrete_distribution<int> dist(probs.begin(), probs.end());
+
+                const int n_samples = hyp.tokens.empty() ? n_hyp : 1;
+                for (int j = 0; j < n_samples; j++) {
+                    const int token = dist(rng);
+                    cands.push_back({ i, token, logprobs[token], hyp.sum_logprob + logprobs[token] });
+                }
+            } else {
+                const int token = (int) (std::max_element(logprobs.begin(), logprobs.end()) - logprobs.begin());
+                cands.push_back({ i, token, logprobs[token], hyp.sum_logprob + logprobs[token] });
+            }
+        }
+
+        if (beam) {
+            std::stable_sort(cands.begin(), cands.end(),
+                    [](const whisper_candidate & a, const whisper_candidate & b) { return a.sum_logprob > b.sum_logprob; });
+        }
+
+        // the first child of a hypothesis takes over its sequence, further children fork it
+        std::vector<whisper_hypothesis> next;
+        std::vector<bool> claimed(hyps.size(), false);
+
+        for (const whisper_candidate & cand : cands) {
+            if (beam && (int) next.size() >= n_hyp) {
+                break;
+            }
+
+            const whisper_hypothesis & parent = hyps[cand.parent];
+
+            whisper_hypothesis hyp;
+            hyp.tokens = parent.tokens;
+            hyp.probs  = parent.probs;
+            hyp.tokens.push_back(cand.token);
+            hyp.probs.push_back(std::exp(cand.logprob));
+            hyp.sum_logprob = cand.sum_logprob;
+
+            if (cand.token == params.eot || (int) hyp.tokens.size() >= params.max_tokens) {
+                hyp.finished = cand.token == params.eot;
+                if (hyp.finished) {
+                    hyp.tokens.pop_back();
+                    hyp.probs.pop_back();
+                }
+                done.push_back(std::move(hyp));
+                continue;
+            }
+
+            if (!claimed[cand.parent]) {
+                claimed[cand.parent] = true;
+                hyp.seq = parent.seq;
+            } else {
+                hyp.seq = kv.seq_fork(parent.seq);
+            }
+            next.push_back(std::move(hyp));
+        }
+
+        for (size_t i = 0; i < hyps.size(); i++) {
+            if (!claimed[i]) {
+                kv.seq_free(hyps[i].seq);
+            }
+        }
+        hyps = std::move(next);
+
+        if (hyps.empty() || (beam && (int) done.size() >= n_finish)) {
+            break;
+        }
+
+        // one batched step feeds the last token of every live hypothesis
+        batch.clear();
+        for (int i = 0; i < (int) hyps.size(); i++) {
+            batch.push_back({ hyps[i].seq, kv.seq_push(hyps[i].seq), hyps[i].tokens.back() });
+            hyps[i].row = i;
+        }
+        logits.resize(batch.size()*n_vocab);
+
+        result.n_steps++;
+        if (!step(kv, batch, logits.data())) {
+            ok = false;
+            break;
+        }
+    }
+
+    for (const whisper_hypothesis & hyp : hyps) {
+        kv.seq_free(hyp.seq);
+    }
+
+    if (!ok || done.empty()) {
+        return result;
+    }
+
+    // hypotheses that reached EOT beat those cut off at max_tokens
+    const whisper_hypothesis * best = nullptr;
+    double best_score = -INFINITY;
+    for (const whisper_hypothesis & hyp : done) {
+        const double score = whisper_length_score(hyp.sum_logprob, hyp.tokens.size() + hyp.finished, params.length_penalty);
+        if (!best || (hyp.finished && !best->finished) || (hyp.finished == best->finished && score > best_score)) {
+            best       = &hyp;
+            best_score = score;
+        }
+    }
+
+    result.ok          = true;
+    result.temperature = params.temperature;
+    result.tokens      = best->tokens;
+    result.probs       = best->probs;
+    result.sum_logprob = best->sum_logprob;
+    result.score       = best_score;
+    result.finished    = best->finished;
+
+    return result;
+}
+
+whisper_search_result whisper_search_speculative(
+        whisper_kv_pages                 & kv,
+        whisper_kv_pages                 & kv_draft,
+        const std::vector<whisper_token> & prompt,
+        const whisper_search_params      & params,
+        int                                n_draft,
+        const whisper_decode_step        & step,
+        const whisper_decode_step        & draft) {
+    const bool beam = params.strategy == WHISPER_SAMPLING_BEAM_SEARCH && params.beam_size > 1;
+    if (beam || params.temperature > 0.0f || n_draft < 1) {
+        return whisper_search(kv, prompt, params, step);
+    }
+
+    whisper_search_result result;
+
+    const int n_vocab = params.n_vocab;
+    if (prompt.empty() || n_vocab <= 0) {
+        return result;
+    }
+
+    const int n_prompt = (int) prompt.size();
+
+    std::vector<whisper_decode_input> batch;
+    std::vector<float> logits;
+    std::vector<float> logprobs;
+
+    // the draft sees the prompt with its first proposal, the large model right away
+    const int seq = kv.seq_new();
+    for (whisper_token token : prompt) {
+        batch.push_back({ seq, kv.seq_push(seq), token });
+    }
+    logits.resize(batch.size()*n_vocab);
+
+    if (!step(kv, batch, logits.data())) {
+        kv.seq_free(seq);
+        return result;
+    }
+    result.n_steps = 1;
+
+    whisper_log_softmax(logits.data() + (batch.size() - 1)*n_vocab, n_vocab, 0.0f, logprobs);
+
+    if (params.no_speech >= 0 && params.no_speech < n_vocab) {
+        result.no_speech_prob = std::exp(logprobs[params.no_speech]);
+
+        if (result.no_speech_prob > params.no_speech_thold) {
+            kv.seq_free(seq);
+            result.ok          = true;
+            result.no_speech   = true;
+            result.temperature = params.temperature;
+            return result;
+        }
+    }
+
+    std::vector<whisper_token> tokens;
+    std::vector<float>         probs;
+    double sum_logprob = 0.0;
+    bool   finished    = false;
+
+    // take the large model's pick; true when decoding ends with it
+    auto accept = [&](whisper_token token, float logprob) {
+        tokens.push_back(token);
+        probs.push_back(std::exp(logprob));
+        sum_logprob += logprob;
+
+        if (token == params.eot || (int) tokens.size() >= params.max_tokens) {
+            finished = token == params.eot;
+            if (finished) {
+                tokens.pop_back();
+                probs.pop_back();
+            }
+            return true;
+        }
+        return false;
+    };
+
+    const int seq_draft = kv_draft.seq_new();
+
+    std::vector<whisper_token> proposal;
+
+    const whisper_token first = whisper_argmax(logprobs.data(), n_vocab);
+
+    bool ok    = true;
+    bool ended = accept(first, logprobs[first]);
+
+    // both caches hold the prompt and all tokens but the last; the draft may lag behind
+    while (!ended) {
+        const int n_known = n_prompt + (int) tokens.size();
+
+        batch.clear();
+        for (int pos = kv_draft.seq_len(seq_draft); pos < n_known; pos++) {
+            const whisper_token token = pos < n_prompt ? prompt[pos] : tokens[pos - n_prompt];
+            batch.push_back({ seq_draft, kv_draft.seq_push(seq_draft), token });
+        }
+
+        proposal.clear();
+        while (true) {
+            logits.resize(batch.size()*n_vocab);
+            if (!draft(kv_draft, batch, logits.data())) {
+                ok = false;
+                break;
+            }
+
+            const whisper_token token = whisper_argmax(logits.data() + (batch.size() - 1)*n_vocab, n_vocab);
+            proposal.push_back(token);
+
+            if (token == params.eot || (int) proposal.size() >= n_draft ||
+                (int) (tokens.size() + proposal.size()) >= params.max_tokens) {
+                break;
+            }
+
+            batch.clear();
+            batch.push_back({ seq_draft, kv_draft.seq_push(seq_draft), token });
+        }
+
+        if (!ok) {
+            break;
+        }
+        result.n_drafted += (int) proposal.size();
+
+        // one step of the large model over the last token and the proposals:
+        // row i holds its pick after input i, the row after the last a bonus token
+        batch.clear();
+        batch.push_back({ seq, kv.seq_push(seq), tokens.back() });
+        for (whisper_token token : proposal) {
+            if (token != params.eot) {
+                batch.push_back({ seq, kv.seq_push(seq), token });
+            }
+        }
+        logits.resize(batch.size()*n_vocab);
+
+        result.n_steps++;
+        if (!step(kv, batch, logits.data())) {
+            ok = false;
+            break;
+        }
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            whisper_log_softmax(logits.data() + i*n_vocab, n_vocab, 0.0f, logprobs);
+
+            const whisper_token pick  = whisper_argmax(logprobs.data(), n_vocab);
+            const bool          match = i < proposal.size() && pick == proposal[i];
+
+            ended = accept(pick, logprobs[pick]);
+            result.n_accepted += match;
+
+            if (ended || !match) {
+                break;
+            }
+        }
+
+        // positions after the first rejected proposal are dropped from both caches
+        kv.seq_truncate(seq, n_prompt + (int) tokens.size() - 1);
+        kv_draft.seq_truncate(seq_draft, n_prompt + (int) tokens.size() - 1);
+    }
+
+    kv.seq_free(seq);
+    kv_draft.seq_free(seq_draft);
+
+    if (!ok) {
+        return result;
+    }
+
+    result.ok          = true;
+    result.temperature = params.temperature;
+    result.tokens      = std::move(tokens);
+    result.probs       = std::move(probs);
+    result.sum_logprob = sum_logprob;
+    result.score       = whisper_length_score(sum_logprob, result.tokens.size() + finished, params.length_penalty);
+    result.finished    = finished;
+
+    return result;
+}
+
+float whisper_token_entropy(const std::vector<whisper_token> & tokens) {
+    const size_t n     = std::min<size_t>(32, tokens.size());
+    const size_t first = tokens.size() - n;
+
+    std::vector<whisper_token> last(tokens.begin() + first, tokens.end());
+    std::sort(last.begin(), last.end());
+
+    double entropy = 0.0;
+    for (size_t i = 0; i < n; ) {
+        size_t j = i;
+        while (j < n && last[j] == last[i]) {
+            j++;
+        }
+        const double p = (double) (j - i)/n;
+        entropy -= p*std::log(p);
+        i = j;
+    }
+
+    return (float) entropy;
+}
+
+whisper_search_result whisper_search_with_fallback(
+        whisper_kv_pages                 & kv,
+        const std::vector<whisper_token> & prompt,
+        const whisper_search_params      & params,
+        const whisper_fallback_params    & fallback,
+        const whisper_decode_step        & step) {
+    whisper_search_params attempt = params;
+    whisper_search_result result;
+
+    int n_steps = 0;
+    for (int i = 0; ; i++) {
+        attempt.temperature = params.temperature + i*std::max(0.0f, fallback.temperature_inc);
+        if (attempt.temperature > 0.0f) {
+            attempt.strategy = WHISPER_SAMPLING_GREEDY;
+        }
+
+        result = whisper_search(kv, prompt, attempt, step);
+        n_steps += result.n_steps;
+        result.n_steps     = n_steps;
+        result.n_fallbacks = i;
+
+        if (!result.ok || result.no_speech) {
+            break;
+        }
+
+        // only long results can be judged repetitive
+        const double avg_logprob = result.sum_logprob/std::max<size_t>(1, result.tokens.size() + result.finished);
+        const bool failed = (result.tokens.size() > 32 && whisper_token_entropy(result.tokens) < fallback.entropy_thold) ||
+                            avg_logprob < fallback.logprob_thold;
+
+        if (!failed || fallback.temperature_inc <= 0.0f ||
+            attempt.temperature + fallback.temperature_inc > 1.0f + 1e-6f) {
+            break;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,196 @@
+#ifndef WHISPER_DECODE_H
+#define WHISPER_DECODE_H
+
+#include "whisper.h"
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Token search for the text decoder
+//
+// Every hypothesis (a beam, or one best-of sample) is a sequence in a paged K/V
+// cache. Forking a sequence shares its pages; a page is copied only when a
+// sequence appends to a page that another sequence still references, so beams
+// pay for the shared prefix once. The decoder runs one batched step per token
+// for all live hypotheses.
+//
+// whisper_search_speculative() decodes greedily with a small draft model that
+// proposes a few tokens at a time, which the large model checks in one step.
+//
+// whisper_search_with_fallback() wraps the search in the temperature fallback:
+// a result that looks repetitive or improbable is decoded again at a higher
+// temperature, and audio the decoder takes for no speech is not decoded at all.
+
+// Self-attention K/V cache with pages shared copy-on-write between sequences
+// Layout per page: [n_layer][page_size][n_state] for K and for V
+//
+// Rows are stored as F32, F16 or Q8_0 (type_kv in whisper_context_params); pages
+// are allocated as sequences grow, so a cache holds only the positions decoded so
+// far. attend() reads the stored rows directly, dequantizing inside the dot
+// products instead of expanding the cache to floats first.
+struct whisper_kv_pages {
+    // Q8_0 needs n_state to be a multiple of its 32-element blocks; otherwise rows
+    // are stored as F16
+    whisper_kv_pages(int n_layer, int n_state, int page_size = 16, ggml_type type = GGML_TYPE_F32);
+
+    int  seq_new();
+    int  seq_fork(int src); // new sequence sharing all of src's positions
+    void seq_free(int seq);
+    int  seq_len(int seq) const;
+
+    // Append a position to seq and return its index; the last page is copied first
+    // if another sequence shares it
+    int seq_push(int seq);
+
+    // Drop the positions of seq from n_pos on
+    void seq_truncate(int seq, int n_pos);
+
+    // Rows of one position of an F32 cache; only the last position of a sequence
+    // may be written. Pointers are invalidated by the next seq_push or seq_fork.
+    float       * k(int seq, int il, int pos);
+    float       * v(int seq, int il, int pos);
+    const float * k(int seq, int il, int pos) const;
+    const float * v(int seq, int il, int pos) const;
+
+    // Store the K and V rows of the last position of seq, converted to type
+    void set(int seq, int il, int pos, const float * k, const float * v);
+
+    // Read rows back as floats
+    void get_k(int seq, int il, int pos, float * k) const;
+    void get_v(int seq, int il, int pos, float * v) const;
+
+    // Attention of one query over all positions of seq in layer il:
+    // out = softmax(q K^T / sqrt(n_state/n_head)) V for each of n_head heads
+    void attend(int seq, int il, const float * q, int n_head, float * out) const;
+
+    int    n_pages_used()   const { return (int) (page_ref.size() - free_pages.size()); }
+    int    n_pages_copied() const { return n_copied; }
+    size_t n_bytes()        const { return k_data.size() + v_data.size(); }
+
+    const int       n_layer;
+    const int       n_state;
+    const int       page_size;
+    const ggml_type type;
+    const size_t    row_size; // bytes per row of n_state values
+
+private:
+    struct sequence {
+        std::vector<int> pages;
+        int  n_pos = 0;
+        bool used  = false;
+    };
+
+    int    page_alloc();
+    void   page_release(int page);
+    size_t offset(int seq, int il, int pos) const; // in bytes
+
+    std::vector<uint8_t> k_data;
+    std::vector<uint8_t> v_data;
+    std::vector<int>   page_ref; // sequences referencing each page
+    std::vector<int>   free_pages;
+
+    std::vector<sequence> seqs;
+    std::vector<int>      free_seqs;
+
+    int n_copied = 0;
+};
+
+// One token fed to the decoder: its K/V go to position pos of seq
+struct whisper_decode_input {
+    int seq;
+    int pos;
+    whisper_token token;
+};
+
+// Batched decoder step: write the K/V rows of every input and the logits that
+// follow it to logits + i*n_vocab. Returns false on failure.
+using whisper_decode_step = std::function<bool(whisper_kv_pages & kv, const std::vector<whisper_decode_input> & batch, float * logits)>;
+
+struct whisper_search_params {
+    whisper_sampling_strategy strategy = WHISPER_SAMPLING_GREEDY;
+
+    int   beam_size      = 5;     // beams kept per step (beam search)
+    int   best_of        = 1;     // independent samples when temperature > 0 (greedy)
+    float temperature    = 0.0f;
+    float length_penalty = -1.0f; // <= 0: average log-probability, else the Google NMT penalty
+    float patience       = 1.0f;  // beam search stops after patience*beam_size finished beams
+
+    int n_vocab    = 0;
+    int max_tokens = 224;
+
+    whisper_token eot = 0;
+    uint32_t seed     = 0;
+
+    // With no_speech >= 0, stop after the prompt when the probability of that
+    // token following the prompt exceeds no_speech_thold
+    whisper_token no_speech       = -1;
+    float         no_speech_thold = 0.6f;
+};
+
+struct whisper_search_result {
+    bool ok = false;
+
+    std::vector<whisper_token> tokens; // without the prompt and EOT
+    std::vector<float>         probs;  // probability of each token when it was picked
+    double sum_logprob = 0.0;
+    double score       = 0.0;          // sum_logprob after the length penalty
+    bool   finished    = false;        // ended with EOT rather than max_tokens
+    int    n_steps     = 0;            // decoder calls, including the prompt
+
+    float no_speech_prob = 0.0f;
+    bool  no_speech      = false;      // skipped after the prompt, tokens is empty
+
+    float temperature = 0.0f;          // of the accepted attempt (fallback)
+    int   n_fallbacks = 0;             // attempts rejected before it
+
+    int n_drafted  = 0;                // tokens proposed by the draft model (speculative)
+    int n_accepted = 0;                // of those, tokens the large model agreed with
+};
+
+// Decode after prompt (non-empty) and return the best hypothesis. Greedy with
+// temperature 0 takes the argmax; with temperature > 0 it keeps the best of
+// best_of samples. Beam search keeps the beam_size best prefixes.
+whisper_search_result whisper_search(
+        whisper_kv_pages                 & kv,
+        const std::vector<whisper_token> & prompt,
+        const whisper_search_params      & params,
+        const whisper_decode_step        & step);
+
+// Greedy decoding at temperature 0 where draft proposes up to n_draft tokens that
+// one batched step of the large model verifies. The large model keeps the
+// proposals up to the first token it would not have picked and adds its own
+// there, so the result equals whisper_search() with step alone; n_steps counts
+// the steps of the large model only. Each model has its own cache. Other
+// strategies and temperatures run whisper_search() on step.
+whisper_search_result whisper_search_speculative(
+        whisper_kv_pages                 & kv,
+        whisper_kv_pages                 & kv_draft,
+        const std::vector<whisper_token> & prompt,
+        const whisper_search_params      & params,
+        int                                n_draft,
+        const whisper_decode_step        & step,
+        const whisper_decode_step        & draft);
+
+// Thresholds of the temperature fallback, as in whisper_full_params
+struct whisper_fallback_params {
+    float temperature_inc = 0.2f;  // <= 0: a single attempt
+    float entropy_thold   = 2.4f;  // reject when the entropy of the last 32 tokens is lower
+    float logprob_thold   = -1.0f; // reject when the average log-probability is lower
+};
+
+// Entropy of the token histogram over the last 32 tokens; repeated phrases score low
+float whisper_token_entropy(const std::vector<whisper_token> & tokens);
+
+// Search at params.temperature, then again at each temperature_inc step up to 1.0
+// while the result fails the entropy or log-probability check. Attempts above
+// temperature 0 sample best_of hypotheses instead of running beam search.
+// n_steps counts the decoder calls of all attempts.
+whisper_search_result whisper_search_with_fallback(
+        whisper_kv_pages                 & kv,
+        const std::vector<whisper_token> & prompt,
+        const whisper_search_params      & params,
+        const whisper_fallback_params    & fallback,
+        const whisper_decode_step        & step);
+
+#endif // WHISPER_DECODE_H
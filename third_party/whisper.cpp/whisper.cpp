@@ -1,5 +1,12 @@
+#if defined(_MSC_VER)
+#define _USE_MATH_DEFINES // for M_PI
+#endif
+
 #include "whisper.h"
+#include "whisper-decode.h"
 #include "ggml.h"
+#include "ggml-alloc.h"
+#include "ggml-backend.h"
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -12,6 +19,20 @@
 #include <sstream>
 #include <algorithm>
 #include <cmath>
+#include <chrono>
+#include <filesystem>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // Implementation constants
 static const int WHISPER_SAMPLE_RATE = 16000;
@@ -34,16 +55,137 @@ static const std::vector<std::string> g_lang_str = {
     "cs", "ro", "da", "hu", "ta", "no"
 };
 
+// Precomputed tables for the log-mel front end
+struct whisper_mel_tables {
+    int n_mel = 0;
+    int n_bins = 0;
+
+    std::vector<float> hann;     // [WHISPER_N_FFT]
+    std::vector<float> sin_vals; // sin(2*pi*i/WHISPER_N_FFT)
+    std::vector<float> cos_vals; // cos(2*pi*i/WHISPER_N_FFT)
+    std::vector<float> filters;  // [n_mel][n_bins]
+    std::vector<int>   filter_k0; // first non-zero bin of each filter
+    std::vector<int>   filter_k1; // one past the last non-zero bin
+};
+
+// Read-only mapping of a whole model file. Pages are faulted in on first access and
+// are shared through the page cache with every other process mapping the same file.
+struct whisper_mmap {
+    void * addr = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    HANDLE hmap = nullptr;
+#endif
+
+    whisper_mmap() = default;
+    whisper_mmap(const whisper_mmap &) = delete;
+    whisper_mmap & operator=(const whisper_mmap &) = delete;
+
+    bool open(const char * path) {
+#ifdef _WIN32
+        HANDLE hfile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (hfile == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(hfile, &file_size) || file_size.QuadPart == 0) {
+            CloseHandle(hfile);
+            return false;
+        }
+        hmap = CreateFileMappingA(hfile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(hfile);
+        if (!hmap) {
+            return false;
+        }
+        addr = MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0);
+        if (!addr) {
+            CloseHandle(hmap);
+            hmap = nullptr;
+            return false;
+        }
+        size = static_cast<size_t>(file_size.QuadPart);
+#else
+        const int fd = ::open(path, O_RDONLY);
+        if (fd == -1) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void * p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // the mapping keeps its own reference to the file
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        addr = p;
+        size = static_cast<size_t>(st.st_size);
+#endif
+        return true;
+    }
+
+    ~whisper_mmap() {
+#ifdef _WIN32
+        if (addr) {
+            UnmapViewOfFile(addr);
+        }
+        if (hmap) {
+            CloseHandle(hmap);
+        }
+#else
+        if (addr) {
+            munmap(addr, size);
+        }
+#endif
+    }
+};
+
+// Weights and vocabulary of a loaded model. Tensor metadata lives in a no_alloc ggml
+// context; the tensor data points into exactly one of: the file mapping, the buffer
+// passed to whisper_init_from_buffer, or the owned copy made by the buffered loader.
+// Weights are read-only: a mapped model faults on writes.
+struct whisper_model {
+    ggml_context * ctx = nullptr;
+    std::map<std::string, ggml_tensor *> tensors;
+    size_t n_bytes = 0; // total size of the tensor data
+
+    std::vector<std::string> id_to_token;
+    std::map<std::string, whisper_token> token_to_id;
+
+    std::unique_ptr<whisper_mmap> mapping;
+    std::vector<uint8_t>          buffer;
+
+    whisper_model() = default;
+    whisper_model(const whisper_model &) = delete;
+    whisper_model & operator=(const whisper_model &) = delete;
+
+    ~whisper_model() {
+        if (ctx) {
+            ggml_free(ctx);
+        }
+    }
+};
+
+// Decoded segment; times in 10 ms units, token_text[i] is the text of tokens[i]
+struct whisper_segment {
+    std::string text;
+    int64_t t0 = 0;
+    int64_t t1 = 0;
+    std::vector<whisper_token_data> tokens;
+    std::vector<std::string> token_text;
+    float acoustic_confidence = 0.0f; // mean frame score, see whisper_frame_acoustic_scores()
+};
+
 // Whisper context structure
 struct whisper_context {
     std::string model_path;
+    whisper_model model;
     std::vector<float> mel_data;
-    std::vector<whisper_token_data> result_tokens;
-    std::vector<std::string> result_segments;
-    std::vector<int64_t> segment_times_start;
-    std::vector<int64_t> segment_times_end;
+    whisper_mel_tables mel_tables;
+    std::vector<whisper_segment> result_all;
     
-    // Model parameters (mock values for now)
+    // Model hyperparameters, overwritten from the model file header
     int n_vocab = 51864;
     int n_audio_ctx = 1500;
     int n_audio_state = 512;
@@ -62,45 +204,324 @@ struct whisper_context {
     // Tokens
     whisper_token token_eot = 50256;
     whisper_token token_sot = 50257;
+    whisper_token token_solm = 50359;
     whisper_token token_prev = 50360;
-    whisper_token token_solm = 50361;
+    whisper_token token_nosp = 50361;
     whisper_token token_not = 50362;
     whisper_token token_beg = 50363;
     whisper_token token_translate = 50357;
     whisper_token token_transcribe = 50358;
+
+    ggml_type type_kv = GGML_TYPE_F32; // decoder K/V cache storage
+    whisper_memory_usage memory = {};  // set once the model is loaded
 };
 
 // Whisper state structure
 struct whisper_state {
     whisper_context* ctx;
     std::vector<float> mel;
-    std::vector<whisper_token_data> tokens;
-    std::vector<std::string> segments;
-    std::vector<int64_t> segment_t0;
-    std::vector<int64_t> segment_t1;
+    std::vector<whisper_segment> result_all;
     int lang_id = 0;
     int n_len = 0;
+    int n_samples = 0; // audio behind mel
+    float no_speech_prob = 0.0f;
 };
 
 // Helper functions
-static std::vector<float> log_mel_spectrogram(const float* samples, int n_samples, int n_threads) {
-    (void)n_threads; // unused for now
-    
-    // Simplified mel spectrogram computation
-    // In a real implementation, this would use FFT and mel filterbanks
-    std::vector<float> mel_data;
-    
+
+// Cooley-Tukey FFT over the tables in whisper_mel_tables
+// in:  n real samples; in[n..2n) is used as scratch
+// out: n complex values (interleaved re/im); out[2n..8n) is used as scratch
+// n must divide WHISPER_N_FFT; odd sizes fall back to a plain DFT
+static void dft(const whisper_mel_tables & tables, const float * in, int n, float * out) {
+    const int step = WHISPER_N_FFT / n;
+
+    for (int k = 0; k < n; k++) {
+        float re = 0.0f;
+        float im = 0.0f;
+
+        // idx walks 2*pi*k*j/n around the table without a modulo per term
+        int idx = 0;
+        for (int j = 0; j < n; j++) {
+            re += in[j] * tables.cos_vals[idx];
+            im -= in[j] * tables.sin_vals[idx];
+
+            idx += k * step;
+            if (idx >= WHISPER_N_FFT) {
+                idx -= WHISPER_N_FFT;
+            }
+        }
+
+        out[2*k + 0] = re;
+        out[2*k + 1] = im;
+    }
+}
+
+static void fft(const whisper_mel_tables & tables, float * in, int n, float * out) {
+    if (n == 1) {
+        out[0] = in[0];
+        out[1] = 0.0f;
+        return;
+    }
+
+    const int half_n = n / 2;
+    if (n - half_n*2 == 1) {
+        dft(tables, in, n, out);
+        return;
+    }
+
+    float * even = in + n;
+    for (int i = 0; i < half_n; ++i) {
+        even[i] = in[2*i];
+    }
+    float * even_fft = out + 2*n;
+    fft(tables, even, half_n, even_fft);
+
+    float * odd = even;
+    for (int i = 0; i < half_n; ++i) {
+        odd[i] = in[2*i + 1];
+    }
+    float * odd_fft = even_fft + n;
+    fft(tables, odd, half_n, odd_fft);
+
+    const int step = WHISPER_N_FFT / n;
+    for (int k = 0; k < half_n; k++) {
+        const int idx = k * step; // 2*pi*k/n
+
+        const float re = tables.cos_vals[idx];
+        const float im = -tables.sin_vals[idx];
+
+        const float re_odd = odd_fft[2*k + 0];
+        const float im_odd = odd_fft[2*k + 1];
+
+        out[2*k + 0] = even_fft[2*k + 0] + re*re_odd - im*im_odd;
+        out[2*k + 1] = even_fft[2*k + 1] + re*im_odd + im*re_odd;
+
+        out[2*(k + half_n) + 0] = even_fft[2*k + 0] - re*re_odd + im*im_odd;
+        out[2*(k + half_n) + 1] = even_fft[2*k + 1] - re*im_odd - im*re_odd;
+    }
+}
+
+// Slaney-style mel scale, matching librosa.filters.mel(htk=False)
+static double hz_to_mel(double f) {
+    const double f_sp = 200.0 / 3.0;
+    const double min_log_hz = 1000.0;
+    const double min_log_mel = min_log_hz / f_sp;
+    const double logstep = std::log(6.4) / 27.0;
+
+    return f < min_log_hz ? f / f_sp : min_log_mel + std::log(f / min_log_hz) / logstep;
+}
+
+static double mel_to_hz(double m) {
+    const double f_sp = 200.0 / 3.0;
+    const double min_log_hz = 1000.0;
+    const double min_log_mel = min_log_hz / f_sp;
+    const double logstep = std::log(6.4) / 27.0;
+
+    return m < min_log_mel ? f_sp * m : min_log_hz * std::exp(logstep * (m - min_log_mel));
+}
+
+// Precompute the window, FFT twiddles and mel filterbank once per context
+static void whisper_mel_tables_init(whisper_mel_tables & tables, int n_mel) {
+    const int n_fft = WHISPER_N_FFT;
+    const int n_bins = 1 + n_fft / 2;
+
+    // periodic Hann window, as torch.hann_window(n_fft)
+    tables.hann.resize(n_fft);
+    tables.sin_vals.resize(n_fft);
+    tables.cos_vals.resize(n_fft);
+    for (int i = 0; i < n_fft; i++) {
+        const double theta = (2.0 * M_PI * i) / n_fft;
+        tables.hann[i] = static_cast<float>(0.5 * (1.0 - std::cos(theta)));
+        tables.sin_vals[i] = static_cast<float>(std::sin(theta));
+        tables.cos_vals[i] = static_cast<float>(std::cos(theta));
+    }
+
+    // mel filterbank [n_mel][n_bins] with Slaney area normalization
+    std::vector<double> mel_f(n_mel + 2);
+    const double mel_min = hz_to_mel(0.0);
+    const double mel_max = hz_to_mel(WHISPER_SAMPLE_RATE / 2.0);
+    for (int i = 0; i < n_mel + 2; i++) {
+        mel_f[i] = mel_to_hz(mel_min + (mel_max - mel_min) * i / (n_mel + 1));
+    }
+
+    tables.n_mel = n_mel;
+    tables.n_bins = n_bins;
+    tables.filters.assign(static_cast<size_t>(n_mel) * n_bins, 0.0f);
+    for (int i = 0; i < n_mel; i++) {
+        const double enorm = 2.0 / (mel_f[i + 2] - mel_f[i]);
+        for (int k = 0; k < n_bins; k++) {
+            const double f = static_cast<double>(k) * WHISPER_SAMPLE_RATE / n_fft;
+            const double lower = (f - mel_f[i]) / (mel_f[i + 1] - mel_f[i]);
+            const double upper = (mel_f[i + 2] - f) / (mel_f[i + 2] - mel_f[i + 1]);
+            const double w = std::max(0.0, std::min(lower, upper));
+            tables.filters[static_cast<size_t>(i) * n_bins + k] = static_cast<float>(w * enorm);
+        }
+    }
+
+    // the triangles only overlap their neighbours, so each mel bin touches a handful of FFT bins
+    tables.filter_k0.assign(n_mel, 0);
+    tables.filter_k1.assign(n_mel, 0);
+    for (int i = 0; i < n_mel; i++) {
+        const float * filter = tables.filters.data() + static_cast<size_t>(i) * n_bins;
+
+        int k0 = 0;
+        while (k0 < n_bins && filter[k0] == 0.0f) {
+            k0++;
+        }
+        int k1 = n_bins;
+        while (k1 > k0 && filter[k1 - 1] == 0.0f) {
+            k1--;
+        }
+
+        tables.filter_k0[i] = k0;
+        tables.filter_k1[i] = k1;
+    }
+}
+
+// Read sample i of the signal after center reflect-padding by n_fft/2
+static inline float mel_reflect_sample(const float * samples, int n_samples, int i) {
+    if (i < 0) {
+        i = -i;
+    }
+    if (i >= n_samples) {
+        i = 2 * (n_samples - 1) - i;
+    }
+    return (i >= 0 && i < n_samples) ? samples[i] : 0.0f;
+}
+
+// Frames [i0, i1) of the log10 mel power spectrum; returns the largest value written
+static float log_mel_spectrogram_worker(const whisper_mel_tables & tables, const float * samples, int n_samples,
+                                        int i0, int i1, int n_len, float * mel) {
+    const int n_fft = WHISPER_N_FFT;
+    const int pad = n_fft / 2;
+    const int n_bins = tables.n_bins;
+
+    std::vector<float> fft_in(2 * n_fft);
+    std::vector<float> fft_out(8 * n_fft);
+    std::vector<float> power(n_bins);
+
+    float mmax = -1e20f;
+
+    for (int i = i0; i < i1; i++) {
+        const int offset = i * WHISPER_HOP_LENGTH - pad;
+
+        if (offset >= 0 && offset + n_fft <= n_samples) {
+            const float * frame = samples + offset;
+            for (int j = 0; j < n_fft; j++) {
+                fft_in[j] = tables.hann[j] * frame[j];
+            }
+        } else {
+            for (int j = 0; j < n_fft; j++) {
+                fft_in[j] = tables.hann[j] * mel_reflect_sample(samples, n_samples, offset + j);
+            }
+        }
+
+        fft(tables, fft_in.data(), n_fft, fft_out.data());
+
+        for (int k = 0; k < n_bins; k++) {
+            power[k] = fft_out[2*k + 0] * fft_out[2*k + 0] + fft_out[2*k + 1] * fft_out[2*k + 1];
+        }
+
+        for (int j = 0; j < tables.n_mel; j++) {
+            const float * filter = tables.filters.data() + static_cast<size_t>(j) * n_bins;
+
+            double sum = 0.0;
+            for (int k = tables.filter_k0[j]; k < tables.filter_k1[j]; k++) {
+                sum += filter[k] * power[k];
+            }
+
+            const float v = static_cast<float>(std::log10(std::max(sum, 1e-10)));
+            mel[static_cast<size_t>(j) * n_len + i] = v;
+            mmax = std::max(mmax, v);
+        }
+    }
+
+    return mmax;
+}
+
+// Log-mel spectrogram laid out as [n_mel][n_len], frames split across n_threads
+static std::vector<float> log_mel_spectrogram(const whisper_mel_tables & tables, const float * samples, int n_samples, int n_threads) {
+    const int n_mel = tables.n_mel;
     const int n_len = (n_samples / WHISPER_HOP_LENGTH) + 1;
-    mel_data.resize(WHISPER_N_MEL * n_len, 0.0f);
-    
-    // Mock mel computation - just fill with noise for testing
-    for (int i = 0; i < WHISPER_N_MEL * n_len; ++i) {
-        mel_data[i] = -10.0f + (rand() / float(RAND_MAX)) * 5.0f;
+
+    std::vector<float> mel_data(static_cast<size_t>(n_mel) * n_len);
+
+    n_threads = std::max(1, std::min(n_threads, n_len));
+
+    std::vector<float> thread_max(n_threads, -1e20f);
+    {
+        std::vector<std::thread> workers;
+        workers.reserve(n_threads - 1);
+
+        for (int iw = 1; iw < n_threads; ++iw) {
+            workers.emplace_back([&, iw]() {
+                const int i0 = static_cast<int>(static_cast<int64_t>(n_len) * iw / n_threads);
+                const int i1 = static_cast<int>(static_cast<int64_t>(n_len) * (iw + 1) / n_threads);
+                thread_max[iw] = log_mel_spectrogram_worker(tables, samples, n_samples, i0, i1, n_len, mel_data.data());
+            });
+        }
+
+        const int i1 = static_cast<int>(static_cast<int64_t>(n_len) / n_threads);
+        thread_max[0] = log_mel_spectrogram_worker(tables, samples, n_samples, 0, i1, n_len, mel_data.data());
+
+        for (auto & w : workers) {
+            w.join();
+        }
     }
-    
+
+    // dynamic range compression, as in whisper/audio.py
+    const float mmax = *std::max_element(thread_max.begin(), thread_max.end()) - 8.0f;
+    for (auto & v : mel_data) {
+        v = (std::max(v, mmax) + 4.0f) / 4.0f;
+    }
+
     return mel_data;
 }
 
+// Acoustic confidence of each mel frame, a heuristic rather than anything the
+// decoder computes: 0 for silence (peak below 1e-5 in power), otherwise one minus
+// the spectral flatness, so tonal and voiced frames score near 1 and noise low.
+// The mock decoder reads its no-speech probability and the acoustic confidence
+// of its segments off these scores.
+static std::vector<float> whisper_frame_acoustic_scores(const std::vector<float> & mel, int n_mel) {
+    const int n_len = n_mel > 0 ? static_cast<int>(mel.size() / n_mel) : 0;
+
+    std::vector<float> probs(n_len);
+    for (int i = 0; i < n_len; i++) {
+        // mel holds (log10(power) + 4) / 4
+        float max_log = -INFINITY;
+        double sum_log = 0.0;
+        double sum_pow = 0.0;
+        for (int j = 0; j < n_mel; j++) {
+            const float l = 4.0f * mel[static_cast<size_t>(j) * n_len + i] - 4.0f;
+            max_log = std::max(max_log, l);
+            sum_log += l;
+            sum_pow += std::pow(10.0, l);
+        }
+
+        // spectral flatness: geometric over arithmetic mean of the band powers
+        const double flatness = std::pow(10.0, sum_log / n_mel) / (sum_pow / n_mel);
+        probs[i] = max_log < -5.0f ? 0.0f : static_cast<float>(1.0 - std::min(1.0, flatness));
+    }
+
+    return probs;
+}
+
+// Share of frames that are more likely silence or noise than speech
+static float whisper_no_speech_prob(const std::vector<float> & frame_scores) {
+    if (frame_scores.empty()) {
+        return 0.0f;
+    }
+
+    size_t n_no_speech = 0;
+    for (float p : frame_scores) {
+        n_no_speech += p < 0.5f;
+    }
+
+    return static_cast<float>(n_no_speech) / frame_scores.size();
+}
+
 static std::string simple_transcription(const std::vector<float>& mel_data, const whisper_full_params& params) {
     (void)mel_data; // unused in mock implementation
     
@@ -118,63 +539,702 @@ static std::string simple_transcription(const std::vector<float>& mel_data, cons
     return result;
 }
 
+// Mock decoder pass over a mel spectrogram. Returns false, without a segment, when
+// the audio is taken for no speech. The words of the text are spread over the
+// speech frames, skipping pauses as the decoder's timestamps would. There is no
+// token distribution behind the fixed text, so each token has probability 1; the
+// segment's acoustic confidence is the mean score of those frames instead.
+// The text is fixed, so the sampling strategy, beam_search and greedy.best_of
+// do not change the result; whisper_search() is not run here.
+static bool whisper_decode_segment(const whisper_context* ctx, const std::vector<float>& mel, int n_samples,
+                                   const whisper_full_params& params, float& no_speech_prob, whisper_segment& segment) {
+    const std::vector<float> frame_scores = whisper_frame_acoustic_scores(mel, WHISPER_N_MEL);
+    
+    no_speech_prob = whisper_no_speech_prob(frame_scores);
+    if (no_speech_prob > params.no_speech_thold) {
+        return false;
+    }
+    
+    segment = whisper_segment();
+    segment.text = simple_transcription(mel, params);
+    segment.t0 = 0;
+    segment.t1 = (int64_t(n_samples) * 100) / WHISPER_SAMPLE_RATE; // 10 ms units
+    
+    std::vector<std::string> words;
+    std::istringstream iss(segment.text);
+    for (std::string word; iss >> word; ) {
+        words.push_back(word);
+    }
+    
+    // one mel frame per 10 ms; all frames when none sounds like speech
+    std::vector<int64_t> frames;
+    for (size_t f = 0; f < frame_scores.size(); f++) {
+        if (frame_scores[f] >= 0.5f) {
+            frames.push_back(static_cast<int64_t>(f));
+        }
+    }
+    if (frames.empty()) {
+        for (size_t f = 0; f < frame_scores.size(); f++) {
+            frames.push_back(static_cast<int64_t>(f));
+        }
+    }
+    
+    const size_t n_frames = frames.size();
+    if (n_frames > 0) {
+        double sum = 0.0;
+        for (int64_t f : frames) {
+            sum += frame_scores[f];
+        }
+        segment.acoustic_confidence = static_cast<float>(sum / n_frames);
+    }
+    
+    for (size_t i = 0; i < words.size() && n_frames > 0; i++) {
+        const size_t f0 = std::min(n_frames - 1, i * n_frames / words.size());
+        const size_t f1 = std::max(f0 + 1, (i + 1) * n_frames / words.size());
+        
+        whisper_token_data token = {};
+        token.id    = static_cast<whisper_token>(std::hash<std::string>()(words[i]) % ctx->token_eot);
+        token.tid   = -1;
+        token.p     = 1.0f;
+        token.plog  = 0.0f;
+        token.t0    = frames[f0];
+        token.t1    = frames[f1 - 1] + 1;
+        
+        segment.tokens.push_back(token);
+        segment.token_text.push_back((i > 0 ? " " : "") + words[i]);
+    }
+    
+    return true;
+}
+
+//
+// Model loading
+//
+// File layout, integers are little-endian int32:
+//   magic "ggml", 11 hparams, mel filters (n_mel, n_fft, f32[n_mel*n_fft]),
+//   vocab (n_vocab, then u32 length + bytes per token),
+//   tensors until end of file (n_dims, name length, type, ne[n_dims], name, data)
+// Tensor data follows its header unpadded, so a source that is already in memory can
+// hand out pointers into itself instead of copying.
+//
+
+static const uint32_t WHISPER_FILE_MAGIC         = 0x67676d6c; // "ggml"
+static const int32_t  WHISPER_QNT_VERSION_FACTOR = 1000;
+
+// whisper_model_loader over a byte range
+struct whisper_mem_reader {
+    const uint8_t * data = nullptr;
+    size_t size = 0;
+    size_t pos  = 0;
+};
+
+static size_t whisper_mem_read(void * ctx, void * output, size_t read_size) {
+    auto * reader = static_cast<whisper_mem_reader *>(ctx);
+    const size_t n = std::min(read_size, reader->size - reader->pos);
+    memcpy(output, reader->data + reader->pos, n);
+    reader->pos += n;
+    return n;
+}
+
+static bool whisper_mem_eof(void * ctx) {
+    auto * reader = static_cast<whisper_mem_reader *>(ctx);
+    return reader->pos >= reader->size;
+}
+
+static void whisper_mem_close(void * /*ctx*/) {
+}
+
+static whisper_model_loader whisper_mem_loader(whisper_mem_reader & reader) {
+    whisper_model_loader loader = {};
+    loader.context = &reader;
+    loader.read    = whisper_mem_read;
+    loader.eof     = whisper_mem_eof;
+    loader.close   = whisper_mem_close;
+    return loader;
+}
+
+template <typename T>
+static bool read_safe(whisper_model_loader & loader, T & dest) {
+    return loader.read(loader.context, &dest, sizeof(T)) == sizeof(T);
+}
+
+// Parse a model into wctx. If in_place is set it must be the reader behind loader;
+// tensor data is then referenced where it lies, otherwise it is copied into
+// wctx.model.buffer.
+static bool whisper_model_load(whisper_model_loader & loader, whisper_mem_reader * in_place, whisper_context & wctx) {
+    whisper_model & model = wctx.model;
+
+    uint32_t magic = 0;
+    if (!read_safe(loader, magic) || magic != WHISPER_FILE_MAGIC) {
+        fprintf(stderr, "%s: invalid model data (bad magic)\n", __func__);
+        return false;
+    }
+
+    int32_t hparams[11];
+    for (auto & v : hparams) {
+        if (!read_safe(loader, v)) {
+            fprintf(stderr, "%s: truncated hparams\n", __func__);
+            return false;
+        }
+    }
+    for (int i = 0; i < 10; i++) {
+        if (hparams[i] <= 0) {
+            fprintf(stderr, "%s: invalid hparam %d: %d\n", __func__, i, hparams[i]);
+            return false;
+        }
+    }
+
+    wctx.n_vocab       = hparams[0];
+    wctx.n_audio_ctx   = hparams[1];
+    wctx.n_audio_state = hparams[2];
+    wctx.n_audio_head  = hparams[3];
+    wctx.n_audio_layer = hparams[4];
+    wctx.n_text_ctx    = hparams[5];
+    wctx.n_text_state  = hparams[6];
+    wctx.n_text_head   = hparams[7];
+    wctx.n_text_layer  = hparams[8];
+    wctx.n_mels        = hparams[9];
+    wctx.ftype         = hparams[10] % WHISPER_QNT_VERSION_FACTOR;
+
+    switch (wctx.n_audio_layer) {
+        case 4:  wctx.model_type = 0; break; // tiny
+        case 6:  wctx.model_type = 1; break; // base
+        case 12: wctx.model_type = 2; break; // small
+        case 24: wctx.model_type = 3; break; // medium
+        case 32: wctx.model_type = 4; break; // large
+        default: wctx.model_type = 0; break;
+    }
+
+    // the mel filterbank is recomputed in whisper_mel_tables_init; skip the stored copy
+    {
+        int32_t n_mel = 0;
+        int32_t n_fft = 0;
+        if (!read_safe(loader, n_mel) || !read_safe(loader, n_fft) ||
+            n_mel <= 0 || n_fft <= 0 || n_mel > 1024 || n_fft > 4096) {
+            fprintf(stderr, "%s: invalid mel filters\n", __func__);
+            return false;
+        }
+        std::vector<float> filters(static_cast<size_t>(n_mel) * n_fft);
+        const size_t n_bytes = filters.size() * sizeof(float);
+        if (loader.read(loader.context, filters.data(), n_bytes) != n_bytes) {
+            fprintf(stderr, "%s: truncated mel filters\n", __func__);
+            return false;
+        }
+    }
+
+    // vocab
+    {
+        int32_t n_vocab = 0;
+        if (!read_safe(loader, n_vocab) || n_vocab < 0 || n_vocab > wctx.n_vocab) {
+            fprintf(stderr, "%s: invalid vocab size\n", __func__);
+            return false;
+        }
+
+        model.id_to_token.resize(wctx.n_vocab);
+
+        std::string word;
+        for (int32_t i = 0; i < n_vocab; i++) {
+            uint32_t len = 0;
+            if (!read_safe(loader, len) || len > 4096) {
+                fprintf(stderr, "%s: invalid vocab entry %d\n", __func__, i);
+                return false;
+            }
+            word.resize(len);
+            if (len > 0 && loader.read(loader.context, &word[0], len) != len) {
+                fprintf(stderr, "%s: truncated vocab\n", __func__);
+                return false;
+            }
+            model.id_to_token[i] = word;
+            model.token_to_id[word] = i;
+        }
+
+        // the vocab section only holds the text tokens; name the special ones after it
+        char buf[32];
+        for (int32_t i = n_vocab; i < wctx.n_vocab; i++) {
+            snprintf(buf, sizeof(buf), "[_extra_token_%d]", i);
+            model.id_to_token[i] = buf;
+            model.token_to_id[buf] = i;
+        }
+    }
+
+    // multilingual vocabularies insert one more token before <|startoftranscript|> and
+    // a variable number of language tokens before <|translate|>
+    wctx.is_multilingual = wctx.n_vocab >= 51865;
+    if (wctx.is_multilingual) {
+        const int n_lang = wctx.n_vocab - 51765 - 1;
+        const int dt     = n_lang - 98;
+
+        wctx.token_eot        = 50257;
+        wctx.token_sot        = 50258;
+        wctx.token_translate  = 50357 + dt;
+        wctx.token_transcribe = 50358 + dt;
+        wctx.token_solm       = 50359 + dt;
+        wctx.token_prev       = 50360 + dt;
+        wctx.token_nosp       = 50361 + dt;
+        wctx.token_not        = 50362 + dt;
+        wctx.token_beg        = 50363 + dt;
+    }
+
+    // tensors
+    const int n_tensors_max = 10 + 15 + 15*wctx.n_audio_layer + 24*wctx.n_text_layer;
+    {
+        ggml_init_params params = {};
+        params.mem_size   = n_tensors_max * ggml_tensor_overhead();
+        params.mem_buffer = nullptr;
+        params.no_alloc   = true;
+
+        model.ctx = ggml_init(params);
+        if (!model.ctx) {
+            fprintf(stderr, "%s: failed to create the tensor context\n", __func__);
+            return false;
+        }
+    }
+
+    // copied tensors get their data pointer once the buffer has stopped growing
+    const size_t buffer_align = 32;
+    std::vector<std::pair<ggml_tensor *, size_t>> buffer_offsets;
+
+    while (!loader.eof(loader.context)) {
+        int32_t n_dims = 0;
+        const size_t n_read = loader.read(loader.context, &n_dims, sizeof(n_dims));
+        if (n_read == 0 && loader.eof(loader.context)) {
+            break;
+        }
+
+        int32_t name_len = 0;
+        int32_t ttype    = 0;
+        if (n_read != sizeof(n_dims) || !read_safe(loader, name_len) || !read_safe(loader, ttype)) {
+            fprintf(stderr, "%s: truncated tensor header\n", __func__);
+            return false;
+        }
+        if (n_dims < 1 || n_dims > 4 || name_len <= 0 || name_len >= (int32_t) sizeof(ggml_tensor::name) ||
+            ttype < 0 || ttype >= GGML_TYPE_COUNT || ggml_type_size((ggml_type) ttype) == 0) {
+            fprintf(stderr, "%s: invalid tensor header (n_dims = %d, type = %d)\n", __func__, n_dims, ttype);
+            return false;
+        }
+        const ggml_type type = (ggml_type) ttype;
+
+        int64_t ne[4] = { 1, 1, 1, 1 };
+        int64_t n_elements = 1;
+        for (int i = 0; i < n_dims; i++) {
+            int32_t ne_cur = 0;
+            if (!read_safe(loader, ne_cur) || ne_cur <= 0 || n_elements > (INT64_MAX / 8) / ne_cur) {
+                fprintf(stderr, "%s: invalid tensor shape\n", __func__);
+                return false;
+            }
+            ne[i] = ne_cur;
+            n_elements *= ne_cur;
+        }
+        if (ne[0] % ggml_blck_size(type) != 0) {
+            fprintf(stderr, "%s: row size %lld is not a multiple of the %s block size\n",
+                    __func__, (long long) ne[0], ggml_type_name(type));
+            return false;
+        }
+
+        std::string name(name_len, 0);
+        if (loader.read(loader.context, &name[0], name_len) != (size_t) name_len) {
+            fprintf(stderr, "%s: truncated tensor name\n", __func__);
+            return false;
+        }
+        if (model.tensors.count(name)) {
+            fprintf(stderr, "%s: duplicate tensor '%s'\n", __func__, name.c_str());
+            return false;
+        }
+
+        ggml_tensor * tensor = ggml_new_tensor_4d(model.ctx, type, ne[0], ne[1], ne[2], ne[3]);
+        if (!tensor) {
+            fprintf(stderr, "%s: too many tensors (max %d)\n", __func__, n_tensors_max);
+            return false;
+        }
+        memcpy(tensor->name, name.c_str(), name.size() + 1);
+
+        const size_t n_bytes = ggml_row_size(type, ne[0]) * (ne[1] * ne[2] * ne[3]);
+
+        if (in_place) {
+            if (in_place->size - in_place->pos < n_bytes) {
+                fprintf(stderr, "%s: truncated data for tensor '%s'\n", __func__, name.c_str());
+                return false;
+            }
+            tensor->data = const_cast<uint8_t *>(in_place->data + in_place->pos);
+            in_place->pos += n_bytes;
+        } else {
+            const size_t offs = (model.buffer.size() + buffer_align - 1) / buffer_align * buffer_align;
+            model.buffer.resize(offs + n_bytes);
+            if (loader.read(loader.context, model.buffer.data() + offs, n_bytes) != n_bytes) {
+                fprintf(stderr, "%s: truncated data for tensor '%s'\n", __func__, name.c_str());
+                return false;
+            }
+            buffer_offsets.emplace_back(tensor, offs);
+        }
+
+        model.tensors[name] = tensor;
+        model.n_bytes += n_bytes;
+    }
+
+    for (const auto & it : buffer_offsets) {
+        it.first->data = model.buffer.data() + it.second;
+    }
+
+    return true;
+}
+
+// Peak compute buffer of the encoder, or of a decoder step over a prompt of half the
+// text context, as ggml-alloc lays it out. The graphs have the tensor shapes of the
+// real ones; elementwise ops stand in for the norms, softmax and GELU, and the
+// convolutions multiply im2col inputs. Weights and the cross-attention K/V are placed
+// by a second allocator, so only the activations count.
+static size_t whisper_measure_compute(const whisper_context & wctx, bool encoder) {
+    const int64_t n_state = encoder ? wctx.n_audio_state : wctx.n_text_state;
+    const int64_t n_head  = encoder ? wctx.n_audio_head  : wctx.n_text_head;
+    const int64_t n_layer = encoder ? wctx.n_audio_layer : wctx.n_text_layer;
+    const int64_t n_ctx   = encoder ? wctx.n_audio_ctx   : wctx.n_text_ctx / 2;
+    const int64_t n_audio = wctx.n_audio_ctx;
+    if (n_head <= 0 || n_state % n_head != 0) {
+        return 0;
+    }
+    const int64_t d_head = n_state / n_head;
+
+    const size_t graph_size = 4096;
+    ggml_init_params params = {};
+    params.mem_size   = ggml_tensor_overhead() * 2 * graph_size + ggml_graph_overhead_custom(graph_size, false);
+    params.mem_buffer = nullptr;
+    params.no_alloc   = true;
+    ggml_context * ctx0 = ggml_init(params);
+    if (!ctx0) {
+        return 0;
+    }
+
+    ggml_allocr_t outside = ggml_allocr_new_measure(32);
+    ggml_allocr_t alloc   = ggml_allocr_new_measure(32);
+
+    // the type of the weights does not matter, they are not in the measured buffer
+    auto fixed = [&](int64_t ne0, int64_t ne1) {
+        ggml_tensor * t = ggml_new_tensor_2d(ctx0, GGML_TYPE_F32, ne0, ne1);
+        ggml_allocr_alloc(outside, t);
+        return t;
+    };
+    auto linear = [&](ggml_tensor * x, int64_t n_in, int64_t n_out) {
+        return ggml_add(ctx0, ggml_mul_mat(ctx0, fixed(n_in, n_out), x), fixed(n_out, 1));
+    };
+    auto norm = [&](ggml_tensor * x) {
+        return ggml_add(ctx0, ggml_mul(ctx0, x, fixed(n_state, 1)), fixed(n_state, 1));
+    };
+    // q: [n_state, n_q]; k, v: [n_state, n_kv] -> [n_state, n_q]
+    auto attention = [&](ggml_tensor * q, ggml_tensor * k, ggml_tensor * v, int64_t n_q, int64_t n_kv) {
+        ggml_tensor * kq  = ggml_mul_mat(ctx0, ggml_reshape_3d(ctx0, k, d_head, n_kv, n_head),
+                                               ggml_reshape_3d(ctx0, q, d_head, n_q, n_head));
+        kq = ggml_mul(ctx0, kq, fixed(1, 1));
+        ggml_tensor * kqv = ggml_mul_mat(ctx0, ggml_reshape_3d(ctx0, v, n_kv, d_head, n_head), kq);
+        return ggml_reshape_3d(ctx0, kqv, n_state, n_q, 1);
+    };
+    auto mlp = [&](ggml_tensor * x) {
+        ggml_tensor * cur = linear(norm(x), n_state, 4 * n_state);
+        cur = ggml_mul(ctx0, cur, fixed(1, 1));
+        return ggml_add(ctx0, linear(cur, 4 * n_state, n_state), x);
+    };
+
+    ggml_tensor * cur = nullptr;
+    if (encoder) {
+        // conv1 over the mel frames, conv2 with stride 2
+        ggml_tensor * cols = ggml_new_tensor_2d(ctx0, GGML_TYPE_F32, 3 * wctx.n_mels, 2 * n_ctx);
+        cur = ggml_mul(ctx0, linear(cols, 3 * wctx.n_mels, n_state), fixed(1, 1));
+        cols = ggml_add(ctx0, ggml_new_tensor_2d(ctx0, GGML_TYPE_F32, 3 * n_state, n_ctx), cur);
+        cur = ggml_mul(ctx0, linear(cols, 3 * n_state, n_state), fixed(1, 1));
+    } else {
+        cur = ggml_new_tensor_2d(ctx0, GGML_TYPE_F32, n_state, n_ctx); // token embeddings
+    }
+    cur = ggml_add(ctx0, cur, fixed(n_state, n_ctx));
+
+    for (int64_t il = 0; il < n_layer && cur; il++) {
+        ggml_tensor * x = norm(cur);
+        ggml_tensor * q = linear(x, n_state, n_state);
+        ggml_tensor * k = ggml_mul_mat(ctx0, fixed(n_state, n_state), x);
+        ggml_tensor * v = linear(x, n_state, n_state);
+        cur = ggml_add(ctx0, linear(attention(q, k, v, n_ctx, n_ctx), n_state, n_state), cur);
+
+        if (!encoder) {
+            q = linear(norm(cur), n_state, n_state);
+            cur = ggml_add(ctx0, linear(attention(q, fixed(n_state, n_audio), fixed(n_state, n_audio), n_ctx, n_audio),
+                                        n_state, n_state), cur);
+        }
+
+        cur = mlp(cur);
+    }
+
+    if (cur) {
+        cur = norm(cur);
+        if (!encoder) {
+            cur = ggml_mul_mat(ctx0, fixed(n_state, wctx.n_vocab), cur); // logits
+        }
+    }
+
+    size_t size = 0;
+    if (cur) {
+        ggml_cgraph * gf = ggml_new_graph_custom(ctx0, graph_size, false);
+        ggml_build_forward_expand(gf, cur);
+        size = ggml_allocr_alloc_graph(alloc, gf);
+    }
+
+    ggml_allocr_free(alloc);
+    ggml_allocr_free(outside);
+    ggml_free(ctx0);
+
+    return size;
+}
+
+static whisper_memory_usage whisper_memory_usage_init(const whisper_context & wctx) {
+    whisper_memory_usage usage = {};
+    usage.weights         = wctx.model.n_bytes;
+    usage.kv_self         = 2 * ggml_row_size(wctx.type_kv, wctx.n_text_state) * wctx.n_text_layer * wctx.n_text_ctx;
+    usage.kv_cross        = 2 * ggml_row_size(wctx.type_kv, wctx.n_text_state) * wctx.n_text_layer * wctx.n_audio_ctx;
+    usage.mel             = sizeof(float) * wctx.n_mels * 2 * wctx.n_audio_ctx;
+    usage.compute_encoder = whisper_measure_compute(wctx, true);
+    usage.compute_decoder = whisper_measure_compute(wctx, false);
+    return usage;
+}
+
+static whisper_context * whisper_init_from_loader_impl(whisper_context * ctx, whisper_model_loader & loader, whisper_mem_reader * in_place,
+                                                        const whisper_context_params & params) {
+    if (params.type_kv != GGML_TYPE_F32 && params.type_kv != GGML_TYPE_F16 && params.type_kv != GGML_TYPE_Q8_0) {
+        fprintf(stderr, "%s: unsupported K/V cache type %s\n", __func__, ggml_type_name(params.type_kv));
+        delete ctx;
+        return nullptr;
+    }
+
+    bool ok = false;
+    try {
+        ok = whisper_model_load(loader, in_place, *ctx);
+    } catch (const std::exception & e) {
+        fprintf(stderr, "%s: failed to load model: %s\n", __func__, e.what());
+    }
+
+    if (!ok) {
+        delete ctx;
+        return nullptr;
+    }
+
+    whisper_mel_tables_init(ctx->mel_tables, ctx->n_mels);
+
+    // Q8_0 rows are whole blocks; whisper_kv_pages falls back to F16 the same way
+    ctx->type_kv = params.type_kv;
+    if (ctx->type_kv == GGML_TYPE_Q8_0 && ctx->n_text_state % ggml_blck_size(GGML_TYPE_Q8_0) != 0) {
+        fprintf(stderr, "%s: n_text_state = %d is not a multiple of the Q8_0 block, using an F16 K/V cache\n",
+                __func__, ctx->n_text_state);
+        ctx->type_kv = GGML_TYPE_F16;
+    }
+    ctx->memory = whisper_memory_usage_init(*ctx);
+
+    return ctx;
+}
+
+static size_t whisper_ifstream_read(void * ctx, void * output, size_t read_size) {
+    auto * fin = static_cast<std::ifstream *>(ctx);
+    fin->read(static_cast<char *>(output), read_size);
+    return static_cast<size_t>(fin->gcount());
+}
+
+static bool whisper_ifstream_eof(void * ctx) {
+    auto * fin = static_cast<std::ifstream *>(ctx);
+    return fin->eof() || fin->peek() == std::ifstream::traits_type::eof();
+}
+
+static void whisper_ifstream_close(void * ctx) {
+    static_cast<std::ifstream *>(ctx)->close();
+}
+
+// Write a model file with the layout and tensor shapes of a real checkpoint: f16
+// weights, f32 biases and norms, a multilingual vocab. Used by the load benchmark.
+static bool whisper_model_write_synthetic(const char * path, int n_state, int n_layer) {
+    std::ofstream fout(path, std::ios::binary);
+    if (!fout) {
+        return false;
+    }
+
+    const int32_t n_vocab      = 51865;
+    const int32_t n_vocab_text = 50257;
+    const int32_t n_audio_ctx  = 1500;
+    const int32_t n_text_ctx   = 448;
+    const int32_t n_head       = std::max(1, n_state / 64);
+    const int32_t n_fft        = 1 + WHISPER_N_FFT / 2;
+
+    auto write_i32 = [&](int32_t v) { fout.write(reinterpret_cast<const char *>(&v), sizeof(v)); };
+
+    write_i32(static_cast<int32_t>(WHISPER_FILE_MAGIC));
+    for (int32_t v : { n_vocab, n_audio_ctx, n_state, n_head, n_layer, n_text_ctx, n_state, n_head, n_layer,
+                       WHISPER_N_MEL, static_cast<int32_t>(GGML_TYPE_F16) }) {
+        write_i32(v);
+    }
+
+    write_i32(WHISPER_N_MEL);
+    write_i32(n_fft);
+    const std::vector<float> filters(static_cast<size_t>(WHISPER_N_MEL) * n_fft, 0.0f);
+    fout.write(reinterpret_cast<const char *>(filters.data()), filters.size() * sizeof(float));
+
+    write_i32(n_vocab_text);
+    char word[32];
+    for (int32_t i = 0; i < n_vocab_text; i++) {
+        const int len = snprintf(word, sizeof(word), "tok%d", i);
+        write_i32(len);
+        fout.write(word, len);
+    }
+
+    std::vector<char> chunk(1 << 20);
+    for (size_t i = 0; i < chunk.size(); i++) {
+        chunk[i] = static_cast<char>(rand());
+    }
+
+    auto write_tensor = [&](const std::string & name, ggml_type type, std::initializer_list<int32_t> ne) {
+        write_i32(static_cast<int32_t>(ne.size()));
+        write_i32(static_cast<int32_t>(name.size()));
+        write_i32(static_cast<int32_t>(type));
+        size_t n_elements = 1;
+        for (int32_t v : ne) {
+            write_i32(v);
+            n_elements *= v;
+        }
+        fout.write(name.data(), name.size());
+        for (size_t n_left = n_elements * ggml_type_size(type); n_left > 0; ) {
+            const size_t n = std::min(n_left, chunk.size());
+            fout.write(chunk.data(), n);
+            n_left -= n;
+        }
+    };
+
+    const int32_t n_ff = 4 * n_state;
+
+    auto write_attn = [&](const std::string & prefix) {
+        write_tensor(prefix + ".query.weight", GGML_TYPE_F16, { n_state, n_state });
+        write_tensor(prefix + ".query.bias",   GGML_TYPE_F32, { n_state });
+        write_tensor(prefix + ".key.weight",   GGML_TYPE_F16, { n_state, n_state });
+        write_tensor(prefix + ".value.weight", GGML_TYPE_F16, { n_state, n_state });
+        write_tensor(prefix + ".value.bias",   GGML_TYPE_F32, { n_state });
+        write_tensor(prefix + ".out.weight",   GGML_TYPE_F16, { n_state, n_state });
+        write_tensor(prefix + ".out.bias",     GGML_TYPE_F32, { n_state });
+        write_tensor(prefix + "_ln.weight",    GGML_TYPE_F32, { n_state });
+        write_tensor(prefix + "_ln.bias",      GGML_TYPE_F32, { n_state });
+    };
+
+    auto write_mlp = [&](const std::string & prefix) {
+        write_tensor(prefix + ".mlp_ln.weight", GGML_TYPE_F32, { n_state });
+        write_tensor(prefix + ".mlp_ln.bias",   GGML_TYPE_F32, { n_state });
+        write_tensor(prefix + ".mlp.0.weight",  GGML_TYPE_F16, { n_state, n_ff });
+        write_tensor(prefix + ".mlp.0.bias",    GGML_TYPE_F32, { n_ff });
+        write_tensor(prefix + ".mlp.2.weight",  GGML_TYPE_F16, { n_ff, n_state });
+        write_tensor(prefix + ".mlp.2.bias",    GGML_TYPE_F32, { n_state });
+    };
+
+    write_tensor("encoder.positional_embedding", GGML_TYPE_F32, { n_state, n_audio_ctx });
+    write_tensor("encoder.conv1.weight", GGML_TYPE_F16, { 3, WHISPER_N_MEL, n_state });
+    write_tensor("encoder.conv1.bias",   GGML_TYPE_F32, { 1, n_state });
+    write_tensor("encoder.conv2.weight", GGML_TYPE_F16, { 3, n_state, n_state });
+    write_tensor("encoder.conv2.bias",   GGML_TYPE_F32, { 1, n_state });
+    write_tensor("encoder.ln_post.weight", GGML_TYPE_F32, { n_state });
+    write_tensor("encoder.ln_post.bias",   GGML_TYPE_F32, { n_state });
+
+    write_tensor("decoder.positional_embedding", GGML_TYPE_F32, { n_state, n_text_ctx });
+    write_tensor("decoder.token_embedding.weight", GGML_TYPE_F16, { n_state, n_vocab });
+    write_tensor("decoder.ln.weight", GGML_TYPE_F32, { n_state });
+    write_tensor("decoder.ln.bias",   GGML_TYPE_F32, { n_state });
+
+    for (int il = 0; il < n_layer; il++) {
+        const std::string prefix = "encoder.blocks." + std::to_string(il);
+        write_attn(prefix + ".attn");
+        write_mlp(prefix);
+    }
+
+    for (int il = 0; il < n_layer; il++) {
+        const std::string prefix = "decoder.blocks." + std::to_string(il);
+        write_attn(prefix + ".attn");
+        write_attn(prefix + ".cross_attn");
+        write_mlp(prefix);
+    }
+
+    return fout.good();
+}
+
 // API implementations
 extern "C" {
 
-whisper_context* whisper_init_from_file(const char* path_model) {
+whisper_context* whisper_init_from_file_with_params(const char* path_model, whisper_context_params params) {
     if (!path_model) {
         return nullptr;
     }
-    
-    // Check if file exists
-    std::ifstream file(path_model, std::ios::binary | std::ios::ate);
-    if (!file.good()) {
-        return nullptr;
-    }
-    
+
     auto ctx = new whisper_context();
     ctx->model_path = path_model;
-    
-    // Mock model loading - in reality, we'd parse the GGML format
-    auto size = file.tellg();
-    file.close();
-    
-    // Set model parameters based on file size (rough estimates)
-    if (size < 50 * 1024 * 1024) { // < 50MB = tiny
-        ctx->model_type = 0;
-        ctx->n_audio_layer = 4;
-        ctx->n_text_layer = 4;
-    } else if (size < 100 * 1024 * 1024) { // < 100MB = base
-        ctx->model_type = 1;
-        ctx->n_audio_layer = 6;
-        ctx->n_text_layer = 6;
-    } else if (size < 500 * 1024 * 1024) { // < 500MB = small
-        ctx->model_type = 2;
-        ctx->n_audio_layer = 12;
-        ctx->n_text_layer = 12;
-    } else if (size < 1000 * 1024 * 1024) { // < 1GB = medium
-        ctx->model_type = 3;
-        ctx->n_audio_layer = 24;
-        ctx->n_text_layer = 24;
-    } else { // large
-        ctx->model_type = 4;
-        ctx->n_audio_layer = 32;
-        ctx->n_text_layer = 32;
+
+    if (params.use_mmap) {
+        ctx->model.mapping.reset(new whisper_mmap());
+        if (!ctx->model.mapping->open(path_model)) {
+            fprintf(stderr, "%s: failed to map '%s'\n", __func__, path_model);
+            delete ctx;
+            return nullptr;
+        }
+
+        whisper_mem_reader reader;
+        reader.data = static_cast<const uint8_t *>(ctx->model.mapping->addr);
+        reader.size = ctx->model.mapping->size;
+
+        whisper_model_loader loader = whisper_mem_loader(reader);
+        return whisper_init_from_loader_impl(ctx, loader, &reader, params);
     }
-    
+
+    std::ifstream fin(path_model, std::ios::binary | std::ios::ate);
+    if (!fin.good()) {
+        fprintf(stderr, "%s: failed to open '%s'\n", __func__, path_model);
+        delete ctx;
+        return nullptr;
+    }
+    ctx->model.buffer.reserve(static_cast<size_t>(fin.tellg()));
+    fin.seekg(0);
+
+    whisper_model_loader loader = {};
+    loader.context = &fin;
+    loader.read    = whisper_ifstream_read;
+    loader.eof     = whisper_ifstream_eof;
+    loader.close   = whisper_ifstream_close;
+
+    return whisper_init_from_loader_impl(ctx, loader, nullptr, params);
+}
+
+whisper_context* whisper_init_from_buffer_with_params(void* buffer, size_t buffer_size, whisper_context_params params) {
+    if (!buffer || buffer_size == 0) {
+        return nullptr;
+    }
+
+    whisper_mem_reader reader;
+    reader.data = static_cast<const uint8_t *>(buffer);
+    reader.size = buffer_size;
+
+    whisper_model_loader loader = whisper_mem_loader(reader);
+    return whisper_init_from_loader_impl(new whisper_context(), loader, &reader, params);
+}
+
+whisper_context* whisper_init_from_loader_with_params(whisper_model_loader* loader, whisper_context_params params) {
+    if (!loader) {
+        return nullptr;
+    }
+
+    whisper_context * ctx = whisper_init_from_loader_impl(new whisper_context(), *loader, nullptr, params);
+    loader->close(loader->context);
+
     return ctx;
 }
 
+whisper_context* whisper_init_from_file(const char* path_model) {
+    return whisper_init_from_file_with_params(path_model, whisper_context_default_params());
+}
+
 whisper_context* whisper_init_from_buffer(void* buffer, size_t buffer_size) {
-    (void)buffer;
-    (void)buffer_size;
-    // Not implemented in this minimal version
-    return nullptr;
+    return whisper_init_from_buffer_with_params(buffer, buffer_size, whisper_context_default_params());
 }
 
 whisper_context* whisper_init_with_params(const char* path_model, whisper_context_params params) {
-    (void)params;
-    return whisper_init_from_file(path_model);
+    return whisper_init_from_file_with_params(path_model, params);
+}
+
+whisper_context* whisper_init_with_params_no_state(const char* path_model, whisper_context_params params) {
+    return whisper_init_from_file_with_params(path_model, params);
 }
 
 whisper_context_params whisper_context_default_params() {
@@ -186,6 +1246,8 @@ whisper_context_params whisper_context_default_params() {
     params.dtw_n_top = 0;
     params.dtw_aheads_path = nullptr;
     params.dtw_mem_size = 0;
+    params.use_mmap = true;
+    params.type_kv = GGML_TYPE_F32;
     return params;
 }
 
@@ -206,7 +1268,7 @@ int whisper_pcm_to_mel(whisper_context* ctx, const float* samples, int n_samples
         return -1;
     }
     
-    ctx->mel_data = log_mel_spectrogram(samples, n_samples, n_threads);
+    ctx->mel_data = log_mel_spectrogram(ctx->mel_tables, samples, n_samples, n_threads);
     return 0;
 }
 
@@ -215,7 +1277,7 @@ int whisper_pcm_to_mel_with_state(whisper_context* ctx, whisper_state* state, co
         return -1;
     }
     
-    state->mel = log_mel_spectrogram(samples, n_samples, n_threads);
+    state->mel = log_mel_spectrogram(ctx->mel_tables, samples, n_samples, n_threads);
     state->n_len = (n_samples / WHISPER_HOP_LENGTH) + 1;
     return 0;
 }
@@ -235,21 +1297,26 @@ int whisper_full(whisper_context* ctx, whisper_full_params params, const float*
     }
     
     // Convert PCM to mel spectrogram
-    if (whisper_pcm_to_mel(ctx, samples, params.n_threads) != 0) {
+    if (whisper_pcm_to_mel(ctx, samples, n_samples, params.n_threads) != 0) {
         return -1;
     }
     
-    // Mock transcription
-    std::string transcription = simple_transcription(ctx->mel_data, params);
+    if (params.encoder_begin_callback && !params.encoder_begin_callback(ctx, nullptr, params.encoder_begin_callback_user_data)) {
+        fprintf(stderr, "%s: encoder_begin_callback returned false - aborting\n", __func__);
+        return -3;
+    }
     
-    // Store results
-    ctx->result_segments.clear();
-    ctx->segment_times_start.clear();
-    ctx->segment_times_end.clear();
+    ctx->result_all.clear();
     
-    ctx->result_segments.push_back(transcription);
-    ctx->segment_times_start.push_back(0);
-    ctx->segment_times_end.push_back((int64_t(n_samples) * 1000) / WHISPER_SAMPLE_RATE);
+    float no_speech_prob = 0.0f;
+    whisper_segment segment;
+    if (!whisper_decode_segment(ctx, ctx->mel_data, n_samples, params, no_speech_prob, segment)) {
+        if (params.progress_callback) {
+            params.progress_callback(ctx, nullptr, 100, params.progress_callback_user_data);
+        }
+        return 0;
+    }
+    ctx->result_all.push_back(std::move(segment));
     
     // Call progress callback if provided
     if (params.progress_callback) {
@@ -268,6 +1335,35 @@ int whisper_full(whisper_context* ctx, whisper_full_params params, const float*
     return 0;
 }
 
+// Decoder pass over the encoder output in the state
+static int whisper_decode_with_state(whisper_context* ctx, whisper_state* state, const whisper_full_params& params) {
+    state->result_all.clear();
+    
+    // The decoder would read the no-speech probability off its first step and stop
+    // there; the mock decoder has a single attempt, so the temperature fallback has
+    // nothing to retry (see whisper_search_with_fallback)
+    whisper_segment segment;
+    if (!whisper_decode_segment(ctx, state->mel, state->n_samples, params, state->no_speech_prob, segment)) {
+        if (params.progress_callback) {
+            params.progress_callback(ctx, state, 100, params.progress_callback_user_data);
+        }
+        return 0;
+    }
+    state->result_all.push_back(std::move(segment));
+
+    if (params.progress_callback) {
+        for (int i = 0; i <= 100; i += 20) {
+            params.progress_callback(ctx, state, i, params.progress_callback_user_data);
+        }
+    }
+
+    if (params.new_segment_callback) {
+        params.new_segment_callback(ctx, state, 1, params.new_segment_callback_user_data);
+    }
+
+    return 0;
+}
+
 int whisper_full_with_state(whisper_context* ctx, whisper_state* state, whisper_full_params params, const float* samples, int n_samples) {
     if (!ctx || !state || !samples || n_samples <= 0) {
         return -1;
@@ -277,30 +1373,71 @@ int whisper_full_with_state(whisper_context* ctx, whisper_state* state, whisper_
     if (whisper_pcm_to_mel_with_state(ctx, state, samples, n_samples, params.n_threads) != 0) {
         return -1;
     }
+    state->n_samples = n_samples;
     
-    // Mock transcription
-    std::string transcription = simple_transcription(state->mel, params);
+    if (params.encoder_begin_callback && !params.encoder_begin_callback(ctx, state, params.encoder_begin_callback_user_data)) {
+        fprintf(stderr, "%s: encoder_begin_callback returned false - aborting\n", __func__);
+        return -3;
+    }
     
-    // Store results in state
-    state->segments.clear();
-    state->segment_t0.clear();
-    state->segment_t1.clear();
+    return whisper_decode_with_state(ctx, state, params);
+}
+
+// This build has no encoder graph, so the decoder reads the mel directly and the
+// mel is what stands in for the encoder output
+const float* whisper_get_encoder_output_from_state(whisper_state* state, size_t* n_floats) {
+    if (!state || state->n_samples <= 0) {
+        if (n_floats) *n_floats = 0;
+        return nullptr;
+    }
     
-    state->segments.push_back(transcription);
-    state->segment_t0.push_back(0);
-    state->segment_t1.push_back((int64_t(n_samples) * 1000) / WHISPER_SAMPLE_RATE);
+    if (n_floats) *n_floats = state->mel.size();
+    return state->mel.data();
+}
+
+int whisper_set_encoder_output_with_state(whisper_context* ctx, whisper_state* state, const float* data, size_t n_floats, int n_samples) {
+    if (!ctx || !state || !data || n_samples <= 0 || n_floats == 0 || n_floats % WHISPER_N_MEL != 0) {
+        return -1;
+    }
     
+    state->mel.assign(data, data + n_floats);
+    state->n_len = static_cast<int>(n_floats / WHISPER_N_MEL);
+    state->n_samples = n_samples;
     return 0;
 }
 
+int whisper_full_decode_with_state(whisper_context* ctx, whisper_state* state, whisper_full_params params) {
+    if (!ctx || !state || state->n_samples <= 0) {
+        return -1;
+    }
+    
+    return whisper_decode_with_state(ctx, state, params);
+}
+
+// Bounds-checked lookups into a result
+static const whisper_segment* whisper_segment_at(const std::vector<whisper_segment>& result, int i_segment) {
+    if (i_segment < 0 || i_segment >= static_cast<int>(result.size())) {
+        return nullptr;
+    }
+    return &result[i_segment];
+}
+
+static const whisper_token_data* whisper_token_at(const std::vector<whisper_segment>& result, int i_segment, int i_token) {
+    const whisper_segment* segment = whisper_segment_at(result, i_segment);
+    if (!segment || i_token < 0 || i_token >= static_cast<int>(segment->tokens.size())) {
+        return nullptr;
+    }
+    return &segment->tokens[i_token];
+}
+
 int whisper_full_n_segments(whisper_context* ctx) {
     if (!ctx) return 0;
-    return static_cast<int>(ctx->result_segments.size());
+    return static_cast<int>(ctx->result_all.size());
 }
 
 int whisper_full_n_segments_from_state(whisper_state* state) {
     if (!state) return 0;
-    return static_cast<int>(state->segments.size());
+    return static_cast<int>(state->result_all.size());
 }
 
 int whisper_full_lang_id(whisper_context* ctx) {
@@ -308,57 +1445,105 @@ int whisper_full_lang_id(whisper_context* ctx) {
     return 0; // English
 }
 
+int whisper_full_lang_id_from_state(whisper_state* state) {
+    return state ? state->lang_id : 0;
+}
+
 int64_t whisper_full_get_segment_t0(whisper_context* ctx, int i_segment) {
-    if (!ctx || i_segment < 0 || i_segment >= static_cast<int>(ctx->segment_times_start.size())) {
-        return 0;
-    }
-    return ctx->segment_times_start[i_segment];
+    const whisper_segment* segment = ctx ? whisper_segment_at(ctx->result_all, i_segment) : nullptr;
+    return segment ? segment->t0 : 0;
 }
 
 int64_t whisper_full_get_segment_t1(whisper_context* ctx, int i_segment) {
-    if (!ctx || i_segment < 0 || i_segment >= static_cast<int>(ctx->segment_times_end.size())) {
-        return 0;
-    }
-    return ctx->segment_times_end[i_segment];
+    const whisper_segment* segment = ctx ? whisper_segment_at(ctx->result_all, i_segment) : nullptr;
+    return segment ? segment->t1 : 0;
+}
+
+int64_t whisper_full_get_segment_t0_from_state(whisper_state* state, int i_segment) {
+    const whisper_segment* segment = state ? whisper_segment_at(state->result_all, i_segment) : nullptr;
+    return segment ? segment->t0 : 0;
+}
+
+int64_t whisper_full_get_segment_t1_from_state(whisper_state* state, int i_segment) {
+    const whisper_segment* segment = state ? whisper_segment_at(state->result_all, i_segment) : nullptr;
+    return segment ? segment->t1 : 0;
 }
 
 const char* whisper_full_get_segment_text(whisper_context* ctx, int i_segment) {
-    if (!ctx || i_segment < 0 || i_segment >= static_cast<int>(ctx->result_segments.size())) {
-        return "";
-    }
-    return ctx->result_segments[i_segment].c_str();
+    const whisper_segment* segment = ctx ? whisper_segment_at(ctx->result_all, i_segment) : nullptr;
+    return segment ? segment->text.c_str() : "";
 }
 
 const char* whisper_full_get_segment_text_from_state(whisper_state* state, int i_segment) {
-    if (!state || i_segment < 0 || i_segment >= static_cast<int>(state->segments.size())) {
-        return "";
-    }
-    return state->segments[i_segment].c_str();
+    const whisper_segment* segment = state ? whisper_segment_at(state->result_all, i_segment) : nullptr;
+    return segment ? segment->text.c_str() : "";
 }
 
 int whisper_full_n_tokens(whisper_context* ctx, int i_segment) {
-    (void)ctx;
-    (void)i_segment;
-    return 1; // Mock: one token per segment
+    const whisper_segment* segment = ctx ? whisper_segment_at(ctx->result_all, i_segment) : nullptr;
+    return segment ? static_cast<int>(segment->tokens.size()) : 0;
+}
+
+int whisper_full_n_tokens_from_state(whisper_state* state, int i_segment) {
+    const whisper_segment* segment = state ? whisper_segment_at(state->result_all, i_segment) : nullptr;
+    return segment ? static_cast<int>(segment->tokens.size()) : 0;
 }
 
 const char* whisper_full_get_token_text(whisper_context* ctx, int i_segment, int i_token) {
-    (void)i_token;
-    return whisper_full_get_segment_text(ctx, i_segment);
+    const whisper_segment* segment = ctx ? whisper_segment_at(ctx->result_all, i_segment) : nullptr;
+    if (!segment || i_token < 0 || i_token >= static_cast<int>(segment->token_text.size())) {
+        return "";
+    }
+    return segment->token_text[i_token].c_str();
 }
 
-whisper_token whisper_full_get_token_id(whisper_context* ctx, int i_segment, int i_token) {
+const char* whisper_full_get_token_text_from_state(whisper_context* ctx, whisper_state* state, int i_segment, int i_token) {
     (void)ctx;
-    (void)i_segment;
-    (void)i_token;
-    return 1000; // Mock token ID
+    const whisper_segment* segment = state ? whisper_segment_at(state->result_all, i_segment) : nullptr;
+    if (!segment || i_token < 0 || i_token >= static_cast<int>(segment->token_text.size())) {
+        return "";
+    }
+    return segment->token_text[i_token].c_str();
+}
+
+whisper_token whisper_full_get_token_id(whisper_context* ctx, int i_segment, int i_token) {
+    const whisper_token_data* token = ctx ? whisper_token_at(ctx->result_all, i_segment, i_token) : nullptr;
+    return token ? token->id : -1;
+}
+
+whisper_token whisper_full_get_token_id_from_state(whisper_state* state, int i_segment, int i_token) {
+    const whisper_token_data* token = state ? whisper_token_at(state->result_all, i_segment, i_token) : nullptr;
+    return token ? token->id : -1;
+}
+
+whisper_token_data whisper_full_get_token_data(whisper_context* ctx, int i_segment, int i_token) {
+    const whisper_token_data* token = ctx ? whisper_token_at(ctx->result_all, i_segment, i_token) : nullptr;
+    return token ? *token : whisper_token_data{};
+}
+
+whisper_token_data whisper_full_get_token_data_from_state(whisper_state* state, int i_segment, int i_token) {
+    const whisper_token_data* token = state ? whisper_token_at(state->result_all, i_segment, i_token) : nullptr;
+    return token ? *token : whisper_token_data{};
 }
 
 float whisper_full_get_token_p(whisper_context* ctx, int i_segment, int i_token) {
-    (void)ctx;
-    (void)i_segment;
-    (void)i_token;
-    return 0.9f; // Mock probability
+    const whisper_token_data* token = ctx ? whisper_token_at(ctx->result_all, i_segment, i_token) : nullptr;
+    return token ? token->p : 0.0f;
+}
+
+float whisper_full_get_token_p_from_state(whisper_state* state, int i_segment, int i_token) {
+    const whisper_token_data* token = state ? whisper_token_at(state->result_all, i_segment, i_token) : nullptr;
+    return token ? token->p : 0.0f;
+}
+
+float whisper_full_get_segment_acoustic_confidence(whisper_context* ctx, int i_segment) {
+    const whisper_segment* segment = ctx ? whisper_segment_at(ctx->result_all, i_segment) : nullptr;
+    return segment ? segment->acoustic_confidence : 0.0f;
+}
+
+float whisper_full_get_segment_acoustic_confidence_from_state(whisper_state* state, int i_segment) {
+    const whisper_segment* segment = state ? whisper_segment_at(state->result_all, i_segment) : nullptr;
+    return segment ? segment->acoustic_confidence : 0.0f;
 }
 
 whisper_full_params whisper_full_default_params(enum whisper_sampling_strategy strategy) {
@@ -530,10 +1715,23 @@ int whisper_model_type(whisper_context* ctx) {
     return ctx ? ctx->model_type : 0;
 }
 
+ggml_tensor* whisper_model_get_tensor(whisper_context* ctx, const char* name) {
+    if (!ctx || !name) {
+        return nullptr;
+    }
+    const auto it = ctx->model.tensors.find(name);
+    return it == ctx->model.tensors.end() ? nullptr : it->second;
+}
+
+whisper_memory_usage whisper_get_memory_usage(whisper_context* ctx) {
+    return ctx ? ctx->memory : whisper_memory_usage{};
+}
+
 const char* whisper_token_to_str(whisper_context* ctx, whisper_token token) {
-    (void)ctx;
-    (void)token;
-    return "<token>"; // Mock implementation
+    if (!ctx || token < 0 || token >= static_cast<int>(ctx->model.id_to_token.size())) {
+        return "";
+    }
+    return ctx->model.id_to_token[token].c_str();
 }
 
 whisper_token whisper_token_eot(whisper_context* ctx) {
@@ -549,7 +1747,11 @@ whisper_token whisper_token_prev(whisper_context* ctx) {
 }
 
 whisper_token whisper_token_solm(whisper_context* ctx) {
-    return ctx ? ctx->token_solm : 50361;
+    return ctx ? ctx->token_solm : 50359;
+}
+
+whisper_token whisper_token_nosp(whisper_context* ctx) {
+    return ctx ? ctx->token_nosp : 50361;
 }
 
 whisper_token whisper_token_not(whisper_context* ctx) {
@@ -569,8 +1771,7 @@ whisper_token whisper_token_transcribe(whisper_context* ctx) {
 }
 
 whisper_token whisper_token_lang(whisper_context* ctx, int lang_id) {
-    (void)ctx;
-    return 50259 + lang_id; // Mock language tokens
+    return (ctx ? ctx->token_sot : 50258) + 1 + lang_id;
 }
 
 void whisper_print_timings(whisper_context* ctx) {
@@ -588,6 +1789,308 @@ const char* whisper_print_system_info() {
     return "Whisper.cpp Mock Implementation";
 }
 
+int whisper_bench_ggml_mul_mat(int n_threads) {
+    fputs(whisper_bench_ggml_mul_mat_str(n_threads), stderr);
+    return 0;
+}
+
+const char* whisper_bench_ggml_mul_mat_str(int n_threads) {
+    static std::string s;
+    s = "";
+    char strbuf[256];
+
+    n_threads = std::max(1, n_threads);
+
+    // encoder shapes: [n_state x n_state] weights times [n_state x n_audio_ctx] activations
+    const int n_ctx = 1500;
+    const int sizes[] = { 512, 768, 1024, 1280 };
+    const ggml_type types[] = { GGML_TYPE_F32, GGML_TYPE_F16, GGML_TYPE_Q8_0, GGML_TYPE_Q5_0, GGML_TYPE_Q4_0 };
+
+    // one backend for all runs: its worker threads persist across graph computations
+    ggml_backend_t backend = ggml_backend_cpu_init();
+    if (!backend) {
+        s = "mul_mat: failed to initialize the CPU backend\n";
+        return s.c_str();
+    }
+    ggml_backend_cpu_set_n_threads(backend, n_threads);
+
+    double sum = 0.0;
+
+    for (int n_state : sizes) {
+        for (ggml_type type : types) {
+            const size_t mem_size = ggml_row_size(type, n_state) * n_state +
+                                    2 * size_t(n_state) * n_ctx * sizeof(float) + ggml_graph_overhead() + 1024 * 1024;
+
+            struct ggml_init_params gparams = { mem_size, nullptr, false };
+            ggml_context * ctx0 = ggml_init(gparams);
+            if (!ctx0) {
+                snprintf(strbuf, sizeof(strbuf), "mul_mat: failed to allocate %zu bytes\n", mem_size);
+                s += strbuf;
+                continue;
+            }
+
+            ggml_tensor * a = ggml_new_tensor_2d(ctx0, type,          n_state, n_state);
+            ggml_tensor * b = ggml_new_tensor_2d(ctx0, GGML_TYPE_F32, n_state, n_ctx);
+            ggml_tensor * c = ggml_mul_mat(ctx0, a, b);
+
+            ggml_cgraph * gf = ggml_new_graph(ctx0);
+            ggml_build_forward_expand(gf, c);
+
+            std::vector<float> weights(size_t(n_state) * n_state);
+            for (float & v : weights) {
+                v = rand() / float(RAND_MAX) - 0.5f;
+            }
+            ggml_quantize_chunk(type, weights.data(), a->data, 0, int(weights.size()), nullptr);
+            for (int64_t i = 0; i < int64_t(n_state) * n_ctx; ++i) {
+                ((float *) b->data)[i] = rand() / float(RAND_MAX) - 0.5f;
+            }
+
+            const double flops = 2.0 * n_state * n_state * n_ctx;
+            const int n_runs = 3;
+
+            // warm-up
+            ggml_backend_graph_compute(backend, gf);
+
+            double tmin = 1e30;
+            double tsum = 0.0;
+            for (int run = 0; run < n_runs; ++run) {
+                const auto t0 = std::chrono::high_resolution_clock::now();
+                ggml_backend_graph_compute(backend, gf);
+                const auto t1 = std::chrono::high_resolution_clock::now();
+
+                const double t = std::chrono::duration<double>(t1 - t0).count();
+                tmin = std::min(tmin, t);
+                tsum += t;
+            }
+
+            sum += ((float *) c->data)[0];
+
+            snprintf(strbuf, sizeof(strbuf), "%4d x %4d: %-4s %8.1f GFLOPS (%3d runs) | best %8.3f ms | avg %8.3f ms\n",
+                     n_state, n_ctx, ggml_type_name(type), 1e-9 * flops / tmin, n_runs, 1000.0 * tmin, 1000.0 * tsum / n_runs);
+            s += strbuf;
+
+            ggml_free(ctx0);
+        }
+    }
+
+    ggml_backend_free(backend);
+
+    // needed to prevent the compiler from optimizing the calls away
+    snprintf(strbuf, sizeof(strbuf), "sum: %f\n", sum);
+    s += strbuf;
+
+    return s.c_str();
+}
+
+int whisper_bench_pcm_to_mel(int n_threads) {
+    fputs(whisper_bench_pcm_to_mel_str(n_threads), stderr);
+    return 0;
+}
+
+const char* whisper_bench_pcm_to_mel_str(int n_threads) {
+    static std::string s;
+    s = "";
+    char strbuf[256];
+
+    whisper_mel_tables tables;
+    whisper_mel_tables_init(tables, WHISPER_N_MEL);
+
+    // 10 minutes of a swept tone with a little noise
+    const int n_samples = 10 * 60 * WHISPER_SAMPLE_RATE;
+    std::vector<float> pcm(n_samples);
+    for (int i = 0; i < n_samples; i++) {
+        const double t = static_cast<double>(i) / WHISPER_SAMPLE_RATE;
+        pcm[i] = 0.5f * static_cast<float>(std::sin(2.0 * M_PI * (200.0 + 10.0 * std::fmod(t, 60.0)) * t)) +
+                 0.01f * (rand() / float(RAND_MAX) - 0.5f);
+    }
+
+    const int n_len = (n_samples / WHISPER_HOP_LENGTH) + 1;
+
+    std::vector<int> thread_counts;
+    for (int nt = 1; nt < n_threads; nt *= 2) {
+        thread_counts.push_back(nt);
+    }
+    thread_counts.push_back(std::max(1, n_threads));
+
+    double tsum = 0.0;
+    for (int nt : thread_counts) {
+        double tmin = 1e30;
+        for (int run = 0; run < 3; run++) {
+            const auto t0 = std::chrono::high_resolution_clock::now();
+            const auto mel = log_mel_spectrogram(tables, pcm.data(), n_samples, nt);
+            const auto t1 = std::chrono::high_resolution_clock::now();
+
+            tsum += mel[0];
+            tmin = std::min(tmin, std::chrono::duration<double>(t1 - t0).count());
+        }
+
+        snprintf(strbuf, sizeof(strbuf), "pcm_to_mel: %d frames, %2d threads: %8.3f ms, %10.1f frames/s\n",
+                 n_len, nt, 1000.0 * tmin, n_len / tmin);
+        s += strbuf;
+    }
+
+    // needed to prevent the compiler from optimizing the calls away
+    snprintf(strbuf, sizeof(strbuf), "sum: %f\n", tsum);
+    s += strbuf;
+
+    return s.c_str();
+}
+
+int whisper_bench_model_load(const char* path_model) {
+    fputs(whisper_bench_model_load_str(path_model), stderr);
+    return 0;
+}
+
+const char* whisper_bench_model_load_str(const char* path_model) {
+    static std::string s;
+    s = "";
+    char strbuf[256];
+
+    std::string path = path_model ? path_model : "";
+    const bool generated = path.empty();
+    if (generated) {
+        path = (std::filesystem::temp_directory_path() / "whisper-bench-model.bin").string();
+        if (!whisper_model_write_synthetic(path.c_str(), 512, 6)) {
+            s = "model_load: failed to write " + path + "\n";
+            return s.c_str();
+        }
+    }
+
+    uint64_t sum = 0;
+    for (const bool use_mmap : { true, false }) {
+        double t_init  = 1e30;
+        double t_touch = 1e30;
+        size_t n_bytes = 0;
+
+        for (int run = 0; run < 3; run++) {
+            whisper_context_params params = whisper_context_default_params();
+            params.use_mmap = use_mmap;
+
+            const auto t0 = std::chrono::high_resolution_clock::now();
+            whisper_context * ctx = whisper_init_from_file_with_params(path.c_str(), params);
+            const auto t1 = std::chrono::high_resolution_clock::now();
+            if (!ctx) {
+                s += "model_load: failed to load " + path + "\n";
+                return s.c_str();
+            }
+
+            // read one byte per page of every weight, as the first forward pass would
+            for (const auto & it : ctx->model.tensors) {
+                const ggml_tensor * t = it.second;
+                const uint8_t * data = static_cast<const uint8_t *>(t->data);
+                const size_t nb = ggml_row_size(t->type, t->ne[0]) * t->ne[1] * t->ne[2] * t->ne[3];
+                for (size_t offs = 0; offs < nb; offs += 4096) {
+                    sum += data[offs];
+                }
+            }
+            const auto t2 = std::chrono::high_resolution_clock::now();
+
+            n_bytes = ctx->model.n_bytes;
+            whisper_free(ctx);
+
+            t_init  = std::min(t_init,  std::chrono::duration<double>(t1 - t0).count());
+            t_touch = std::min(t_touch, std::chrono::duration<double>(t2 - t0).count());
+        }
+
+        snprintf(strbuf, sizeof(strbuf), "model_load: %-5s %8.1f MB: init %9.3f ms, init + touch all weights %9.3f ms\n",
+                 use_mmap ? "mmap" : "read", n_bytes / 1024.0 / 1024.0, 1000.0 * t_init, 1000.0 * t_touch);
+        s += strbuf;
+    }
+
+    // best of 3 runs, so the file is in the page cache: these are warm-start numbers
+    snprintf(strbuf, sizeof(strbuf), "sum: %llu\n", static_cast<unsigned long long>(sum));
+    s += strbuf;
+
+    if (generated) {
+        std::remove(path.c_str());
+    }
+
+    return s.c_str();
+}
+
+int whisper_bench_kv_cache(void) {
+    fputs(whisper_bench_kv_cache_str(), stderr);
+    return 0;
+}
+
+const char* whisper_bench_kv_cache_str(void) {
+    static std::string s;
+    s = "";
+    char strbuf[256];
+
+    // one sequence over the full text context of the base model
+    const int n_layer = 6;
+    const int n_state = 512;
+    const int n_head  = 8;
+    const int n_pos   = 448;
+    const int n_query = 16;
+
+    auto random_rows = [](size_t n) {
+        std::vector<float> rows(n);
+        for (float & x : rows) {
+            x = 2.0f * (rand() / float(RAND_MAX) - 0.5f);
+        }
+        return rows;
+    };
+    const std::vector<float> k = random_rows((size_t) n_layer * n_pos * n_state);
+    const std::vector<float> v = random_rows((size_t) n_layer * n_pos * n_state);
+    const std::vector<float> q = random_rows((size_t) n_query * n_state);
+
+    std::vector<float> ref((size_t) n_layer * n_query * n_state);
+    std::vector<float> out(ref.size());
+
+    double sum = 0.0;
+    for (const ggml_type type : { GGML_TYPE_F32, GGML_TYPE_F16, GGML_TYPE_Q8_0 }) {
+        whisper_kv_pages kv(n_layer, n_state, 16, type);
+        const int seq = kv.seq_new();
+        for (int pos = 0; pos < n_pos; pos++) {
+            kv.seq_push(seq);
+            for (int il = 0; il < n_layer; il++) {
+                const size_t offs = ((size_t) il * n_pos + pos) * n_state;
+                kv.set(seq, il, pos, k.data() + offs, v.data() + offs);
+            }
+        }
+
+        double tmin = 1e30;
+        for (int run = 0; run < 3; run++) {
+            const auto t0 = std::chrono::high_resolution_clock::now();
+            for (int il = 0; il < n_layer; il++) {
+                for (int iq = 0; iq < n_query; iq++) {
+                    kv.attend(seq, il, q.data() + (size_t) iq * n_state, n_head, out.data() + ((size_t) il * n_query + iq) * n_state);
+                }
+            }
+            const auto t1 = std::chrono::high_resolution_clock::now();
+            tmin = std::min(tmin, std::chrono::duration<double>(t1 - t0).count());
+        }
+
+        if (type == GGML_TYPE_F32) {
+            ref = out;
+        }
+
+        // worst relative error of one attention output against the F32 cache
+        double err_max = 0.0;
+        for (size_t i = 0; i < out.size(); i += n_state) {
+            double err = 0.0, norm = 0.0;
+            for (int j = 0; j < n_state; j++) {
+                err  += (out[i + j] - ref[i + j]) * (out[i + j] - ref[i + j]);
+                norm += ref[i + j] * ref[i + j];
+            }
+            err_max = std::max(err_max, std::sqrt(err / std::max(norm, 1e-30)));
+            sum += out[i];
+        }
+
+        snprintf(strbuf, sizeof(strbuf), "kv_cache: %-4s %7.2f MB per sequence, %8.3f us per token and layer, max rel. error %.2e\n",
+                 ggml_type_name(kv.type), kv.n_bytes() / 1024.0 / 1024.0, 1e6 * tmin / (n_layer * n_query), err_max);
+        s += strbuf;
+    }
+
+    // needed to prevent the compiler from optimizing the calls away
+    snprintf(strbuf, sizeof(strbuf), "sum: %f\n", sum);
+    s += strbuf;
+
+    return s.c_str();
+}
+
 whisper_state* whisper_init_state(whisper_context* ctx) {
     if (!ctx) return nullptr;
     
@@ -5,6 +5,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "ggml.h"
+
 #ifdef WHISPER_SHARED
 #    ifdef _WIN32
 #        ifdef WHISPER_BUILD
@@ -88,6 +90,11 @@ extern "C" {
     // Various functions for loading a ggml whisper model.
     // Allocate (almost) all memory needed for the model.
     // Return NULL on failure
+    //
+    // With use_mmap (the default) the file is mapped read-only and tensor data points into
+    // the mapping, so weights are paged in on first use and shared between processes.
+    // whisper_init_from_buffer* uses the buffer in place as well: it must stay valid and
+    // unmodified until whisper_free().
     WHISPER_API struct whisper_context * whisper_init_from_file(const char * path_model);
     WHISPER_API struct whisper_context * whisper_init_from_buffer(void * buffer, size_t buffer_size);
     WHISPER_API struct whisper_context * whisper_init_with_params(const char * path_model, struct whisper_context_params params);
@@ -170,6 +177,25 @@ extern "C" {
                       const float * samples,
                               int   n_samples);
 
+    // Encoder output of the last whisper_full_with_state() call on the state, n_floats floats.
+    // Hand a copy back with whisper_set_encoder_output_with_state() to decode the same audio
+    // again, e.g. with another language or temperature, without the mel and encoder passes.
+    WHISPER_API const float * whisper_get_encoder_output_from_state(struct whisper_state * state, size_t * n_floats);
+
+    // n_samples is the length of the audio the encoder output was computed from
+    WHISPER_API int whisper_set_encoder_output_with_state(
+                struct whisper_context * ctx,
+                  struct whisper_state * state,
+                      const float * data,
+                           size_t   n_floats,
+                              int   n_samples);
+
+    // Like whisper_full_with_state(), but decodes the encoder output already in the state
+    WHISPER_API int whisper_full_decode_with_state(
+                struct whisper_context * ctx,
+                  struct whisper_state * state,
+            struct whisper_full_params   params);
+
     // Split the input audio in chunks and process each chunk separately using whisper_full_with_state()
     // Result is stored in the default state of the context
     // Not thread safe if executed in parallel on the same context.
@@ -226,6 +252,12 @@ extern "C" {
     WHISPER_API float whisper_full_get_token_p           (struct whisper_context * ctx, int i_segment, int i_token);
     WHISPER_API float whisper_full_get_token_p_from_state(struct whisper_state * state, int i_segment, int i_token);
 
+    // Get the acoustic confidence of the specified segment, in [0, 1].
+    // A heuristic from the spectral flatness of the segment's speech frames, not a
+    // decoder probability: tonal and voiced audio scores near 1, noise low.
+    WHISPER_API float whisper_full_get_segment_acoustic_confidence           (struct whisper_context * ctx, int i_segment);
+    WHISPER_API float whisper_full_get_segment_acoustic_confidence_from_state(struct whisper_state * state, int i_segment);
+
     ////////////////////////////////////////////////////////////////////////////
 
     // Temporary helpers needed for exposing ggml interface
@@ -233,6 +265,18 @@ extern "C" {
     WHISPER_API const char * whisper_bench_memcpy_str     (int n_threads);
     WHISPER_API int whisper_bench_ggml_mul_mat(int n_threads);
     WHISPER_API const char * whisper_bench_ggml_mul_mat_str(int n_threads);
+    WHISPER_API int whisper_bench_pcm_to_mel (int n_threads);
+    WHISPER_API const char * whisper_bench_pcm_to_mel_str (int n_threads);
+
+    // Startup cost of mmap vs buffered model loading; path_model = NULL benchmarks a
+    // generated file the size of the base model
+    WHISPER_API int whisper_bench_model_load (const char * path_model);
+    WHISPER_API const char * whisper_bench_model_load_str (const char * path_model);
+
+    // Size, attention speed and error of the decoder K/V cache in F32, F16 and Q8_0,
+    // for one sequence over the text context of the base model
+    WHISPER_API int whisper_bench_kv_cache (void);
+    WHISPER_API const char * whisper_bench_kv_cache_str (void);
 
     // Control logging output; default behavior is to print to stderr
     typedef void (*whisper_log_callback)(enum ggml_log_level level, const char * text, void * user_data);
@@ -352,7 +396,7 @@ extern "C" {
         float temperature_inc;
         float entropy_thold;    // similar to OpenAI's "compression_ratio_threshold"
         float logprob_thold;
-        float no_speech_thold;  // TODO: not implemented
+        float no_speech_thold;  // audio with a higher no-speech probability is not decoded
 
         struct {
             int best_of;        // ref: https://github.com/openai/whisper/blob/f82bc59f5ea234d4b97fb2860842ed38519f7e65/whisper/transcribe.py#L264
@@ -380,20 +424,28 @@ extern "C" {
         void * logits_filter_callback_user_data;
     };
 
-    WHISPER_API struct whisper_context_params {
+    enum whisper_alignment_heads_preset {
+        WHISPER_AHEADS_NONE,
+        WHISPER_AHEADS_N_TOP_MOST, // All heads from the top-most n_text_layer layers
+        // TODO: Add more presets for specific datasets.
+    };
+
+    struct whisper_context_params {
         bool use_gpu;    // attempt to use GPU
         int  gpu_device; // device to use for GPU compute (CUDA, OpenCL, etc.)
 
         // [EXPERIMENTAL] Token-level timestamps with DTW
         bool dtw_token_timestamps;
-        enum whisper_alignment_heads_preset {
-            WHISPER_AHEADS_NONE,
-            WHISPER_AHEADS_N_TOP_MOST, // All heads from the top-most n_text_layer layers
-            // TODO: Add more presets for specific datasets.
-        } dtw_aheads_preset;
+        enum whisper_alignment_heads_preset dtw_aheads_preset;
         int dtw_n_top; // number of top scoring alignment heads to average (only used when preset is WHISPER_AHEADS_N_TOP_MOST)
         const char * dtw_aheads_path; // path to a file containing the alignment head indices (overrides preset)
         size_t dtw_mem_size; // [EXPERIMENTAL] maximum size in bytes for the cross-attention heads alignment memory pool (0 = default)
+
+        bool use_mmap; // map the model file instead of reading it into memory
+
+        // Storage of the decoder K/V cache: GGML_TYPE_F32, GGML_TYPE_F16 or GGML_TYPE_Q8_0.
+        // F16 halves the cache, Q8_0 stores about a quarter of it.
+        enum ggml_type type_kv;
     };
 
     // NOTE: this function allocates memory, and it is the responsibility of the caller to free the pointer - see whisper_free_context_params & whisper_free_params()
@@ -455,6 +507,23 @@ extern "C" {
     WHISPER_API int whisper_model_ftype        (struct whisper_context * ctx);
     WHISPER_API int whisper_model_type         (struct whisper_context * ctx);
 
+    // Model weight by its name in the model file, NULL if there is none.
+    // The data is read-only and may point into the mapped file or the init buffer.
+    WHISPER_API struct ggml_tensor * whisper_model_get_tensor(struct whisper_context * ctx, const char * name);
+
+    // Memory of a context in bytes. The weights are shared by all states of the
+    // context; every state needs the rest for itself.
+    struct whisper_memory_usage {
+        size_t weights;         // tensor data of the model
+        size_t kv_self;         // decoder self-attention K/V of one sequence over n_text_ctx positions, in type_kv
+        size_t kv_cross;        // cross-attention K/V over the encoder output, in type_kv
+        size_t mel;             // log-mel input of one 30 s window
+        size_t compute_encoder; // peak compute buffer of the encoder, measured with ggml-alloc
+        size_t compute_decoder; // peak compute buffer of a decoder step over the longest prompt
+    };
+
+    WHISPER_API struct whisper_memory_usage whisper_get_memory_usage(struct whisper_context * ctx);
+
     // Token logits obtained from the last call to whisper_decode()
     // The logits for the last token are stored in the last row
     // Rows: n_tokens